@@ -0,0 +1,313 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		Event.c
+* @brief	Run to completion event loop with priority queues.
+* @date		19.10.2026
+* @version	0.3
+*
+* @details
+* Queue of each priority is a ring buffer. Posting and taking an event is done with
+* interrupts disabled, because events are posted from main loop and interrupts.
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "Event.h"
+#include "samd21.h"
+#include "system_interrupt.h"
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Queue of one priority */
+typedef struct
+{
+	event_t buf[EVENT_QUEUE_LEN];	/**< Events */
+	uint8_t head;					/**< Index of the oldest event */
+	uint8_t count;					/**< Number of events */
+	uint32_t dropped;				/**< Events dropped, because queue was full */
+}event_queue_t;
+
+/** @brief Ring buffer, which items are handled in main loop */
+typedef struct
+{
+	const ringBuf_t *rb;			/**< Ring buffer */
+	eventHandler_t handler;			/**< Function, that takes items from ring buffer */
+	void *ctx;						/**< Context given to handler */
+}event_watch_t;
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+/** @brief Queues, index is priority */
+static event_queue_t eventQueue[EVENT_PRIO_NBR];
+/** @brief Watched ring buffers */
+static event_watch_t eventWatched[EVENT_WATCH_NBR];
+/** @brief Number of watched ring buffers */
+static uint8_t eventWatchCnt;
+/** @brief Called when all queues are empty, before sleep */
+static void (*eventPoll) (void);
+/** @brief Sleeps until an interrupt, called with interrupts disabled */
+static void (*eventSleep) (void);
+/** @brief Tells, if poll function has work, called with interrupts disabled */
+static uint32_t (*eventPending) (void);
+
+
+/**
+* @brief     Default sleep, CPU sleeps in IDLE until an interrupt
+*
+* Pending interrupt wakes CPU also with interrupts disabled.
+*
+*/
+static void event_wfi (void)
+{
+	__DSB();
+	__WFI();
+}
+
+/**
+* @brief     Initializes event loop, all queues are emptied
+*
+*/
+void eventInit (void)
+{
+	uint8_t prio;
+	
+	system_interrupt_enter_critical_section();
+	for(prio = 0; prio < EVENT_PRIO_NBR; prio++)
+	{
+		eventQueue[prio].head = 0;
+		eventQueue[prio].count = 0;
+		eventQueue[prio].dropped = 0;
+	}
+	eventWatchCnt = 0;
+	eventPoll = 0;
+	eventSleep = event_wfi;
+	eventPending = 0;
+	system_interrupt_leave_critical_section();
+}
+
+/**
+* @brief     Posts event, can be called from interrupt
+* @param     prio Priority, 0 is the highest
+* @param     handler Function, that handles event
+* @param     ctx Context given to handler
+* @param     arg Argument given to handler
+* @return    0 on error or if queue is full, 1 on success
+*/
+uint32_t eventPost (uint8_t prio, eventHandler_t handler, void *ctx, uint32_t arg)
+{
+	event_queue_t *queue;
+	event_t *event;
+	
+	if((prio >= EVENT_PRIO_NBR) || !handler)
+	{
+		return 0;
+	}
+	queue = &eventQueue[prio];
+	system_interrupt_enter_critical_section();
+	if(queue->count == EVENT_QUEUE_LEN)
+	{
+		queue->dropped++;
+		system_interrupt_leave_critical_section();
+		return 0;
+	}
+	event = &queue->buf[(queue->head + queue->count) % EVENT_QUEUE_LEN];
+	event->handler = handler;
+	event->ctx = ctx;
+	event->arg = arg;
+	queue->count++;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Handles the oldest event of the highest priority
+* @return    1 if an event has been handled, 0 if all queues are empty
+*/
+uint32_t eventRunOnce (void)
+{
+	event_queue_t *queue;
+	event_t event;
+	uint8_t prio;
+	
+	system_interrupt_enter_critical_section();
+	for(prio = 0; prio < EVENT_PRIO_NBR; prio++)
+	{
+		queue = &eventQueue[prio];
+		if(queue->count)
+		{
+			event = queue->buf[queue->head];
+			queue->head = (queue->head + 1) % EVENT_QUEUE_LEN;
+			queue->count--;
+			system_interrupt_leave_critical_section();
+			event.handler(event.ctx, event.arg);
+			return 1;
+		}
+	}
+	system_interrupt_leave_critical_section();
+	return 0;
+}
+
+/**
+* @brief     Calls handlers of watched ring buffers, which are not empty
+* @return    1 if a handler has been called, 0 if all ring buffers are empty
+*/
+static uint32_t event_run_watched (void)
+{
+	uint32_t count;
+	uint32_t ran = 0;
+	uint8_t n;
+	
+	for(n = 0; n < eventWatchCnt; n++)
+	{
+		count = ringBufCount(eventWatched[n].rb);
+		if(count)
+		{
+			eventWatched[n].handler(eventWatched[n].ctx, count);
+			ran = 1;
+		}
+	}
+	return ran;
+}
+
+/**
+* @brief     Handles events forever, sleeps when there are none
+*
+*/
+void eventRun (void)
+{
+	uint8_t prio, n;
+	uint8_t idle;
+	
+	while(1)
+	{
+		while(eventRunOnce()) {}
+		if(event_run_watched())
+		{
+			continue;
+		}
+		if(eventPoll)
+		{
+			eventPoll();
+		}
+		
+		system_interrupt_enter_critical_section();
+		idle = 1;
+		for(prio = 0; prio < EVENT_PRIO_NBR; prio++)
+		{
+			if(eventQueue[prio].count)
+			{
+				idle = 0;
+			}
+		}
+		for(n = 0; n < eventWatchCnt; n++)
+		{
+			if(ringBufCount(eventWatched[n].rb))
+			{
+				idle = 0;
+			}
+		}
+		if(eventPending && eventPending())
+		{
+			idle = 0;
+		}
+		/* Interrupt, that posts an event now, wakes CPU up, it runs after leaving critical section */
+		if(idle && eventSleep)
+		{
+			eventSleep();
+		}
+		system_interrupt_leave_critical_section();
+	}
+}
+
+/**
+* @brief     Sets function, which is called every time all queues are empty
+* @param     poll Function, or NULL
+*/
+void eventSetPoll (void (*poll)(void))
+{
+	eventPoll = poll;
+}
+
+/**
+* @brief     Sets function, which sleeps until an interrupt
+*
+* Function is called with interrupts disabled and must return, when an interrupt
+* is pending.
+*
+* @param     sleep Function, or NULL to not sleep
+*/
+void eventSetSleep (void (*sleep)(void))
+{
+	eventSleep = sleep;
+}
+
+/**
+* @brief     Sets function, which tells that poll function has work
+*
+* Function is called with interrupts disabled before sleep. If it returns 1, main
+* loop does not sleep and calls poll function again. Use it for work, that an
+* interrupt leaves to poll function without posting an event.
+*
+* @param     pending Function, or NULL
+*/
+void eventSetPending (uint32_t (*pending)(void))
+{
+	eventPending = pending;
+}
+
+/**
+* @brief     Returns number of events, which have been dropped
+* @param     prio Priority
+* @return    Number of dropped events
+*/
+uint32_t eventDropped (uint8_t prio)
+{
+	if(prio >= EVENT_PRIO_NBR)
+	{
+		return 0;
+	}
+	return eventQueue[prio].dropped;
+}
+
+/**
+* @brief     Registers ring buffer, which items are taken in main loop
+*
+* Handler gets number of items as argument and should take all of them. It is
+* called again, while ring buffer is not empty.
+*
+* @param     rb Ring buffer, main loop is its consumer
+* @param     handler Function, that takes items
+* @param     ctx Context given to handler
+* @return    0 on error, 1 on success
+*/
+uint32_t eventWatch (const ringBuf_t *rb, eventHandler_t handler, void *ctx)
+{
+	if(!rb || !handler || (eventWatchCnt >= EVENT_WATCH_NBR))
+	{
+		return 0;
+	}
+	eventWatched[eventWatchCnt].rb = rb;
+	eventWatched[eventWatchCnt].handler = handler;
+	eventWatched[eventWatchCnt].ctx = ctx;
+	eventWatchCnt++;
+	return 1;
+}
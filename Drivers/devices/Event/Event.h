@@ -0,0 +1,94 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		Event.h
+* @brief	Run to completion event loop with priority queues.
+* @date		19.10.2026
+* @version	0.3
+*
+* @details
+* Work is done in handlers of events. Event is a handler with a context pointer and
+* a 32 bit argument, it is posted with eventPost from main loop or from any
+* interrupt and handled later by eventRun in main loop. Each handler runs to
+* completion, it is never interrupted by another handler, so handlers share data
+* without locking.
+*
+* There are EVENT_PRIO_NBR priorities, each with a queue of EVENT_QUEUE_LEN events.
+* eventRun always handles the oldest event of the highest priority (0) first. Event
+* posted to a full queue is dropped and counted.
+*
+* When all queues are empty, eventRun calls poll function (e.g. stimerDispatch) and
+* sleeps until an interrupt. Queues are checked and sleep is entered with interrupts
+* disabled, so event posted by an interrupt just before sleep is not missed. Sleep
+* function can be replaced by eventSetSleep, e.g. with stimerSleep to use STANDBY.
+* Work, that an interrupt leaves to poll function without posting an event, is
+* reported by pending function set with eventSetPending (e.g. stimerDispatchPending),
+* main loop does not sleep while it returns 1.
+*
+* eventPost disables interrupts for a short time, so any number of interrupts can
+* post. Data, that an interrupt passes to main loop, can also go through a ring
+* buffer (RingBuf.h) registered with eventWatch. Its handler is called from
+* eventRun while ring buffer is not empty, and main loop does not sleep then.
+*/
+
+#ifndef EVENT_H_
+#define EVENT_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "RingBuf.h"
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Number of priorities, 0 is the highest */
+#define EVENT_PRIO_NBR		3
+/** @brief Number of events, that can wait in queue of one priority */
+#define EVENT_QUEUE_LEN		16
+/** @brief Maximum number of watched ring buffers */
+#define EVENT_WATCH_NBR		4
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Event handler */
+typedef void (*eventHandler_t) (void *ctx, uint32_t arg);
+
+/** @brief Event */
+typedef struct
+{
+	eventHandler_t handler;		/**< Function, that handles event */
+	void *ctx;					/**< Context given to handler */
+	uint32_t arg;				/**< Argument given to handler */
+}event_t;
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void eventInit (void);
+uint32_t eventPost (uint8_t prio, eventHandler_t handler, void *ctx, uint32_t arg);
+uint32_t eventRunOnce (void);
+void eventRun (void);
+void eventSetPoll (void (*poll)(void));
+void eventSetSleep (void (*sleep)(void));
+void eventSetPending (uint32_t (*pending)(void));
+uint32_t eventDropped (uint8_t prio);
+uint32_t eventWatch (const ringBuf_t *rb, eventHandler_t handler, void *ctx);
+
+#endif /* EVENT_H_ */
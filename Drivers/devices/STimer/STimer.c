@@ -14,7 +14,7 @@
 /**
 * @file		STimer.c
 * @date		22.10.2019
-* @version	0.1
+* @version	0.9
 * @brief	Software emulated timer
 *
 * @details
@@ -39,19 +39,921 @@
 * 3. If mode is set to timer, set expiry time and auto reload
 * 4. If you want, set callback function
 * 5. Start the timer
+*
+* Running count down timers are kept in a hierarchical timer wheel. It has
+* STIMER_WHEEL_LEVELS levels of STIMER_WHEEL_SLOTS slots, each slot of a level
+* covers a whole turn of the level below. Timer is placed in the lowest level, that
+* reaches its expiry, so start and stop only link or unlink it. When wheel turns
+* to a new slot of level 0, timers of the matching upper slots are moved down
+* (cascaded) and all timers in the slot expire. Timers too far for the top level
+* are cascaded again, until they are in reach.
+*
+* Only interrupt moves the wheel. API takes current time from TC3 counter, so it
+* does not change the wheel. In tickless mode compare of TC3 is set to the next
+* non empty slot of level 0 or the next cascade, or STIMER_SHOT_MAX ms ahead, so
+* that the counter can not wrap unnoticed. Auto reload timers are placed again
+* relative to their expiry, so they do not drift.
+*
+* Microsecond clock uses TC4 and TC5 chained to a 32 bit counter, clocked from
+* GCLK2 (4 MHz) with prescaler 4. Counter is synchronized continuously, so reading
+* it does not wait for synchronization. Deadline uses compare channel 0 of TC4.
+*
+* Uptime is kept in 64 bits. TC3 interrupt extends ms time and microsecond clock
+* with upper words and increments a sequence counter, with interrupts disabled.
+* Reader takes a copy and repeats it, if sequence counter has changed meanwhile,
+* so it never waits and never disables interrupts. Wrap of microsecond clock is
+* noticed in TC3 interrupt, which comes at least every STIMER_SHOT_MAX ms.
+*
+* Auto reload timer, which expiry is served so late, that its next expiry has also
+* passed, skips the missed periods and stays on its timeline. Each missed period
+* and each expiry merged into a waiting deferred callback is an overrun. Lateness
+* is measured with TC3 counter (4 us) from the exact expiry to the call of
+* callback, so for deferred levels it includes waiting for PendSV or main loop.
+*
+* Each time base has its own wheel in ms: TC3 and RTC. RTC counts 1024 Hz from
+* OSCULP32K, its ms time is derived from 64 bit count, so 1000 ms are exactly 1024
+* RTC ticks. RTC compare is set to the next slot, that holds timers, or the next
+* cascade of an occupied upper slot, so long timers do not wake the CPU every
+* turn of level 0. Wheel jumps over time without work in one step.
+*
+* Timer is marked while its own callback runs. Count down started or set from it
+* counts from the expiry being served, not from current time, so re-arming from
+* a late deferred callback keeps the timeline. Expiry, which has already passed
+* this way, happens in the next ms.
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "STimer.h"
+#include "system_interrupt.h"
+#include <string.h>
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Bits of time, that select slot in one level */
+#define STIMER_WHEEL_BITS	6
+/** @brief Number of slots in one level */
+#define STIMER_WHEEL_SLOTS	(1 << STIMER_WHEEL_BITS)
+/** @brief Number of levels, wheel reaches 2^24 ms (4.6 h) */
+#define STIMER_WHEEL_LEVELS	4
+/** @brief Timer is not in wheel, above the last slot of the top level */
+#define STIMER_NONE			0xFFFF
+#if STIMER_TICKLESS
+/** @brief TC3 counts 4 MHz / 16 */
+#define STIMER_TICKS_PER_MS	250
+/** @brief Longest time between two TC3 interrupts in ms, 16 bit counter wraps after 262 ms */
+#define STIMER_SHOT_MAX		250
+#endif
+#if STIMER_US
+/** @brief Longest deadline in us, later deadline would look passed */
+#define STIMER_US_MAX		0x7FFFFFFFUL
+#endif
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+typedef struct stimer_s stimer_t;
+
+/** @brief Software timer */
+struct stimer_s
+{
+	stimer_t *next;						/**< Next timer in wheel slot or in free list */
+	stimer_t *prev;						/**< Previous timer in wheel slot */
+	stimer_t *pendNext;					/**< Next timer waiting for deferred callback */
+	volatile void (*function) (void);	/**< Callback */
+	void (*ctxFunction) (void *ctx);	/**< Callback with context */
+	void *ctx;							/**< Context given to ctxFunction */
+	uint32_t due;						/**< Expiry in ms of waiting or running callback */
+	uint32_t expires;					/**< Time of expiry in ms */
+	uint32_t time;						/**< Time of stopped timer or stopwatch */
+	uint32_t start;						/**< Time in ms when stopwatch was started */
+	uint32_t autoReload;				/**< Period of auto reload, 0 for single shot */
+	uint8_t running;					/**< Timer is running */
+	uint8_t stopwatch;					/**< Timer counts up and callback is disabled */
+	uint8_t level;						/**< stimerLevel_t of callback */
+	uint8_t pending;					/**< Deferred callback is waiting */
+	uint16_t slot;						/**< Level * STIMER_WHEEL_SLOTS + slot, or STIMER_NONE */
+	uint8_t gen;						/**< Generation, changes when timer is deleted */
+	uint8_t used;						/**< Timer is allocated */
+	uint8_t inCallback;					/**< Callback of timer is running */
+#if STIMER_RTC
+	uint8_t rtc;						/**< Timer runs on RTC */
+#endif
+#if STIMER_STATS
+	uint32_t statCount;					/**< Measured callbacks */
+	uint32_t overruns;					/**< Missed periods and merged callbacks */
+	uint32_t lateMin;					/**< Minimum lateness in us */
+	uint32_t lateMax;					/**< Maximum lateness in us */
+	uint64_t lateSum;					/**< Sum of lateness in us */
+#endif
+};
+
+/** @brief Timer wheel of one time base */
+typedef struct
+{
+	stimer_t *slot[STIMER_WHEEL_LEVELS * STIMER_WHEEL_SLOTS];	/**< Lists of timers in each slot */
+	uint8_t levelCnt[STIMER_WHEEL_LEVELS];	/**< Number of timers in each level */
+	uint32_t ms;							/**< Time of wheel in ms, earlier expiries have been served */
+	volatile uint32_t now;					/**< Time in ms at last interrupt, wheel is moved to it */
+	uint8_t busy;							/**< Wheel is being moved by interrupt */
+}stimer_wheel_t;
+
+/** @brief Timers waiting for deferred callback */
+typedef struct
+{
+	stimer_t *first;					/**< First waiting timer */
+	stimer_t *last;						/**< Last waiting timer */
+}stimer_pend_t;
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+/** @brief All timers, first STIMER_NBR are fixed channels */
+static stimer_t stimerPool[STIMER_POOL_NBR];
+/** @brief Free timers of pool */
+static stimer_t *stimerFree;
+/** @brief Wheel of timers on TC3 */
+static stimer_wheel_t stimerTc;
+#if STIMER_RTC
+/** @brief Wheel of timers on RTC */
+static stimer_wheel_t stimerRtc;
+/** @brief Upper word of 64 bit RTC count */
+static volatile uint32_t stimerRtcHi;
+#endif
+/** @brief Upper word of 64 bit time in ms */
+static volatile uint32_t stimerNowHi;
+/** @brief Incremented on every change of time, readers repeat when it changes */
+static volatile uint32_t stimerSeq;
+#if STIMER_US
+/** @brief Microsecond clock at last interrupt */
+static volatile uint32_t stimerUsLast;
+/** @brief Upper word of 64 bit microsecond clock */
+static volatile uint32_t stimerUsHi;
+/** @brief Time in us slept in STANDBY, while TC4 was stopped, added to its count */
+static volatile uint32_t stimerUsOffset;
+#endif
+#if STIMER_TICKLESS
+/** @brief TC3 counter value at time of last interrupt */
+static uint16_t stimerLastCnt;
+#endif
+/** @brief Timers, which callbacks wait for PendSV */
+static stimer_pend_t stimerPendingDeferred;
+/** @brief Timers, which callbacks wait for stimerDispatch */
+static stimer_pend_t stimerPendingMain;
+#if STIMER_US
+/** @brief Callback of deadline */
+static void (*volatile stimerUsCallback) (void);
+#endif
+
+
+/**
+* @brief     Returns timer of a handle
+* @param     handle Timer handle
+* @return    Timer, or NULL if handle is not valid
+*/
+static stimer_t *stimer_get (stimerHandle_t handle)
+{
+	const uint8_t n = (uint8_t)handle;
+	
+	if((n >= STIMER_POOL_NBR) || !stimerPool[n].used || (stimerPool[n].gen != (uint8_t)(handle >> 8)))
+	{
+		return 0;
+	}
+	return &stimerPool[n];
+}
+
+/**
+* @brief     Returns wheel of a timer
+* @param     tmr Timer
+* @return    Wheel
+*/
+static stimer_wheel_t *stimer_wheel (stimer_t *tmr)
+{
+#if STIMER_RTC
+	if(tmr->rtc)
+	{
+		return &stimerRtc;
+	}
+#endif
+	return &stimerTc;
+}
+
+#if STIMER_RTC
+/**
+* @brief     Returns RTC count extended to 64 bits
+*
+* Must be called with interrupts disabled.
+*
+* @return    Count of 1024 Hz ticks
+*/
+static uint64_t stimer_rtc_ticks (void)
+{
+	uint32_t hi = stimerRtcHi;
+	const uint32_t cnt = RTC->MODE0.COUNT.reg;
+	
+	/* Overflow, that interrupt has not served yet */
+	if((RTC->MODE0.INTFLAG.reg & RTC_MODE0_INTFLAG_OVF) && (cnt < 0x80000000UL))
+	{
+		hi++;
+	}
+	return (((uint64_t)hi) << 32) | cnt;
+}
+
+/**
+* @brief     Returns time of RTC
+*
+* Must be called with interrupts disabled.
+*
+* @return    Time in ms
+*/
+static uint32_t stimer_rtc_ms (void)
+{
+	return (uint32_t)((stimer_rtc_ticks() * 1000) >> 10);
+}
+#endif
+
+/**
+* @brief     Returns current time of a wheel
+*
+* Time between TC3 interrupts is taken from TC3 counter. Must be called with
+* interrupts disabled.
+*
+* @param     wheel Wheel
+* @return    Time in ms
+*/
+static uint32_t stimer_now (stimer_wheel_t *wheel)
+{
+#if STIMER_RTC
+	if(wheel == &stimerRtc)
+	{
+		return stimer_rtc_ms();
+	}
+#endif
+#if STIMER_TICKLESS
+	return wheel->now + (uint16_t)(TC3->COUNT16.COUNT.reg - stimerLastCnt) / STIMER_TICKS_PER_MS;
+#else
+	return wheel->now;
+#endif
+}
+
+/**
+* @brief     Links timer in the lowest level of wheel, that reaches its expiry
+*
+* Must be called with interrupts disabled.
+*
+* @param     tmr Timer
+*/
+static void stimer_place (stimer_t *tmr)
+{
+	stimer_wheel_t *wheel = stimer_wheel(tmr);
+	const uint32_t delta = tmr->expires - wheel->ms;
+	uint32_t expires = tmr->expires;
+	uint8_t level, shift;
+	uint16_t slot;
+	
+	for(level = 0; level < STIMER_WHEEL_LEVELS; level++)
+	{
+		/* Distance in slots of this level, it does not overflow when time wraps */
+		shift = level * STIMER_WHEEL_BITS;
+		if((((wheel->ms & ((1UL << shift) - 1)) + delta) >> shift) < STIMER_WHEEL_SLOTS)
+		{
+			break;
+		}
+	}
+	if(level == STIMER_WHEEL_LEVELS)
+	{
+		/* Out of reach, timer is placed in the farthest slot and cascaded again */
+		level = STIMER_WHEEL_LEVELS - 1;
+		shift = level * STIMER_WHEEL_BITS;
+		expires = wheel->ms + ((STIMER_WHEEL_SLOTS - 1UL) << shift);
+	}
+	
+	slot = level * STIMER_WHEEL_SLOTS + ((expires >> shift) & (STIMER_WHEEL_SLOTS - 1));
+	tmr->slot = slot;
+	tmr->prev = 0;
+	tmr->next = wheel->slot[slot];
+	if(tmr->next)
+	{
+		tmr->next->prev = tmr;
+	}
+	wheel->slot[slot] = tmr;
+	wheel->levelCnt[level]++;
+}
+
+/**
+* @brief     Unlinks timer from wheel
+*
+* Must be called with interrupts disabled.
+*
+* @param     tmr Timer
+*/
+static void stimer_unplace (stimer_t *tmr)
+{
+	stimer_wheel_t *wheel = stimer_wheel(tmr);
+	
+	if(tmr->slot == STIMER_NONE)
+	{
+		return;
+	}
+	if(tmr->prev)
+	{
+		tmr->prev->next = tmr->next;
+	}
+	else
+	{
+		wheel->slot[tmr->slot] = tmr->next;
+	}
+	if(tmr->next)
+	{
+		tmr->next->prev = tmr->prev;
+	}
+	wheel->levelCnt[tmr->slot / STIMER_WHEEL_SLOTS]--;
+	tmr->slot = STIMER_NONE;
+}
+
+/**
+* @brief     Moves timers of a slot one or more levels down
+*
+* Must be called with interrupts disabled.
+*
+* @param     wheel Wheel
+* @param     slot Slot of wheel
+*/
+static void stimer_cascade (stimer_wheel_t *wheel, uint16_t slot)
+{
+	stimer_t *tmr;
+	
+	while((tmr = wheel->slot[slot]) != 0)
+	{
+		stimer_unplace(tmr);
+		stimer_place(tmr);
+	}
+}
+
+/**
+* @brief     Returns time to the next expiry or cascade
+*
+* Must be called with interrupts disabled.
+*
+* @param     wheel Wheel
+* @return    Time from time of wheel in ms, 0 if wheel is empty
+*/
+static uint32_t stimer_next (stimer_wheel_t *wheel)
+{
+	uint32_t next = 0;
+	uint32_t index, delay;
+	uint8_t level, shift, k;
+	
+	for(level = 0; level < STIMER_WHEEL_LEVELS; level++)
+	{
+		if(!wheel->levelCnt[level])
+		{
+			continue;
+		}
+		/* Current slot of a level is never occupied, timers there would be on lower level */
+		shift = level * STIMER_WHEEL_BITS;
+		index = wheel->ms >> shift;
+		for(k = 1; k < STIMER_WHEEL_SLOTS; k++)
+		{
+			if(wheel->slot[level * STIMER_WHEEL_SLOTS + ((index + k) & (STIMER_WHEEL_SLOTS - 1))])
+			{
+				delay = ((index + k) << shift) - wheel->ms;
+				if(!next || (delay < next))
+				{
+					next = delay;
+				}
+				break;
+			}
+		}
+	}
+	return next;
+}
+
+/**
+* @brief     Adds timer to a list of deferred callbacks
+*
+* Must be called with interrupts disabled.
+*
+* @param     pend List
+* @param     tmr Timer
+* @return    0 if timer was already waiting, 1 if it has been added
+*/
+static uint8_t stimer_pend (stimer_pend_t *pend, stimer_t *tmr)
+{
+	if(tmr->pending)
+	{
+		return 0;
+	}
+	tmr->pending = 1;
+	tmr->pendNext = 0;
+	if(pend->last)
+	{
+		pend->last->pendNext = tmr;
+	}
+	else
+	{
+		pend->first = tmr;
+	}
+	pend->last = tmr;
+	return 1;
+}
+
+/**
+* @brief     Removes timer from a list of deferred callbacks
+*
+* Must be called with interrupts disabled.
+*
+* @param     pend List
+* @param     tmr Timer
+*/
+static void stimer_unpend (stimer_pend_t *pend, stimer_t *tmr)
+{
+	stimer_t *prev = 0;
+	stimer_t *p;
+	
+	if(!tmr->pending)
+	{
+		return;
+	}
+	for(p = pend->first; p; prev = p, p = p->pendNext)
+	{
+		if(p == tmr)
+		{
+			if(prev)
+			{
+				prev->pendNext = tmr->pendNext;
+			}
+			else
+			{
+				pend->first = tmr->pendNext;
+			}
+			if(pend->last == tmr)
+			{
+				pend->last = prev;
+			}
+			tmr->pending = 0;
+			return;
+		}
+	}
+}
+
+#if STIMER_STATS
+/**
+* @brief     Records lateness of a timer
+*
+* Must be called with interrupts disabled.
+*
+* @param     tmr Timer
+* @param     due Expiry in ms
+*/
+static void stimer_record (stimer_t *tmr, uint32_t due)
+{
+	uint32_t late;
+	
+#if STIMER_RTC
+	if(tmr->rtc)
+	{
+		late = (stimer_rtc_ms() - due) * 1000;
+	}
+	else
+#endif
+	{
+#if STIMER_TICKLESS
+		late = ((stimerTc.now - due) * STIMER_TICKS_PER_MS + (uint16_t)(TC3->COUNT16.COUNT.reg - stimerLastCnt)) * 4;
+#else
+		late = (stimerTc.now - due) * 1000 + TC3->COUNT8.COUNT.reg * 4;
+#endif
+	}
+	if(!tmr->statCount || (late < tmr->lateMin))
+	{
+		tmr->lateMin = late;
+	}
+	if(late > tmr->lateMax)
+	{
+		tmr->lateMax = late;
+	}
+	tmr->lateSum += late;
+	tmr->statCount++;
+}
+#endif
+
+/**
+* @brief     Calls callback of a timer
+*
+* Must be called with interrupts disabled, callback is called with interrupts enabled.
+*
+* @param     tmr Timer
+*/
+static void stimer_call (stimer_t *tmr)
+{
+	void (*function) (void) = (void (*) (void))tmr->function;
+	void (*ctxFunction) (void *ctx) = tmr->ctxFunction;
+	void *ctx = tmr->ctx;
+	
+	tmr->inCallback = 1;
+	system_interrupt_leave_critical_section();
+	if(function)
+	{
+		function(); // call callback function
+	}
+	if(ctxFunction)
+	{
+		ctxFunction(ctx);
+	}
+	system_interrupt_enter_critical_section();
+	tmr->inCallback = 0;
+}
+
+/**
+* @brief     Calls callback of expired timer, or defers it to its level
+*
+* Called from TC3 or RTC interrupt, with interrupts disabled.
+*
+* @param     tmr Timer
+* @param     due Expiry in ms
+*/
+static void stimer_expired (stimer_t *tmr, uint32_t due)
+{
+	if(!tmr->function && !tmr->ctxFunction)
+	{
+#if STIMER_STATS
+		stimer_record(tmr, due);
+#endif
+		return;
+	}
+	switch(tmr->level)
+	{
+		case STIMER_LEVEL_DEFERRED:
+		case STIMER_LEVEL_MAIN:
+			if(stimer_pend((tmr->level == STIMER_LEVEL_MAIN) ? &stimerPendingMain : &stimerPendingDeferred, tmr))
+			{
+				tmr->due = due;
+			}
+			else
+			{
+#if STIMER_STATS
+				tmr->overruns++;
+#endif
+			}
+			if(tmr->level == STIMER_LEVEL_DEFERRED)
+			{
+				SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+			}
+			break;
+		default:
+			tmr->due = due;
+#if STIMER_STATS
+			stimer_record(tmr, due);
+#endif
+			stimer_call(tmr);
+			break;
+	}
+}
+
+/**
+* @brief     Calls callbacks of timers in a list of deferred callbacks
+* @param     pend List, it is emptied
+*/
+static void stimer_run_pending (stimer_pend_t *pend)
+{
+	stimer_t *tmr;
+	
+	while(1)
+	{
+		system_interrupt_enter_critical_section();
+		tmr = pend->first;
+		if(tmr)
+		{
+			pend->first = tmr->pendNext;
+			if(!pend->first)
+			{
+				pend->last = 0;
+			}
+			tmr->pending = 0;
+#if STIMER_STATS
+			stimer_record(tmr, tmr->due);
+#endif
+			stimer_call(tmr);
+		}
+		system_interrupt_leave_critical_section();
+		if(!tmr)
+		{
+			return;
+		}
+	}
+}
+
+/**
+* @brief     Advances time of last interrupt
+*
+* Called from TC3 interrupt.
+*
+* @param     ms Time in ms since last interrupt
+*/
+static void stimer_advance (uint32_t ms)
+{
+#if STIMER_US
+	uint32_t us;
+#endif
+	
+	system_interrupt_enter_critical_section();
+#if STIMER_TICKLESS
+	stimerLastCnt += ms * STIMER_TICKS_PER_MS;
+#endif
+	if((uint32_t)(stimerTc.now + ms) < stimerTc.now)
+	{
+		stimerNowHi++;
+	}
+	stimerTc.now += ms;
+#if STIMER_US
+	us = stimerNowUs();
+	if(us < stimerUsLast)
+	{
+		stimerUsHi++;
+	}
+	stimerUsLast = us;
+#endif
+	stimerSeq++;
+	system_interrupt_leave_critical_section();
+}
+
+/**
+* @brief     Moves wheel to its time of last interrupt and serves expired timers
+*
+* Called from TC3 or RTC interrupt. Callbacks are called with interrupts enabled.
+* Timers started from a callback count from current time, auto reload timers from
+* their expiry.
+*
+* @param     wheel Wheel
+*/
+static void stimer_update (stimer_wheel_t *wheel)
+{
+	stimer_t *tmr;
+	uint32_t due, missed, delay;
+	uint8_t level, shift;
+	
+	system_interrupt_enter_critical_section();
+	wheel->busy = 1;
+	while(wheel->ms != wheel->now)
+	{
+		/* Wheel jumps over time without expiry or cascade */
+		delay = stimer_next(wheel);
+		if(!delay || (delay > (wheel->now - wheel->ms)))
+		{
+			wheel->ms = wheel->now;
+			break;
+		}
+		wheel->ms += delay;
+		
+		/* Cascade from the highest level, that turns to a new slot */
+		for(level = 1; level < STIMER_WHEEL_LEVELS; level++)
+		{
+			if(wheel->ms & ((1UL << (level * STIMER_WHEEL_BITS)) - 1))
+			{
+				break;
+			}
+		}
+		while(--level)
+		{
+			shift = level * STIMER_WHEEL_BITS;
+			if(wheel->levelCnt[level])
+			{
+				stimer_cascade(wheel, level * STIMER_WHEEL_SLOTS + ((wheel->ms >> shift) & (STIMER_WHEEL_SLOTS - 1)));
+			}
+		}
+		
+		/* Slot holds only timers, that expire now, timers placed by callbacks go to other slots */
+		while((tmr = wheel->slot[wheel->ms & (STIMER_WHEEL_SLOTS - 1)]) != 0)
+		{
+			stimer_unplace(tmr);
+			due = tmr->expires;
+			if(tmr->autoReload)
+			{
+				tmr->expires += tmr->autoReload;
+				if((int32_t)(wheel->now - tmr->expires) >= 0)
+				{
+					/* Missed periods are skipped, timer keeps its phase */
+					missed = (wheel->now - tmr->expires) / tmr->autoReload + 1;
+					tmr->expires += missed * tmr->autoReload;
+#if STIMER_STATS
+					tmr->overruns += missed;
+#endif
+				}
+				stimer_place(tmr);
+			}
+			else
+			{
+				tmr->time = 0;
+				tmr->running = 0;
+			}
+			stimer_expired(tmr, due);
+		}
+	}
+	wheel->busy = 0;
+	system_interrupt_leave_critical_section();
+}
+
+#if STIMER_TICKLESS
+/**
+* @brief     Sets TC3 compare to the next time, when wheel has work
+*
+* If that time has already passed while it was set, interrupt is triggered by software.
+*
+*/
+static void stimer_program (void)
+{
+	uint32_t delay;
+	uint16_t target;
+	
+	system_interrupt_enter_critical_section();
+	if(stimerTc.busy)
+	{
+		/* Interrupt sets compare when it is done */
+		system_interrupt_leave_critical_section();
+		return;
+	}
+	delay = stimer_next(&stimerTc);
+	if(!delay || (delay > STIMER_SHOT_MAX))
+	{
+		delay = STIMER_SHOT_MAX;
+	}
+	target = stimerLastCnt + (uint16_t)(delay * STIMER_TICKS_PER_MS);
+	TC3->COUNT16.CC[0].reg = target;
+	while(TC3->COUNT16.STATUS.bit.SYNCBUSY == 1) {}
+	if((uint16_t)(TC3->COUNT16.COUNT.reg - stimerLastCnt) >= (uint16_t)(target - stimerLastCnt))
+	{
+		NVIC_SetPendingIRQ(TC3_IRQn);
+	}
+	system_interrupt_leave_critical_section();
+}
+#endif
+
+#if STIMER_RTC
+/**
+* @brief     Sets RTC compare to the next time, when wheel has work
+*
+* If that time has already passed while it was set, interrupt is triggered by software.
+*
+*/
+static void stimer_rtc_program (void)
+{
+	uint64_t ticks, target;
+	uint32_t delay;
+	int32_t ahead;
+	
+	system_interrupt_enter_critical_section();
+	delay = stimer_next(&stimerRtc);
+	if(stimerRtc.busy || !delay)
+	{
+		/* Empty wheel does not need interrupt, RTC counts on */
+		if(!delay)
+		{
+			RTC->MODE0.INTENCLR.reg = RTC_MODE0_INTENCLR_CMP0;
+		}
+		system_interrupt_leave_critical_section();
+		return;
+	}
+	ticks = stimer_rtc_ticks();
+	ahead = (int32_t)(stimerRtc.ms + delay - (uint32_t)((ticks * 1000) >> 10));
+	if(ahead <= 0)
+	{
+		NVIC_SetPendingIRQ(RTC_IRQn);
+		system_interrupt_leave_critical_section();
+		return;
+	}
+	/* First tick, which ms time reaches the target */
+	target = ((((ticks * 1000) >> 10) + ahead) * 1024 + 999) / 1000;
+	RTC->MODE0.COMP[0].reg = (uint32_t)target;
+	while(RTC->MODE0.STATUS.bit.SYNCBUSY == 1) {}
+	RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+	RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_CMP0;
+	if((int32_t)(RTC->MODE0.COUNT.reg - (uint32_t)target) >= 0)
+	{
+		NVIC_SetPendingIRQ(RTC_IRQn);
+	}
+	system_interrupt_leave_critical_section();
+}
+#endif
+
+/**
+* @brief     Sets compare of time base after timer has been started
+* @param     tmr Timer
 */
+static void stimer_started (stimer_t *tmr)
+{
+#if STIMER_RTC
+	if(tmr->rtc)
+	{
+		stimer_rtc_program();
+		return;
+	}
+#endif
+#if STIMER_TICKLESS
+	stimer_program();
+#endif
+	(void)tmr;
+}
 
+/**
+* @brief     Places count down timer, so that it expires after a time
+*
+* Timer re-armed from its own callback counts from the expiry, that callback serves.
+* Must be called with interrupts disabled.
+*
+* @param     tmr Timer
+* @param     t Time in ms
+*/
+static void stimer_arm (stimer_t *tmr, uint32_t t)
+{
+	stimer_wheel_t *wheel = stimer_wheel(tmr);
+	
+	tmr->expires = (tmr->inCallback ? tmr->due : stimer_now(wheel)) + t;
+	if((int32_t)(tmr->expires - wheel->ms) <= 0)
+	{
+		/* Expiry has already passed, timer expires in the next ms */
+		tmr->expires = wheel->ms + 1;
+	}
+	stimer_place(tmr);
+}
 
-/****************************************************************************************
-* Include files
-****************************************************************************************/
-#include "STimer.h"
+/**
+* @brief     Returns current time of a timer
+*
+* Must be called with interrupts disabled.
+*
+* @param     tmr Timer
+* @param     now Current time in ms
+* @return    Remaining time or time of stopwatch in ms
+*/
+static uint32_t stimer_value (stimer_t *tmr, uint32_t now)
+{
+	if(!tmr->running)
+	{
+		return tmr->time;
+	}
+	if(tmr->stopwatch)
+	{
+		return tmr->time + (now - tmr->start);
+	}
+	/* Expired timer may wait for interrupt for a short time */
+	return ((int32_t)(tmr->expires - now) > 0) ? (tmr->expires - now) : 0;
+}
 
-/****************************************************************************************
-* Global variables
-****************************************************************************************/
-stimer_ch_t stimer_times[STIMER_NBR];
+#if STIMER_US
+/**
+* @brief     Starts TC4 and TC5 as 32 bit counter at 1 MHz
+*
+* GCLK2 must be set up before.
+*
+*/
+static void stimer_us_init (void)
+{
+	PM->APBCMASK.reg |= PM_APBCMASK_TC4 | PM_APBCMASK_TC5; // enable clock for TC4 and TC5
+	GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TC4_TC5 | GCLK_CLKCTRL_GEN_GCLK2 | GCLK_CLKCTRL_CLKEN;
+	while(GCLK->STATUS.bit.SYNCBUSY == 1) {}
+	
+	/* TC5 follows TC4 as its upper 16 bits */
+	TC4->COUNT32.CTRLA.reg = TC_CTRLA_MODE_COUNT32 | TC_CTRLA_WAVEGEN_NFRQ | TC_CTRLA_PRESCALER_DIV4;
+	TC4->COUNT32.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+	TC4->COUNT32.CTRLA.reg |= TC_CTRLA_ENABLE;
+	while(TC4->COUNT32.STATUS.bit.SYNCBUSY == 1) {}
+	
+	NVIC_EnableIRQ(TC4_IRQn);
+}
+#endif
 
+#if STIMER_RTC
+/**
+* @brief     Starts RTC as 32 bit counter at 1024 Hz
+*
+* RTC is clocked from OSCULP32K through STIMER_RTC_GCLK, which runs in STANDBY.
+*
+*/
+static void stimer_rtc_init (void)
+{
+	GCLK->GENDIV.reg = GCLK_GENDIV_ID(STIMER_RTC_GCLK) | GCLK_GENDIV_DIV(32);
+	GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(STIMER_RTC_GCLK) | GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_GENEN |
+						GCLK_GENCTRL_RUNSTDBY;
+	while(GCLK->STATUS.bit.SYNCBUSY == 1) {}
+	GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC | GCLK_CLKCTRL_GEN(STIMER_RTC_GCLK) | GCLK_CLKCTRL_CLKEN;
+	while(GCLK->STATUS.bit.SYNCBUSY == 1) {}
+	PM->APBAMASK.reg |= PM_APBAMASK_RTC; // enable clock for RTC
+	
+	RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32 | RTC_MODE0_CTRL_PRESCALER_DIV1;
+	/* Counter is synchronized continuously, so it can be read at any time */
+	RTC->MODE0.READREQ.reg = RTC_READREQ_RCONT | RTC_READREQ_ADDR(RTC_MODE0_COUNT_OFFSET);
+	RTC->MODE0.CTRL.reg |= RTC_MODE0_CTRL_ENABLE;
+	while(RTC->MODE0.STATUS.bit.SYNCBUSY == 1) {}
+	
+	stimerRtc.now = stimer_rtc_ms();
+	stimerRtc.ms = stimerRtc.now;
+	RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_OVF;
+	NVIC_EnableIRQ(RTC_IRQn);
+}
+#endif
 
 /**
 * @brief     Initializes hardware timer to trigger
@@ -60,6 +962,25 @@ stimer_ch_t stimer_times[STIMER_NBR];
 */
 void stimerInit (void)
 {
+	uint8_t n;
+	
+	/* Channels are always allocated, other timers are free */
+	stimerFree = 0;
+	for(n = STIMER_POOL_NBR; n > 0; n--)
+	{
+		stimerPool[n - 1].slot = STIMER_NONE;
+		stimerPool[n - 1].gen = 1;
+		if(n > STIMER_NBR)
+		{
+			stimerPool[n - 1].next = stimerFree;
+			stimerFree = &stimerPool[n - 1];
+		}
+		else
+		{
+			stimerPool[n - 1].used = 1;
+		}
+	}
+	
 	GCLK->GENDIV.bit.ID = 2;
 	GCLK->GENDIV.bit.DIV = 12;
 
@@ -74,6 +995,25 @@ void stimerInit (void)
 
 	PM->APBCMASK.reg |= PM_APBCMASK_TC3; // enable clock for TC3
 
+#if STIMER_TICKLESS
+	/* Free running 16 bit counter, prescaler 16 */
+	TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_NFRQ | TC_CTRLA_PRESCALER_DIV16;
+	/* Counter is synchronized continuously, so it can be read at any time */
+	TC3->COUNT16.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+	
+	/*Enable timer */
+	TC3->COUNT16.CTRLA.reg |= TC_CTRLA_ENABLE;
+	/*Wait for clock sync */
+	while(TC3->COUNT16.STATUS.bit.SYNCBUSY == 1) {}
+	
+	stimerLastCnt = TC3->COUNT16.COUNT.reg;
+	stimer_program();
+	/*Enable match interrupt */
+	TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+	NVIC_SetPriority(PendSV_IRQn, STIMER_DEFERRED_PRIO);
+	NVIC_EnableIRQ(TC3_IRQn);
+	__enable_irq();
+#else
 	/* Set timer to 8 bit mode */
 	TC3->COUNT8.CTRLA.reg |= TC_CTRLA_MODE_COUNT8;
 	/* Set prescaler to 16 */
@@ -88,131 +1028,672 @@ void stimerInit (void)
 	TC3->COUNT8.PER.reg = 249;
 	/*Enable match interrupt */
 	TC3->COUNT8.INTENSET.reg |= TC_INTENSET_MC0;
+	NVIC_SetPriority(PendSV_IRQn, STIMER_DEFERRED_PRIO);
 	NVIC_EnableIRQ(TC3_IRQn);
 	__enable_irq();
 	/*Start timer */
 	TC3->COUNT8.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+#endif
+#if STIMER_US
+	stimer_us_init();
+#endif
+#if STIMER_RTC
+	stimer_rtc_init();
+#endif
 		 
 }
 
 
-void TC3_Handler(void)
+void TC3_Handler(void)
+{
+#if STIMER_TICKLESS
+	uint16_t ms;
+	
+	TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+	ms = (uint16_t)(TC3->COUNT16.COUNT.reg - stimerLastCnt) / STIMER_TICKS_PER_MS;
+	stimer_advance(ms);
+	stimer_update(&stimerTc);
+	stimer_program();
+#else
+	TC3->COUNT8.INTFLAG.reg |= TC_INTFLAG_MC0;
+	stimer_advance(1);
+	stimer_update(&stimerTc);
+#endif
+}
+
+#if STIMER_RTC
+void RTC_Handler(void)
+{
+	uint8_t flags;
+	
+	system_interrupt_enter_critical_section();
+	flags = RTC->MODE0.INTFLAG.reg;
+	RTC->MODE0.INTFLAG.reg = flags & (RTC_MODE0_INTFLAG_OVF | RTC_MODE0_INTFLAG_CMP0);
+	if(flags & RTC_MODE0_INTFLAG_OVF)
+	{
+		stimerRtcHi++;
+	}
+	stimerRtc.now = stimer_rtc_ms();
+	system_interrupt_leave_critical_section();
+	stimer_update(&stimerRtc);
+	stimer_rtc_program();
+}
+#endif
+
+/**
+* @brief     Calls deferred callbacks at the lowest interrupt priority
+*
+*/
+void PendSV_Handler(void)
+{
+	stimer_run_pending(&stimerPendingDeferred);
+}
+
+/**
+* @brief     Returns time since stimerInit
+*
+* Can be called from any interrupt, it does not disable interrupts.
+*
+* @return	 Time in ms
+*/
+uint64_t stimerUptimeMs (void)
+{
+	uint32_t seq, lo, hi;
+#if STIMER_TICKLESS
+	uint16_t cnt, last;
+#endif
+	
+	do
+	{
+		seq = stimerSeq;
+		lo = stimerTc.now;
+		hi = stimerNowHi;
+#if STIMER_TICKLESS
+		last = stimerLastCnt;
+		cnt = TC3->COUNT16.COUNT.reg;
+#endif
+	}while(seq != stimerSeq);
+#if STIMER_TICKLESS
+	return ((((uint64_t)hi) << 32) | lo) + (uint16_t)(cnt - last) / STIMER_TICKS_PER_MS;
+#else
+	return (((uint64_t)hi) << 32) | lo;
+#endif
+}
+
+/**
+* @brief     Allocates a timer from pool
+*
+* Timer is stopped, in count down mode, without time.
+*
+* @param	 funct Callback, or NULL
+* @param	 level Where callback is called
+* @return	 Handle of the timer, STIMER_HANDLE_NONE if pool is empty
+*/
+stimerHandle_t stimerCreate (void(*funct)(void), stimerLevel_t level)
+{
+	stimer_t *tmr;
+	uint8_t gen;
+	
+	system_interrupt_enter_critical_section();
+	tmr = stimerFree;
+	if(tmr)
+	{
+		stimerFree = tmr->next;
+	}
+	system_interrupt_leave_critical_section();
+	if(!tmr)
+	{
+		return STIMER_HANDLE_NONE;
+	}
+	
+	gen = tmr->gen;
+	memset(tmr, 0, sizeof(*tmr));
+	tmr->gen = gen;
+	tmr->used = 1;
+	tmr->slot = STIMER_NONE;
+	tmr->function = (volatile void (*) (void))funct;
+	tmr->level = level;
+	return (stimerHandle_t)((tmr->gen << 8) | (tmr - stimerPool));
+}
+
+/**
+* @brief     Allocates a timer from pool, with callback, that gets a context
+* @param	 funct Callback, or NULL
+* @param	 ctx Context given to callback
+* @param	 level Where callback is called
+* @return	 Handle of the timer, STIMER_HANDLE_NONE if pool is empty
+*/
+stimerHandle_t stimerCreateCtx (void(*funct)(void *ctx), void *ctx, stimerLevel_t level)
+{
+	const stimerHandle_t handle = stimerCreate(0, level);
+	
+	stimerHandleRegisterCallbackCtx(handle, funct, ctx);
+	return handle;
+}
+
+/**
+* @brief     Stops timer and returns it to pool
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerDelete (stimerHandle_t handle)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr || ((tmr - stimerPool) < STIMER_NBR))
+	{
+		return 0;
+	}
+	stimerHandleStop(handle);
+	system_interrupt_enter_critical_section();
+	stimer_unpend(&stimerPendingDeferred, tmr);
+	stimer_unpend(&stimerPendingMain, tmr);
+	/* Generation changes, so that handles of deleted timer stay invalid */
+	tmr->gen = (uint8_t)(tmr->gen + 1) ? (uint8_t)(tmr->gen + 1) : 1;
+	tmr->used = 0;
+	tmr->next = stimerFree;
+	stimerFree = tmr;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Returns handle of a fixed channel
+* @param	 timer, timer channel
+* @return	 Handle of the channel, STIMER_HANDLE_NONE if channel does not exist
+*/
+stimerHandle_t stimerGetHandle (uint8_t timer)
+{
+	if(timer > (STIMER_NBR - 1))
+	{
+		return STIMER_HANDLE_NONE;
+	}
+	return (stimerHandle_t)((1 << 8) | timer);
+}
+
+/**
+* @brief     Sets time of a timer
+* @param	 handle Timer handle
+* @param     t time in milliseconds
+* @param	 autoreload If set to 1 timer will automatically reload to set
+*			 value and start another countdown.	
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleSetTime (stimerHandle_t handle, uint32_t t, uint8_t autoreload)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->time = t;
+	tmr->autoReload = autoreload ? t : 0;
+	if(tmr->running)
+	{
+		if(tmr->stopwatch)
+		{
+			tmr->start = stimer_now(stimer_wheel(tmr));
+		}
+		else
+		{
+			/* Running timer counts down from new time */
+			stimer_unplace(tmr);
+			if(t)
+			{
+				stimer_arm(tmr, t);
+			}
+			else
+			{
+				tmr->running = 0;
+			}
+		}
+	}
+	system_interrupt_leave_critical_section();
+	stimer_started(tmr);
+	return 1;
+}
+
+/**
+* @brief     Starts a timer
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleStart (stimerHandle_t handle)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	if(!tmr->running) //check that timer is not running yet
+	{
+		if(!tmr->stopwatch && !tmr->time) // downcounting mode
+		{
+			return 0;
+		}
+		system_interrupt_enter_critical_section();
+		if(tmr->stopwatch)
+		{
+			tmr->start = stimer_now(stimer_wheel(tmr));
+		}
+		else
+		{
+			stimer_arm(tmr, tmr->time);
+		}
+		tmr->running = 1;
+		system_interrupt_leave_critical_section();
+		stimer_started(tmr);
+	}
+	return 1;
+}
+
+/**
+* @brief     Stops a timer, its time is kept
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleStop (stimerHandle_t handle)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->time = stimer_value(tmr, stimer_now(stimer_wheel(tmr)));
+	stimer_unplace(tmr);
+	tmr->running = 0;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Resets time of a timer to 0, running count down timer is stopped
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleReset (stimerHandle_t handle)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->start = stimer_now(stimer_wheel(tmr));
+	if(tmr->running && !tmr->stopwatch)
+	{
+		/* Count down timer at 0 has expired */
+		stimer_unplace(tmr);
+		tmr->running = 0;
+	}
+	tmr->time = 0;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Returns time of a timer
+* @param	 handle Timer handle
+* @return	 Remaining time of count down timer or time of stopwatch in ms,
+*			 0 on error
+*/
+uint32_t stimerHandleGetTime (stimerHandle_t handle)
+{
+	stimer_t *tmr = stimer_get(handle);
+	uint32_t t;
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	t = stimer_value(tmr, stimer_now(stimer_wheel(tmr)));
+	system_interrupt_leave_critical_section();
+	return t;
+}
+
+/**
+* @brief     Sets mode of a timer, running timer continues from its current time
+* @param	 handle Timer handle
+* @param	 stopwatch 1 to count up, 0 to count down
+* @return	 0 on error, 1 on success
+*/
+static uint32_t stimer_set_mode (stimerHandle_t handle, uint8_t stopwatch)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	if(tmr->running && (tmr->stopwatch != stopwatch))
+	{
+		stimerHandleStop(handle);
+		tmr->stopwatch = stopwatch;
+		stimerHandleStart(handle);
+		return 1;
+	}
+	tmr->stopwatch = stopwatch;
+	return 1;
+}
+
+/**
+* @brief     Configures timer as stopwatch.
+*			 Timer will count up and never reset.
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleSetAsStopwatch (stimerHandle_t handle)
+{
+	return stimer_set_mode(handle, 1);
+}
+
+/**
+* @brief     Configures timer as timer.
+*			 Timer will count down.
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleSetAsTimer (stimerHandle_t handle)
+{
+	return stimer_set_mode(handle, 0);
+}
+
+/**
+* @brief     Registers callback for timer. When timer counts to 0,
+*			 callback function will get called.
+* @param	 handle Timer handle
+* @param	 funct Callback
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleRegisterCallback (stimerHandle_t handle, void(*funct)(void))
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->function = (volatile void (*) (void))funct;
+	tmr->ctxFunction = 0;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Registers callback with context for timer. When timer counts to 0,
+*			 callback function will get called with the context.
+* @param	 handle Timer handle
+* @param	 funct Callback
+* @param	 ctx Context given to callback
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleRegisterCallbackCtx (stimerHandle_t handle, void(*funct)(void *ctx), void *ctx)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->function = 0;
+	tmr->ctxFunction = funct;
+	tmr->ctx = ctx;
+	system_interrupt_leave_critical_section();
+	return 1;
+}
+
+/**
+* @brief     Removes callback function from timer
+* @param	 handle Timer handle
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleUnregisterCallback (stimerHandle_t handle)
 {
-	uint32_t n;
-	uint32_t ul_dummy;
-	TC3->COUNT8.INTFLAG.reg |= TC_INTFLAG_MC0;
-	for(n = 0; n < STIMER_NBR; n++)
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
 	{
-		if(stimer_times[n].running)
-		{
-			if(stimer_times[n].stopwatch) // upcounting mode
-			{
-				stimer_times[n].time++;
-			}
-			else
-			{
-				stimer_times[n].time--;
-				if(!stimer_times[n].time) // timer has expired
-				{
-					if(stimer_times[n].function)
-					{
-						stimer_times[n].function(); // call callback function
-					}
-					if(stimer_times[n].auto_reload)
-					{
-						stimer_times[n].time = stimer_times[n].auto_reload;
-					}
-					else
-					{
-						stimer_times[n].running = 0;
-					}
-				}
-			}
-		}
-	}	
+		return 0;
+	}
+	system_interrupt_enter_critical_section();
+	tmr->function = 0;
+	tmr->ctxFunction = 0;
+	system_interrupt_leave_critical_section();
+	return 1;
 }
 
 /**
-* @brief     Sets timer on a software timer channel
-* @param	 timer, timer channel
-* @param     t time in milliseconds
-* @param	 autoreload If set to 1 timer will automatically reload to set
-*			 value and start another countdown.	
+* @brief     Sets where callback of timer is called
+* @param	 handle Timer handle
+* @param	 level STIMER_LEVEL_ISR to call it from TC3 interrupt,
+*			 STIMER_LEVEL_DEFERRED from PendSV at the lowest priority,
+*			 STIMER_LEVEL_MAIN from stimerDispatch
 * @return	 0 on error, 1 on success
 */
+uint32_t stimerHandleSetLevel (stimerHandle_t handle, stimerLevel_t level)
+{
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
+	{
+		return 0;
+	}
+	tmr->level = level;
+	return 1;
+}
 
-uint32_t stimerSetTime(uint8_t timer, uint32_t t, uint8_t autoreload)
+#if STIMER_RTC
+/**
+* @brief     Selects time base of a timer by its resolution
+*
+* Timers with resolution of STIMER_RTC_RESOLUTION ms or more run on RTC, which
+* keeps counting in STANDBY. Running timer continues on new time base.
+*
+* @param	 handle Timer handle
+* @param	 ms Resolution, that timer needs, in ms
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerHandleSetResolution (stimerHandle_t handle, uint32_t ms)
 {
-	if(timer > (STIMER_NBR - 1))
+	stimer_t *tmr = stimer_get(handle);
+	const uint8_t rtc = (ms >= STIMER_RTC_RESOLUTION);
+	uint8_t running;
+	
+	if(!tmr)
 	{
 		return 0;
 	}
-	stimer_times[timer].time = t;
-	if(autoreload)
+	if(tmr->rtc == rtc)
 	{
-		stimer_times[timer].auto_reload = t;
+		return 1;
 	}
-	else
+	system_interrupt_enter_critical_section();
+	running = tmr->running;
+	if(running)
+	{
+		stimerHandleStop(handle);
+	}
+	tmr->rtc = rtc;
+	if(running)
 	{
-		stimer_times[timer].auto_reload = 0;
+		/* Count down timer continues with its remaining time */
+		if(!tmr->stopwatch && !tmr->time)
+		{
+			tmr->time = 1;
+		}
+		stimerHandleStart(handle);
 	}
+	system_interrupt_leave_critical_section();
 	return 1;
 }
 
 /**
-* @brief     Starts software timer
-* @param	 timer, timer channel
-* @return	 0 on error, 1 on success
+* @brief     Sleeps until an interrupt
+*
+* If no timer runs on TC3 and no us deadline is set, CPU sleeps in STANDBY, so only
+* RTC timers and other wake up sources wake it. TC3 and TC4 stop in STANDBY, time
+* of both is moved by the time measured with RTC, so ms and us uptime and
+* stopwatches go on.
+* Otherwise CPU sleeps in IDLE.
+*
 */
-uint32_t stimerStart(uint8_t timer)
+void stimerSleep (void)
 {
-	if(timer > (STIMER_NBR - 1))
+	uint32_t before, slept;
+#if STIMER_US
+	uint64_t us;
+#endif
+	uint8_t deep = 1;
+	uint8_t level;
+	
+	system_interrupt_enter_critical_section();
+	for(level = 0; level < STIMER_WHEEL_LEVELS; level++)
 	{
-		return 0;
+		if(stimerTc.levelCnt[level])
+		{
+			deep = 0;
+		}
+	}
+#if STIMER_US
+	if(stimerUsCallback)
+	{
+		deep = 0;
 	}
-	if(!stimer_times[timer].running) //check that timer is not running yet
+#endif
+	before = stimer_rtc_ms();
+	if(deep)
 	{
-		if(!stimer_times[timer].stopwatch) // downcounting mode
+		SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	}
+	/* Pending interrupt wakes CPU also with interrupts disabled */
+	__DSB();
+	__WFI();
+	if(deep)
+	{
+		SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+		slept = stimer_rtc_ms() - before;
+		if((uint32_t)(stimerTc.now + slept) < stimerTc.now)
 		{
-			if(!stimer_times[timer].time)
-			{
-				return 0;
-			}
+			stimerNowHi++;
 		}
-		stimer_times[timer].running = 1;
+		stimerTc.now += slept;
+		/* Wheel is empty, so it moves with the time, timers started now are counted from it */
+		stimerTc.ms = stimerTc.now;
+#if STIMER_US
+		/* Microsecond clock continues from its time at last interrupt, moved by slept time */
+		us = ((((uint64_t)stimerUsHi) << 32) | stimerUsLast) + (uint64_t)slept * 1000;
+		stimerUsOffset += slept * 1000;
+		us += (uint32_t)(stimerNowUs() - (uint32_t)us);
+		stimerUsHi = (uint32_t)(us >> 32);
+		stimerUsLast = (uint32_t)us;
+#endif
+		stimerSeq++;
 	}
-	return 1;
+	system_interrupt_leave_critical_section();
 }
+#endif
 
+#if STIMER_STATS
 /**
-* @brief     Stops software timer
-* @param	 timer, timer channel
+* @brief     Returns lateness statistics of a timer
+* @param	 handle Timer handle
+* @param	 stats Statistics
 * @return	 0 on error, 1 on success
 */
-uint32_t stimerStop (uint8_t timer)
+uint32_t stimerHandleGetStats (stimerHandle_t handle, stimerStats_t *stats)
 {
-	if(timer > (STIMER_NBR - 1))
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
 	{
 		return 0;
 	}
-	stimer_times[timer].running = 0;
+	system_interrupt_enter_critical_section();
+	stats->count = tmr->statCount;
+	stats->overruns = tmr->overruns;
+	stats->lateMin = tmr->lateMin;
+	stats->lateMax = tmr->lateMax;
+	stats->lateAvg = tmr->statCount ? (uint32_t)(tmr->lateSum / tmr->statCount) : 0;
+	stats->jitter = tmr->lateMax - tmr->lateMin;
+	system_interrupt_leave_critical_section();
 	return 1;
 }
 
 /**
-* @brief     Resets software timer
-* @param	 timer, timer channel
+* @brief     Clears lateness statistics of a timer
+* @param	 handle Timer handle
 * @return	 0 on error, 1 on success
 */
-uint32_t stimerReset (uint8_t timer)
+uint32_t stimerHandleStatsReset (stimerHandle_t handle)
 {
-	if(timer > (STIMER_NBR - 1))
+	stimer_t *tmr = stimer_get(handle);
+	
+	if(!tmr)
 	{
 		return 0;
 	}
-	stimer_times[timer].time = 0;
+	system_interrupt_enter_critical_section();
+	tmr->statCount = 0;
+	tmr->overruns = 0;
+	tmr->lateMin = 0;
+	tmr->lateMax = 0;
+	tmr->lateSum = 0;
+	system_interrupt_leave_critical_section();
 	return 1;
-	
+}
+#endif
+
+/**
+* @brief     Sets timer on a software timer channel
+* @param	 timer, timer channel
+* @param     t time in milliseconds
+* @param	 autoreload If set to 1 timer will automatically reload to set
+*			 value and start another countdown.	
+* @return	 0 on error, 1 on success
+*/
+
+uint32_t stimerSetTime(uint8_t timer, uint32_t t, uint8_t autoreload)
+{
+	return stimerHandleSetTime(stimerGetHandle(timer), t, autoreload);
+}
+
+/**
+* @brief     Starts software timer
+* @param	 timer, timer channel
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerStart(uint8_t timer)
+{
+	return stimerHandleStart(stimerGetHandle(timer));
+}
+
+/**
+* @brief     Stops software timer
+* @param	 timer, timer channel
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerStop (uint8_t timer)
+{
+	return stimerHandleStop(stimerGetHandle(timer));
+}
+
+/**
+* @brief     Resets software timer
+* @param	 timer, timer channel
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerReset (uint8_t timer)
+{
+	return stimerHandleReset(stimerGetHandle(timer));
 }
 
 /**
@@ -222,7 +1703,7 @@ uint32_t stimerReset (uint8_t timer)
 */
 uint32_t stimerGetTime (uint8_t timer)
 {
-	return stimer_times[timer].time;
+	return stimerHandleGetTime(stimerGetHandle(timer));
 }
 
 /**
@@ -233,12 +1714,7 @@ uint32_t stimerGetTime (uint8_t timer)
 */
 uint32_t stimerSetAsStopwatch (uint8_t timer)
 {
-	if(timer > (STIMER_NBR - 1))
-	{
-		return 0;
-	}
-	stimer_times[timer].stopwatch = 1;
-	return 1;
+	return stimerHandleSetAsStopwatch(stimerGetHandle(timer));
 }
 
 /**
@@ -249,12 +1725,7 @@ uint32_t stimerSetAsStopwatch (uint8_t timer)
 */
 uint32_t stimerSetAsTimer (uint8_t timer)
 {
-	if(timer > (STIMER_NBR - 1))
-	{
-		return 0;
-	}
-	stimer_times[timer].stopwatch = 0;
-	return 1;
+	return stimerHandleSetAsTimer(stimerGetHandle(timer));
 }
 
 /**
@@ -265,12 +1736,18 @@ uint32_t stimerSetAsTimer (uint8_t timer)
 */
 uint32_t stimerRegisterCallback (uint8_t timer, void(*funct)(void))
 {
-	if(timer > (STIMER_NBR - 1))
-	{
-		return 0;
-	}
-	stimer_times[timer].function = funct;
-	return 1;
+	return stimerHandleRegisterCallback(stimerGetHandle(timer), funct);
+}
+
+/**
+* @brief     Registers callback with context for timer. When timer counts to 0,
+*			 callback function will get called with the context.
+* @param	 timer, timer channel
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerRegisterCallbackCtx (uint8_t timer, void(*funct)(void *ctx), void *ctx)
+{
+	return stimerHandleRegisterCallbackCtx(stimerGetHandle(timer), funct, ctx);
 }
 
 /**
@@ -280,10 +1757,234 @@ uint32_t stimerRegisterCallback (uint8_t timer, void(*funct)(void))
 */
 uint32_t stimerUnregisterCallback (uint8_t timer)
 {
-	if(timer > (STIMER_NBR - 1))
+	return stimerHandleUnregisterCallback(stimerGetHandle(timer));
+}
+
+/**
+* @brief     Sets where callback of timer is called
+* @param	 timer, timer channel
+* @param	 level STIMER_LEVEL_ISR to call it from TC3 interrupt,
+*			 STIMER_LEVEL_DEFERRED from PendSV at the lowest priority,
+*			 STIMER_LEVEL_MAIN from stimerDispatch
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerSetLevel (uint8_t timer, stimerLevel_t level)
+{
+	return stimerHandleSetLevel(stimerGetHandle(timer), level);
+}
+
+#if STIMER_RTC
+/**
+* @brief     Selects time base of a timer by its resolution
+* @param	 timer, timer channel
+* @param	 ms Resolution, that timer needs, in ms
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerSetResolution (uint8_t timer, uint32_t ms)
+{
+	return stimerHandleSetResolution(stimerGetHandle(timer), ms);
+}
+#endif
+
+#if STIMER_STATS
+/**
+* @brief     Returns lateness statistics of a timer
+* @param	 timer, timer channel
+* @param	 stats Statistics
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerGetStats (uint8_t timer, stimerStats_t *stats)
+{
+	return stimerHandleGetStats(stimerGetHandle(timer), stats);
+}
+
+/**
+* @brief     Clears lateness statistics of a timer
+* @param	 timer, timer channel
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerStatsReset (uint8_t timer)
+{
+	return stimerHandleStatsReset(stimerGetHandle(timer));
+}
+#endif
+
+/**
+* @brief     Calls callbacks of expired timers on STIMER_LEVEL_MAIN.
+*			 Call it from main loop.
+*/
+void stimerDispatch (void)
+{
+	stimer_run_pending(&stimerPendingMain);
+}
+
+/**
+* @brief     Tells, if callbacks on STIMER_LEVEL_MAIN wait for stimerDispatch.
+*			 Main loop must not sleep, while they do.
+* @return    1 if a callback waits, 0 otherwise
+*/
+uint32_t stimerDispatchPending (void)
+{
+	return stimerPendingMain.first != 0;
+}
+
+#if STIMER_US
+void TC4_Handler(void)
+{
+	void (*function) (void) = stimerUsCallback;
+	
+	TC4->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+	TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+	stimerUsCallback = 0;
+	if(function)
+	{
+		function();
+	}
+}
+
+/**
+* @brief     Returns time of microsecond clock
+*
+* Time slept in STANDBY, when TC4 is stopped, is included.
+*
+* @return	 Time in us, it wraps from 0xFFFFFFFF to 0
+*/
+uint32_t stimerNowUs (void)
+{
+	return TC4->COUNT32.COUNT.reg + stimerUsOffset;
+}
+
+/**
+* @brief     Returns time of microsecond clock extended to 64 bits
+*
+* Can be called from any interrupt, it does not disable interrupts.
+*
+* @return	 Time in us since stimerInit
+*/
+uint64_t stimerUptimeUs (void)
+{
+	uint32_t seq, hi, last, now;
+	
+	do
+	{
+		seq = stimerSeq;
+		hi = stimerUsHi;
+		last = stimerUsLast;
+		now = stimerNowUs();
+	}while(seq != stimerSeq);
+	if(now < last)
+	{
+		/* Clock has wrapped after last interrupt */
+		hi++;
+	}
+	return (((uint64_t)hi) << 32) | now;
+}
+
+/**
+* @brief     Waits for a time
+* @param	 us Time in us
+*/
+void stimerDelayUs (uint32_t us)
+{
+	const uint32_t start = stimerNowUs();
+	
+	while((stimerNowUs() - start) < us) {}
+}
+
+/**
+* @brief     Stops stopwatch and clears its time
+* @param	 watch Stopwatch
+*/
+void stimerUsWatchReset (stimerUsWatch_t *watch)
+{
+	watch->start = 0;
+	watch->time = 0;
+	watch->running = 0;
+}
+
+/**
+* @brief     Starts stopwatch, it continues from its time
+* @param	 watch Stopwatch
+*/
+void stimerUsWatchStart (stimerUsWatch_t *watch)
+{
+	if(!watch->running)
+	{
+		watch->start = stimerNowUs();
+		watch->running = 1;
+	}
+}
+
+/**
+* @brief     Stops stopwatch, its time is kept
+* @param	 watch Stopwatch
+*/
+void stimerUsWatchStop (stimerUsWatch_t *watch)
+{
+	if(watch->running)
+	{
+		watch->time += stimerNowUs() - watch->start;
+		watch->running = 0;
+	}
+}
+
+/**
+* @brief     Returns time of stopwatch
+* @param	 watch Stopwatch
+* @return	 Time in us, measured time of one run must be shorter than 71 minutes
+*/
+uint32_t stimerUsWatchGet (const stimerUsWatch_t *watch)
+{
+	if(watch->running)
+	{
+		return watch->time + (stimerNowUs() - watch->start);
+	}
+	return watch->time;
+}
+
+/**
+* @brief     Sets deadline, callback is called from TC4 interrupt after given time.
+*			 Deadline, that is already set, is replaced.
+* @param	 us Time in us, 1 to STIMER_US_MAX
+* @param	 funct Callback
+* @return	 0 on error, 1 on success
+*/
+uint32_t stimerUsDeadlineSet (uint32_t us, void(*funct)(void))
+{
+	uint32_t deadline;
+	
+	if(!us || (us > STIMER_US_MAX) || !funct)
 	{
 		return 0;
 	}
-	stimer_times[timer].function = 0;
+	system_interrupt_enter_critical_section();
+	TC4->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+	stimerUsCallback = funct;
+	deadline = stimerNowUs() + us;
+	/* Compare sees count of TC4, it does not include slept time */
+	TC4->COUNT32.CC[0].reg = deadline - stimerUsOffset;
+	while(TC4->COUNT32.STATUS.bit.SYNCBUSY == 1) {}
+	TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+	NVIC_ClearPendingIRQ(TC4_IRQn);
+	TC4->COUNT32.INTENSET.reg = TC_INTENSET_MC0;
+	/* Short deadline may pass before compare is written */
+	if((int32_t)(stimerNowUs() - deadline) >= 0)
+	{
+		NVIC_SetPendingIRQ(TC4_IRQn);
+	}
+	system_interrupt_leave_critical_section();
 	return 1;
-}
\ No newline at end of file
+}
+
+/**
+* @brief     Cancels deadline, its callback is not called
+*/
+void stimerUsDeadlineCancel (void)
+{
+	system_interrupt_enter_critical_section();
+	TC4->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+	stimerUsCallback = 0;
+	NVIC_ClearPendingIRQ(TC4_IRQn);
+	system_interrupt_leave_critical_section();
+}
+#endif
\ No newline at end of file
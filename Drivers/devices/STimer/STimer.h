@@ -14,7 +14,7 @@
 /**
 * @file		STimer.h
 * @date		22.10.2019
-* @version	0.1
+* @version	0.9
 * @brief	Software emulated timer
 *
 * @details
@@ -39,6 +39,62 @@
 * 3. If mode is set to timer, set expiry time and auto reload
 * 4. If you want, set callback function
 * 5. Start the timer
+*
+* More timers, than channels, are created with stimerCreate and used through
+* handles returned by it, stimerHandle functions are the same as channel functions.
+* Channels are the first STIMER_NBR timers of a pool of STIMER_POOL_NBR timers,
+* stimerGetHandle returns their handles. Handle of deleted timer is not valid any
+* more, also when its timer is created again. Running timers are kept in a
+* hierarchical timer wheel, so start, stop and expiry do not depend on number of
+* timers.
+*
+* If STIMER_TICKLESS is 1, TC3 does not interrupt every ms. TC3 counts freely and
+* its compare is set to the next slot of wheel, which holds timers, so interrupt
+* only serves expired timers. Without running timers TC3 interrupts only every
+* STIMER_SHOT_MAX ms to keep the time, so the CPU can sleep between events.
+* Resolution stays 1 ms in both modes.
+*
+* Callback of each timer runs on the level set by stimerSetLevel. On
+* STIMER_LEVEL_ISR it is called from TC3 interrupt, as timers, which must be
+* exact, need. On STIMER_LEVEL_DEFERRED interrupt only marks the timer and pends
+* PendSV, which calls the callback at the lowest priority, so slow callbacks do
+* not delay other timers and interrupts. On STIMER_LEVEL_MAIN callback is called
+* from stimerDispatch, which must be called from main loop, and main loop must not
+* sleep while stimerDispatchPending returns 1. Expirations, that
+* happen before deferred callback is called, are merged into one call. Driver
+* uses PendSV_Handler.
+*
+* If STIMER_US is 1, TC4 and TC5 run as one free running 32 bit counter at 1 MHz,
+* which wraps after 71 minutes. stimerNowUs returns its value, it can be used as
+* time stamp and as clock of I2C statistics. stimerUsWatch functions measure time
+* in us with stopwatches kept by caller. One deadline at a time is set with
+* stimerUsDeadlineSet, its callback is called from TC4 interrupt. Driver uses
+* TC4_Handler.
+*
+* stimerUptimeMs and stimerUptimeUs return monotonic 64 bit time since stimerInit,
+* that does not wrap. They do not disable interrupts and can be called from any
+* context. Functions, that change a timer, do it with interrupts disabled, so TC3
+* interrupt never sees a half changed timer.
+*
+* Auto reload timers are periodic on an absolute timeline: next expiry is counted
+* from previous expiry, not from the time it was served, so late interrupts and
+* callbacks do not cause drift. If STIMER_STATS is 1, each timer counts overruns
+* and keeps minimum, average and maximum lateness of its callback in us, read with
+* stimerGetStats.
+*
+* If STIMER_RTC is 1, timers can also run on RTC clocked from 32 kHz oscillator,
+* which counts also in STANDBY. stimerSetResolution puts a timer, that needs
+* resolution of STIMER_RTC_RESOLUTION ms or coarser, on RTC, other timers stay on
+* TC3. stimerSleep sleeps in STANDBY, when no timer runs on TC3, so board sleeps
+* deeply between slow periodic jobs. TC3 and TC4 stop in STANDBY, slept time is
+* measured with RTC and added to them, so ms and us clocks and stopwatches go on.
+* Driver uses RTC_Handler.
+*
+* Callback registered with stimerRegisterCallbackCtx gets a context pointer, so
+* a driver can keep its state there instead of in globals. Callback may set,
+* start, stop or delete its own timer. Stop cancels auto reload. Set time and
+* start count from the expiry, that callback serves, so new period continues the
+* timeline of the timer also when callback runs late on a deferred level.
 */
 
 
@@ -55,18 +111,58 @@
 ****************************************************************************************/
 /** @brief Maximum number of channels */
 #define STIMER_NBR	5
+/** @brief Number of all timers including channels, at most 255 */
+#define STIMER_POOL_NBR	32
+/** @brief Handle, that does not belong to any timer */
+#define STIMER_HANDLE_NONE	0
+/** @brief 1 to interrupt only when a timer expires, 0 to interrupt every ms */
+#define STIMER_TICKLESS	1
+/** @brief Priority of PendSV, which calls deferred callbacks, 3 is the lowest */
+#define STIMER_DEFERRED_PRIO	3
+/** @brief 1 to run microsecond clock on TC4 and TC5 */
+#define STIMER_US	1
+/** @brief 1 to measure lateness of callbacks and count overruns */
+#define STIMER_STATS	1
+/** @brief 1 to run low resolution timers on RTC */
+#define STIMER_RTC	1
+/** @brief Timers with resolution of this many ms or more run on RTC */
+#define STIMER_RTC_RESOLUTION	10
+/** @brief Generic clock generator, that divides OSCULP32K to 1024 Hz for RTC */
+#define STIMER_RTC_GCLK	4
 
 /****************************************************************************************
 * Type definitions
 ****************************************************************************************/
+
+/** @brief Where callback of a timer is called */
+typedef enum
+{
+	STIMER_LEVEL_ISR,			/**< From TC3 interrupt */
+	STIMER_LEVEL_DEFERRED,		/**< From PendSV interrupt, at the lowest priority */
+	STIMER_LEVEL_MAIN			/**< From stimerDispatch in main loop */
+}stimerLevel_t;
+
+/** @brief Handle of a timer */
+typedef uint16_t stimerHandle_t;
+
+/** @brief Stopwatch with us resolution */
+typedef struct
+{
+	uint32_t start;		/**< Time of start in us */
+	uint32_t time;		/**< Time measured before start in us */
+	uint8_t running;	/**< Stopwatch is running */
+}stimerUsWatch_t;
+
+/** @brief Lateness statistics of a timer */
 typedef struct
 {
-	uint32_t time;
-	uint8_t running;
-	uint8_t stopwatch; // if true timer is upcounting and callback function is disabled
-	uint32_t auto_reload;
-	volatile void (*function) (void);
-}stimer_ch_t;
+	uint32_t count;		/**< Measured expiries */
+	uint32_t overruns;	/**< Missed periods and expiries merged into waiting callback */
+	uint32_t lateMin;	/**< Minimum time from expiry to callback in us */
+	uint32_t lateMax;	/**< Maximum time from expiry to callback in us */
+	uint32_t lateAvg;	/**< Average time from expiry to callback in us */
+	uint32_t jitter;	/**< Difference of maximum and minimum lateness in us */
+}stimerStats_t;
 
 /****************************************************************************************
 * Function prototypes
@@ -80,7 +176,49 @@ uint32_t stimerGetTime (uint8_t timer);
 uint32_t stimerSetAsStopwatch (uint8_t timer);
 uint32_t stimerSetAsTimer (uint8_t timer);
 uint32_t stimerRegisterCallback (uint8_t timer, void(*funct)(void));
+uint32_t stimerRegisterCallbackCtx (uint8_t timer, void(*funct)(void *ctx), void *ctx);
 uint32_t stimerUnregisterCallback (uint8_t timer);
+uint32_t stimerSetLevel (uint8_t timer, stimerLevel_t level);
+void stimerDispatch (void);
+uint32_t stimerDispatchPending (void);
+uint64_t stimerUptimeMs (void);
+#if STIMER_RTC
+uint32_t stimerSetResolution (uint8_t timer, uint32_t ms);
+uint32_t stimerHandleSetResolution (stimerHandle_t handle, uint32_t ms);
+void stimerSleep (void);
+#endif
+#if STIMER_STATS
+uint32_t stimerGetStats (uint8_t timer, stimerStats_t *stats);
+uint32_t stimerStatsReset (uint8_t timer);
+uint32_t stimerHandleGetStats (stimerHandle_t handle, stimerStats_t *stats);
+uint32_t stimerHandleStatsReset (stimerHandle_t handle);
+#endif
+stimerHandle_t stimerCreate (void(*funct)(void), stimerLevel_t level);
+stimerHandle_t stimerCreateCtx (void(*funct)(void *ctx), void *ctx, stimerLevel_t level);
+uint32_t stimerDelete (stimerHandle_t handle);
+stimerHandle_t stimerGetHandle (uint8_t timer);
+uint32_t stimerHandleSetTime (stimerHandle_t handle, uint32_t t, uint8_t autoreload);
+uint32_t stimerHandleStart (stimerHandle_t handle);
+uint32_t stimerHandleStop (stimerHandle_t handle);
+uint32_t stimerHandleReset (stimerHandle_t handle);
+uint32_t stimerHandleGetTime (stimerHandle_t handle);
+uint32_t stimerHandleSetAsStopwatch (stimerHandle_t handle);
+uint32_t stimerHandleSetAsTimer (stimerHandle_t handle);
+uint32_t stimerHandleRegisterCallback (stimerHandle_t handle, void(*funct)(void));
+uint32_t stimerHandleRegisterCallbackCtx (stimerHandle_t handle, void(*funct)(void *ctx), void *ctx);
+uint32_t stimerHandleUnregisterCallback (stimerHandle_t handle);
+uint32_t stimerHandleSetLevel (stimerHandle_t handle, stimerLevel_t level);
+#if STIMER_US
+uint32_t stimerNowUs (void);
+uint64_t stimerUptimeUs (void);
+void stimerDelayUs (uint32_t us);
+void stimerUsWatchReset (stimerUsWatch_t *watch);
+void stimerUsWatchStart (stimerUsWatch_t *watch);
+void stimerUsWatchStop (stimerUsWatch_t *watch);
+uint32_t stimerUsWatchGet (const stimerUsWatch_t *watch);
+uint32_t stimerUsDeadlineSet (uint32_t us, void(*funct)(void));
+void stimerUsDeadlineCancel (void);
+#endif
 
 
 
@@ -30,93 +30,173 @@
 #include "ugui/ugui.h"
 
 #include "I2C_Int.h"
+#include "I2C_Script.h"
 #include <stdint.h>
 
 /****************************************************************************************
 * Global variables
 ****************************************************************************************/
-/** @brief uGui display object */
-UG_GUI Gui;
-/** @brief Display buffer */
-uint8_t displayBuffer[128 * 64 / 8]; // 128 * 8 display resolution 
-/** @brief I2C Display packet object */
-i2cIntPacket_t displayI2CPacket;
+/** @brief Default canvas, with uGui display object and display buffer */
+displayCanvas_t displayMainCanvas;
+/** @brief Canvas selected for drawing */
+static displayCanvas_t *displaySelectedCanvas = &displayMainCanvas;
+/** @brief Buffer in which pset draws, buffer of selected canvas */
+static uint8_t *displayDrawBuffer = displayMainCanvas.buffer;
+/** @brief Canvas that is sent to display */
+static displayCanvas_t *displayShownCanvas = &displayMainCanvas;
+/** @brief I2C jobs sending display pages in background */
+static i2cIntJob_t displayPageJob[SSD1306_HEIGHT / 8];
+/** @brief I2C packets of display page jobs */
+static i2cIntPacket_t displayPagePacket[SSD1306_HEIGHT / 8];
+/** @brief Window comands sent in front of each display page */
+static uint8_t displayPageCmd[SSD1306_HEIGHT / 8][DISPLAY_PAGE_CMD_LEN];
+/** @brief Buffers chained into display page transactions */
+static i2cIntVec_t displayPageVec[SSD1306_HEIGHT / 8][2];
+/** @brief One page of blank pixels, used for clearing the display */
+static const uint8_t displayBlankPage[SSD1306_WIDTH];
+/** @brief Display initialization script, all comands are sent in one transfer */
+static const uint8_t displayInitScript[] =
+{
+	I2C_SCRIPT_STREAM(0x00, SSD1306_DISPLAYOFF,
+					  SSD1306_SETDISPLAYCLOCKDIV, 0x80,
+					  SSD1306_SETMULTIPLEX, 0x3F,
+					  SSD1306_SETDISPLAYOFFSET, 0x00,
+					  SSD1306_SETSTARTLINE | 0x00),
+	// We use internal charge pump
+	I2C_SCRIPT_STREAM(0x00, SSD1306_CHARGEPUMP, 0x14),
+	// Horizontal memory mode
+	I2C_SCRIPT_STREAM(0x00, SSD1306_MEMORYMODE, 0x00,
+					  SSD1306_SEGREMAP | 0x1,
+					  SSD1306_COMSCANDEC,
+					  SSD1306_SETCOMPINS, 0x12),
+	// Max contrast, non-inverted display, turn display back on
+	I2C_SCRIPT_STREAM(0x00, SSD1306_SETCONTRAST, 0xCF,
+					  SSD1306_SETPRECHARGE, 0xF1,
+					  SSD1306_SETVCOMDETECT, 0x40,
+					  SSD1306_DISPLAYALLON_RESUME,
+					  SSD1306_NORMALDISPLAY,
+					  SSD1306_DISPLAYON),
+	I2C_SCRIPT_END
+};
 
 
 
 /**
- * @brief Writes data do dispaly registers
+ * @brief Initiates I2C interface in microcontroller
  *
- * @param reg_addr Register addres
- * @param value Value to write to register
  */
-static void display_write_reg (uint8_t reg_addr, uint8_t value)
+static void twi_init (void)
 {
-	
-	displayI2CPacket.regAddress = reg_addr;
-	displayI2CPacket.regAddrLen = 1;
-	displayI2CPacket.txBuff = &value;	
-	displayI2CPacket.txLen = 1;
-	
-	i2cIntTx(&displayI2CPacket);
+	i2cIntInit(400);
+	/* Sensor transfers can run between display pages */
+	i2cIntSetDevicePriority(DISPLAY_ADR, I2C_INT_PRIO_LOW);
+	/* Display is written much more than other devices, so it runs as fast as it is allowed */
+	i2cIntSetDeviceClock(DISPLAY_ADR, DISPLAY_I2C_CLK);
 }
-
 /**
- * @brief Writes comand to display
+ * @brief Writes a part of one page of data to display
  *
- * @param com Comand number
- */
-static void display_comand (uint8_t com)
-{
-	display_write_reg(0, com);
-}
-
-/**
- * @brief Writes data to display
+ * Column and page window comands, data control byte and the data are chained
+ * into a single I2C transaction, which is queued and sent in background without
+ * copying the data. Display works in horizontal addressing mode, so the window
+ * limits writing to the slice. Transactions sent later are queued behind it, so
+ * they are executed in the right order.
  *
- * @param data Data to be written
+ * @param page Page number
+ * @param col First column
+ * @param len Number of columns
+ * @param data Data of the slice, must stay unchanged until it is sent
  */
-static void display_data (uint8_t data)
+static void display_write_page (uint8_t page, uint8_t col, uint8_t len, const uint8_t *data)
 {
-	display_write_reg(64, data);
+	uint8_t *cmd = displayPageCmd[page];
+	i2cIntVec_t *vec = displayPageVec[page];
+	
+	/* Comands and vector of this page can only be changed after previous slice is sent */
+	i2cIntJobWait(&displayPageJob[page]);
+	/* Each comand byte is preceded by control byte with Co bit set */
+	cmd[0] = 0x80;
+	cmd[1] = SSD1306_COLUMNADDR;
+	cmd[2] = 0x80;
+	cmd[3] = col;
+	cmd[4] = 0x80;
+	cmd[5] = col + len - 1;
+	cmd[6] = 0x80;
+	cmd[7] = SSD1306_PAGEADDR;
+	cmd[8] = 0x80;
+	cmd[9] = page;
+	cmd[10] = 0x80;
+	cmd[11] = page;
+	/* Rest of transaction is data */
+	cmd[12] = 0x40;
+	vec[0].data = cmd;
+	vec[0].len = DISPLAY_PAGE_CMD_LEN;
+	vec[1].data = data;
+	vec[1].len = len;
+	
+	displayPagePacket[page].deviceAddress = DISPLAY_ADR;
+	displayPagePacket[page].regAddrLen = 0;
+	i2cIntSubmitTxv(&displayPageJob[page], &displayPagePacket[page], vec, 2, NULL);
 }
 
 /**
- * @brief Initiates I2C interface in microcontroller
+ * @brief Writes a part of one page of display buffer to display
  *
+ * @param page Page number
+ * @param col First column
+ * @param len Number of columns
  */
-static void twi_init (void)
+static void display_write_slice (uint8_t page, uint8_t col, uint8_t len)
 {
-	displayI2CPacket.deviceAddress = DISPLAY_ADR;	
-	i2cIntInit(400);
+	display_write_page(page, col, len, &displayShownCanvas->buffer[(page * SSD1306_WIDTH) + col]);
 }
+
 /**
- * @brief Selects a column to write to
+ * @brief Sorts corners of an area and clips it to the display
  *
- * @param col Selected column
+ * @param x1 First X coordinate, left edge on return
+ * @param y1 First Y coordinate, top edge on return
+ * @param x2 Second X coordinate, right edge on return
+ * @param y2 Second Y coordinate, bottom edge on return
+ * @return 1 if some part of area is on display, 0 if it is completely outside
  */
-static void display_select_column (uint8_t col)
+static uint8_t display_clip_area (int16_t *x1, int16_t *y1, int16_t *x2, int16_t *y2)
 {
-	if(col > 128)
+	int16_t tmp;
+	
+	if(*x2 < *x1)
 	{
-		col = 128;
+		tmp = *x1;
+		*x1 = *x2;
+		*x2 = tmp;
 	}
-	display_comand(0x0F & (uint8_t)col);
-	display_comand(0x10 | (col >> 4));
-}
-
-/**
- * @brief Selects a row to write to
- *
- * @param row Selected row
- */
-static void display_select_row (uint8_t row)
-{
-	if(row > 8)
+	if(*y2 < *y1)
+	{
+		tmp = *y1;
+		*y1 = *y2;
+		*y2 = tmp;
+	}
+	if((*x2 < 0) || (*y2 < 0) || (*x1 >= SSD1306_WIDTH) || (*y1 >= SSD1306_HEIGHT))
+	{
+		return 0;
+	}
+	if(*x1 < 0)
+	{
+		*x1 = 0;
+	}
+	if(*y1 < 0)
+	{
+		*y1 = 0;
+	}
+	if(*x2 >= SSD1306_WIDTH)
 	{
-		row = 8;
+		*x2 = SSD1306_WIDTH - 1;
 	}
-	display_comand(0xB0 | row);
+	if(*y2 >= SSD1306_HEIGHT)
+	{
+		*y2 = SSD1306_HEIGHT - 1;
+	}
+	return 1;
 }
 
 
@@ -127,42 +207,52 @@ static void display_select_row (uint8_t row)
  * @param y Y coordinate
  * @param c C color
  */
-void pset(UG_U16 x, UG_U16 y, UG_COLOR c)
+void pset(UG_S16 x, UG_S16 y, UG_COLOR c)
 {
-	unsigned int i,p;
+	unsigned int p;
 
-	if ( x > 127 ) return;
+	if((x < 0) || (x >= SSD1306_WIDTH) || (y < 0) || (y >= SSD1306_HEIGHT))
+	{
+		return;
+	}
 	p = y>>3; // :8
 	p = p<<7; // *128
 	p +=x;
 
 	if( c )
 	{
-		displayBuffer[p] |= 1 << (y % 8);
+		displayDrawBuffer[p] |= 1 << (y % 8);
 	}
 	else
 	{
-		displayBuffer[p] &= ~(1 << (y % 8));
+		displayDrawBuffer[p] &= ~(1 << (y % 8));
 	}
 
 }
 
+/**
+ * @brief Returns pointer to buffer of selected canvas
+ *
+ * Buffer is organized as display RAM: 8 pages of 128 bytes, each byte holds
+ * 8 vertical pixels with the top one in bit 0.
+ *
+ * @return Pointer to display buffer
+ */
+uint8_t *displayGetBuffer (void)
+{
+	return displayDrawBuffer;
+}
+
 /**
  * @brief Clear the dispaly
  *
  */
 void displayClear (void)
 {
-	uint8_t page, col;
-	for(page = 0; page < 8; page++)
+	uint8_t page;
+	for(page = 0; page < (SSD1306_HEIGHT / 8); page++)
 	{
-		display_select_row(page);
-		display_select_column(0);
-		for(col = 0; col < 128; col++)
-		{
-			display_data(0x00);
-		}
-		
+		display_write_page(page, 0, SSD1306_WIDTH, displayBlankPage);
 	}
 }
 
@@ -175,72 +265,239 @@ void displayInit (void)
 {
 	
 	twi_init();
-	display_comand(SSD1306_DISPLAYOFF);
-
-	display_comand(SSD1306_SETDISPLAYCLOCKDIV);
-	display_comand(0x80);
-
-	display_comand(SSD1306_SETMULTIPLEX);
-	display_comand(0x3F);
-	
-	display_comand(SSD1306_SETDISPLAYOFFSET);
-	display_comand(0x00);
-	
-	display_comand(SSD1306_SETSTARTLINE | 0x00);
-	
-	// We use internal charge pump
-	display_comand(SSD1306_CHARGEPUMP);
-	display_comand(0x14);
-	
-	// Horizontal memory mode
-	display_comand(SSD1306_MEMORYMODE);
-	display_comand(0x00);
+	i2cScriptRun(NULL, DISPLAY_ADR, displayInitScript, NULL);
+		
+	displayClear();
+	UG_Init(&displayMainCanvas.gui, pset, SSD1306_WIDTH, SSD1306_HEIGHT);
 	
-	display_comand(SSD1306_SEGREMAP | 0x1);
-
-	display_comand(SSD1306_COMSCANDEC);
 
-	display_comand(SSD1306_SETCOMPINS);
-	display_comand(0x12);
+}
 
-	// Max contrast
-	display_comand(SSD1306_SETCONTRAST);
-	display_comand(0xCF);
+ 
+/**
+ * @brief Waits until all queued display pages are sent
+ *
+ * Pages are sent from the buffer in background. Call this before drawing, if
+ * display must not show partly drawn content.
+ */
+void displayWait (void)
+{
+	uint8_t page;
+	for(page = 0; page < (SSD1306_HEIGHT / 8); page++)
+	{
+		i2cIntJobWait(&displayPageJob[page]);
+	}
+}
 
-	display_comand(SSD1306_SETPRECHARGE);
-	display_comand(0xF1);
+/**
+ * @brief Draws data from buffer to display
+ *
+ * Function returns as soon as all pages are queued, pages are sent in
+ * background.
+ */
+void displayUpdate (void)
+{
+	uint8_t page;
+	for(page = 0; page < (SSD1306_HEIGHT / 8); page++)
+	{
+		display_write_slice(page, 0, SSD1306_WIDTH);
+	}
+}
 
-	display_comand(SSD1306_SETVCOMDETECT);
-	display_comand(0x40);
 
-	display_comand(SSD1306_DISPLAYALLON_RESUME);
+/**
+ * @brief Draws only a rectangular area of buffer to display
+ *
+ * Area is expanded to whole pages (8 pixel rows), because display RAM can only
+ * be written in bytes. Use this function instead of displayUpdate, when only
+ * small part of the screen has changed.
+ *
+ * @param x1 X coordinate of first corner
+ * @param y1 Y coordinate of first corner
+ * @param x2 X coordinate of opposite corner
+ * @param y2 Y coordinate of opposite corner
+ */
+void displayUpdateArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	uint8_t page, page1, page2;
+	
+	if(!display_clip_area(&x1, &y1, &x2, &y2))
+	{
+		return;
+	}
+	
+	page1 = (uint8_t)(y1 >> 3);
+	page2 = (uint8_t)(y2 >> 3);
+	for(page = page1; page <= page2; page++)
+	{
+		display_write_slice(page, (uint8_t)x1, (uint8_t)(x2 - x1 + 1));
+	}
+}
 
-	// Non-inverted display
-	display_comand(SSD1306_NORMALDISPLAY);
+/**
+ * @brief Inverts all pixels of an area in selected canvas
+ *
+ * Used for highlighting, inverting the same area again removes the highlight.
+ * Display is not updated.
+ *
+ * @param x1 X coordinate of first corner
+ * @param y1 Y coordinate of first corner
+ * @param x2 X coordinate of opposite corner
+ * @param y2 Y coordinate of opposite corner
+ */
+void displayInvertArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+	int16_t x, y;
+	uint8_t page, mask;
+	uint8_t *p;
 	
-	// Turn display back on
-	display_comand(SSD1306_DISPLAYON);
-		
-	displayClear();
-	UG_Init(&Gui, pset, 128, 64);
+	if(!display_clip_area(&x1, &y1, &x2, &y2))
+	{
+		return;
+	}
 	
+	y = y1;
+	while(y <= y2)
+	{
+		/* Mask of rows y..y2 inside current page */
+		page = (uint8_t)(y >> 3);
+		mask = (uint8_t)(0xFF << (y & 7));
+		if((y2 >> 3) == page)
+		{
+			mask &= (uint8_t)(0xFF >> (7 - (y2 & 7)));
+		}
+		p = &displayDrawBuffer[(page * SSD1306_WIDTH) + x1];
+		for(x = x1; x <= x2; x++)
+		{
+			*p++ ^= mask;
+		}
+		y = (int16_t)((page + 1) * 8);
+	}
+}
 
+/**
+ * @brief Moves content of an area in selected canvas up or down
+ *
+ * Pixels moved out of the area are lost, rows that are uncovered are cleared.
+ * Pixels outside of the area are not changed. This is much faster than
+ * drawing the content again, for example when scrolling a list. Display is
+ * not updated.
+ *
+ * @param x1 X coordinate of first corner
+ * @param y1 Y coordinate of first corner
+ * @param x2 X coordinate of opposite corner
+ * @param y2 Y coordinate of opposite corner
+ * @param dy Number of pixels to move, positive moves down, negative moves up
+ */
+void displayScrollArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t dy)
+{
+	int16_t x;
+	uint8_t page, page1, page2;
+	uint64_t column, mask;
+	
+	if(!display_clip_area(&x1, &y1, &x2, &y2) || (dy == 0))
+	{
+		return;
+	}
+	
+	/* Each column of the display fits in 64 bits, top pixel is bit 0 */
+	page1 = (uint8_t)(y1 >> 3);
+	page2 = (uint8_t)(y2 >> 3);
+	mask = (~(uint64_t)0 >> (63 - (y2 - y1))) << y1;
+	for(x = x1; x <= x2; x++)
+	{
+		column = 0;
+		for(page = page1; page <= page2; page++)
+		{
+			column |= (uint64_t)displayDrawBuffer[(page * SSD1306_WIDTH) + x] << (page * 8);
+		}
+		if((dy >= SSD1306_HEIGHT) || (dy <= -SSD1306_HEIGHT))
+		{
+			column &= ~mask;
+		}
+		else if(dy > 0)
+		{
+			column = (column & ~mask) | (((column & mask) << dy) & mask);
+		}
+		else
+		{
+			column = (column & ~mask) | (((column & mask) >> -dy) & mask);
+		}
+		for(page = page1; page <= page2; page++)
+		{
+			displayDrawBuffer[(page * SSD1306_WIDTH) + x] = (uint8_t)(column >> (page * 8));
+		}
+	}
 }
 
- 
+
 /**
- * @brief Draws data from buffer to display
+ * @brief Initializes an off-screen canvas
+ *
+ * Canvas gets its own uGui object and cleared buffer. Selected canvas
+ * does not change.
  *
+ * @param canvas Pointer to canvas
  */
-void displayUpdate (void)
+void displayCanvasInit (displayCanvas_t *canvas)
 {
 	uint32_t n;
-	display_select_column(0);
-	display_select_row(0);
-	for(n = 0; n < (128 * 64 / 8); n++)
+	
+	for(n = 0; n < SSD1306_BUFFERSIZE; n++)
+	{
+		canvas->buffer[n] = 0;
+	}
+	/* UG_Init also selects the new object, so previous selection is restored */
+	UG_Init(&canvas->gui, pset, SSD1306_WIDTH, SSD1306_HEIGHT);
+	UG_SelectGUI(&displaySelectedCanvas->gui);
+}
+
+/**
+ * @brief Selects canvas for drawing
+ *
+ * All uGui functions, sprites and displayDrawImage draw to selected canvas.
+ * Font and colors are kept separately for each canvas.
+ *
+ * @param canvas Pointer to canvas, NULL selects default canvas
+ */
+void displayCanvasSelect (displayCanvas_t *canvas)
+{
+	if(!canvas)
+	{
+		canvas = &displayMainCanvas;
+	}
+	displaySelectedCanvas = canvas;
+	displayDrawBuffer = canvas->buffer;
+	UG_SelectGUI(&canvas->gui);
+}
+
+/**
+ * @brief Returns canvas selected for drawing
+ *
+ * @return Pointer to selected canvas
+ */
+displayCanvas_t *displayGetCanvas (void)
+{
+	return displaySelectedCanvas;
+}
+
+/**
+ * @brief Shows canvas on display
+ *
+ * Canvas becomes the source for displayUpdate and displayUpdateArea and
+ * is sent to display. Nothing is redrawn, so a screen rendered in advance
+ * is shown in the time of one display update.
+ *
+ * @param canvas Pointer to canvas, NULL shows default canvas
+ */
+void displayCanvasShow (displayCanvas_t *canvas)
+{
+	if(!canvas)
 	{
-		display_data(displayBuffer[n]);
+		canvas = &displayMainCanvas;
 	}
+	displayShownCanvas = canvas;
+	displayUpdate();
 }
 
 
@@ -251,7 +508,7 @@ void displayUpdate (void)
  * @param y Y size of image
  * @param img Pointer to the image
  */
-void displayDrawImage (uint32_t x_size, uint32_t y_size, uint8_t *img)
+void displayDrawImage (uint32_t x_size, uint32_t y_size, const uint8_t *img)
 {
 	uint32_t x, y, n, byte;
 	for(y = 0; y < y_size; y++)
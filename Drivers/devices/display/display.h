@@ -20,6 +20,13 @@
 *			please see https://embeddedlightning.com/ugui/
 * @date		21.10.2019
 * @version	0.1
+*
+* @details
+* Drawing is done in a canvas, which is a display buffer with its own uGui object.
+* Driver has one default canvas. Additional canvases can be created to render other
+* screens off-screen. displayCanvasSelect chooses the canvas that is drawn to and
+* displayCanvasShow chooses the canvas that is sent to display, so switching to a
+* screen rendered in advance costs only one display update.
 */
 
 #ifndef DISPLAY_H_
@@ -39,6 +46,13 @@
 
 /** @brief Display I2C address */
 #define DISPLAY_ADR		0x3C
+/** @brief Display I2C clock in kHz. SSD1306 is specified for 400 kHz, a board can
+	define 1000 (Fast-mode Plus), after its display has been tested at that clock */
+#ifndef DISPLAY_I2C_CLK
+#define DISPLAY_I2C_CLK	400
+#endif
+/** @brief Length of window comands and data control byte in front of each page */
+#define DISPLAY_PAGE_CMD_LEN	13
 
 /* Various display commands. Please see datasheet of SSD1306 */
 #define SSD1306_DEFAULT_ADDRESS 0x78
@@ -73,16 +87,37 @@
 /** @brief Display height in pixels */
 #define SSD1306_HEIGHT 64
 /** @brief SIze of display buffer in bytes */
-#define SSD1306_BUFFERSIZE (SSD1306_WIDTH*SSD1306_HEIGHT)/8
+#define SSD1306_BUFFERSIZE ((SSD1306_WIDTH*SSD1306_HEIGHT)/8)
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Drawing surface with its own uGui object and display buffer */
+typedef struct
+{
+	UG_GUI gui;								/**< uGui object drawing to this canvas */
+	uint8_t buffer[SSD1306_BUFFERSIZE];		/**< Canvas pixels in display RAM format */
+}displayCanvas_t;
+
 
 /****************************************************************************************
 * Function prototypes
 ****************************************************************************************/
 void displayInit (void); /* Initializes I2c and display */
 void displayClear (void); /*Clears display */
-void pset(UG_U16 x, UG_U16 y, UG_COLOR c);
+void pset(UG_S16 x, UG_S16 y, UG_COLOR c);
 void displayUpdate (void);
-void displayDrawImage (uint32_t x_size, uint32_t y_size, uint8_t *img);
+void displayWait (void);
+void displayUpdateArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+void displayDrawImage (uint32_t x_size, uint32_t y_size, const uint8_t *img);
+void displayInvertArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+void displayScrollArea (int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t dy);
+uint8_t *displayGetBuffer (void);
+void displayCanvasInit (displayCanvas_t *canvas);
+void displayCanvasSelect (displayCanvas_t *canvas);
+displayCanvas_t *displayGetCanvas (void);
+void displayCanvasShow (displayCanvas_t *canvas);
 
 
 
@@ -0,0 +1,379 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		menu.c
+* @brief	Event driven menu for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <string.h>
+#include "menu.h"
+#include "display.h"
+
+
+/**
+ * @brief Returns Y coordinate of the row in which item is shown
+ *
+ * @param menu Pointer to menu object
+ * @param index Index of visible item
+ * @return Y coordinate of top of the row
+ */
+static UG_S16 menu_row_y (menu_t *menu, uint8_t index)
+{
+	return menu->listY + ((index - menu->top) * menu->rowHeight);
+}
+
+/**
+ * @brief Draws string with menu font, at most len characters
+ *
+ * @param menu Pointer to menu object
+ * @param x X coordinate of first character
+ * @param y Y coordinate of first character
+ * @param str String to draw
+ * @param len Maximum number of characters
+ */
+static void menu_put_text (menu_t *menu, UG_S16 x, UG_S16 y, const char *str, int16_t len)
+{
+	while((len > 0) && *str)
+	{
+		UG_PutChar(*str, x, y, C_WHITE, C_BLACK);
+		x += menu->font->char_width + 1;
+		str++;
+		len--;
+	}
+}
+
+/**
+ * @brief Inverts row of an item, which adds or removes highlight
+ *
+ * @param menu Pointer to menu object
+ * @param index Index of visible item
+ */
+static void menu_invert_row (menu_t *menu, uint8_t index)
+{
+	UG_S16 y = menu_row_y(menu, index);
+	displayInvertArea(menu->area.xs, y, menu->area.xe, y + menu->rowHeight - 1);
+}
+
+/**
+ * @brief Draws row of visible item to display buffer
+ *
+ * @param menu Pointer to menu object
+ * @param index Index of visible item
+ */
+static void menu_draw_row (menu_t *menu, uint8_t index)
+{
+	const menuItem_t *item = &menu->page->items[index];
+	const char *value = NULL;
+	UG_S16 y, pitch, textX, valueX;
+	int16_t len;
+
+	y = menu_row_y(menu, index);
+	pitch = menu->font->char_width + 1;
+	textX = menu->area.xs + 1;
+	UG_FillFrame(menu->area.xs, y, menu->area.xe, y + menu->rowHeight - 1, C_BLACK);
+
+	/* Value is aligned to the right, label is cut so that it does not overlap it */
+	valueX = menu->area.xe + 1;
+	if(item->value)
+	{
+		value = item->value();
+	}
+	if(value)
+	{
+		len = (int16_t)strlen(value);
+		valueX = menu->area.xe - (len * pitch) + 1;
+		if(valueX < textX)
+		{
+			valueX = textX;
+		}
+		menu_put_text(menu, valueX, y + 1, value, len);
+		valueX -= pitch;
+	}
+	menu_put_text(menu, textX, y + 1, item->label, (valueX - textX) / pitch);
+
+	if(index == menu->selected)
+	{
+		menu_invert_row(menu, index);
+	}
+}
+
+/**
+ * @brief Clears list area and draws all visible items
+ *
+ * First row is moved if needed, so that selected item is visible.
+ *
+ * @param menu Pointer to menu object
+ */
+static void menu_draw_list (menu_t *menu)
+{
+	uint8_t n;
+
+	if(menu->selected < menu->top)
+	{
+		menu->top = menu->selected;
+	}
+	else if(menu->selected >= (menu->top + menu->rows))
+	{
+		menu->top = menu->selected - menu->rows + 1;
+	}
+
+	UG_FillFrame(menu->area.xs, menu->listY, menu->area.xe, menu->area.ye, C_BLACK);
+	for(n = menu->top; (n < menu->page->count) && (n < (menu->top + menu->rows)); n++)
+	{
+		menu_draw_row(menu, n);
+	}
+}
+
+/**
+ * @brief Draws title and items of current page and sends menu area to display
+ *
+ * @param menu Pointer to menu object
+ */
+static void menu_draw_page (menu_t *menu)
+{
+	UG_S16 y;
+
+	y = menu->area.ys;
+	UG_FillFrame(menu->area.xs, y, menu->area.xe, menu->area.ye, C_BLACK);
+	if(menu->page->title)
+	{
+		menu_put_text(menu, menu->area.xs + 1, y, menu->page->title,
+					  (menu->area.xe - menu->area.xs) / (menu->font->char_width + 1));
+		y += menu->font->char_height + 1;
+		UG_DrawLine(menu->area.xs, y, menu->area.xe, y, C_WHITE);
+		y += 2;
+	}
+	menu->listY = y;
+	menu->rows = (uint8_t)((menu->area.ye - y + 1) / menu->rowHeight);
+	if(!menu->rows)
+	{
+		menu->rows = 1;
+	}
+
+	menu_draw_list(menu);
+	displayUpdateArea(menu->area.xs, menu->area.ys, menu->area.xe, menu->area.ye);
+}
+
+/**
+ * @brief Moves selection to another item
+ *
+ * If new item is visible, only highlight is moved. If it is right above or below
+ * visible rows, list is scrolled by one row in display buffer and only new row
+ * is drawn. Otherwise all visible rows are drawn again.
+ *
+ * @param menu Pointer to menu object
+ * @param index Index of item to select
+ */
+static void menu_move (menu_t *menu, uint8_t index)
+{
+	uint8_t old = menu->selected;
+	UG_S16 listEnd = menu->listY + (menu->rows * menu->rowHeight) - 1;
+
+	if(index == old)
+	{
+		return;
+	}
+	menu_invert_row(menu, old);
+	menu->selected = index;
+
+	if((index >= menu->top) && (index < (menu->top + menu->rows)))
+	{
+		menu_invert_row(menu, index);
+		if(index < old)
+		{
+			displayUpdateArea(menu->area.xs, menu_row_y(menu, index), menu->area.xe,
+							  menu_row_y(menu, old) + menu->rowHeight - 1);
+		}
+		else
+		{
+			displayUpdateArea(menu->area.xs, menu_row_y(menu, old), menu->area.xe,
+							  menu_row_y(menu, index) + menu->rowHeight - 1);
+		}
+		return;
+	}
+
+	if(index == (menu->top + menu->rows))
+	{
+		displayScrollArea(menu->area.xs, menu->listY, menu->area.xe, listEnd, -menu->rowHeight);
+		menu->top++;
+		menu_draw_row(menu, index);
+	}
+	else if((index + 1) == menu->top)
+	{
+		displayScrollArea(menu->area.xs, menu->listY, menu->area.xe, listEnd, menu->rowHeight);
+		menu->top--;
+		menu_draw_row(menu, index);
+	}
+	else
+	{
+		menu_draw_list(menu);
+	}
+	displayUpdateArea(menu->area.xs, menu->listY, menu->area.xe, listEnd);
+}
+
+/**
+ * @brief Returns to previous page
+ *
+ * @param menu Pointer to menu object
+ * @return 0 if current page is root page, 1 otherwise
+ */
+static uint8_t menu_back (menu_t *menu)
+{
+	if(!menu->depth)
+	{
+		return 0;
+	}
+	menu->depth--;
+	menu->page = menu->parent[menu->depth];
+	menu->selected = menu->parentSel[menu->depth];
+	menu->top = 0;
+	menu_draw_page(menu);
+	return 1;
+}
+
+
+/**
+ * @brief Initializes menu
+ *
+ * Nothing is drawn until menuDraw is called. Area must be high enough for at
+ * least title and one row.
+ *
+ * @param menu Pointer to menu object
+ * @param root First page of the menu
+ * @param font Font used for drawing
+ * @param x1 Left edge of the menu area
+ * @param y1 Top edge of the menu area
+ * @param x2 Right edge of the menu area
+ * @param y2 Bottom edge of the menu area
+ */
+void menuInit (menu_t *menu, const menuPage_t *root, const UG_FONT *font, UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2)
+{
+	menu->font = font;
+	menu->page = root;
+	menu->area.xs = x1;
+	menu->area.ys = y1;
+	menu->area.xe = x2;
+	menu->area.ye = y2;
+	menu->listY = y1;
+	menu->depth = 0;
+	menu->selected = 0;
+	menu->top = 0;
+	menu->rows = 0;
+	menu->rowHeight = (uint8_t)(font->char_height + 2);
+}
+
+/**
+ * @brief Draws current page of the menu and sends it to display
+ *
+ * Call this to show the menu for the first time or after the menu area
+ * has been overwritten. Menu font stays selected after the call.
+ *
+ * @param menu Pointer to menu object
+ */
+void menuDraw (menu_t *menu)
+{
+	UG_FontSelect(menu->font);
+	menu_draw_page(menu);
+}
+
+/**
+ * @brief Handles navigation event
+ *
+ * Selection wraps around at the ends of the list. Menu font stays selected
+ * after the call.
+ *
+ * @param menu Pointer to menu object
+ * @param event Navigation event
+ * @return 0 if back event was received on root page, so application can close
+ * the menu, 1 otherwise
+ */
+uint8_t menuEvent (menu_t *menu, menuEvent_t event)
+{
+	const menuItem_t *item;
+
+	UG_FontSelect(menu->font);
+	if(!menu->page->count)
+	{
+		return (event == MENU_EVENT_BACK) ? menu_back(menu) : 1;
+	}
+
+	switch (event)
+	{
+		case MENU_EVENT_NEXT:
+			menu_move(menu, ((menu->selected + 1) < menu->page->count) ? (menu->selected + 1) : 0);
+			break;
+		case MENU_EVENT_PREV:
+			menu_move(menu, menu->selected ? (menu->selected - 1) : (menu->page->count - 1));
+			break;
+		case MENU_EVENT_SELECT:
+			item = &menu->page->items[menu->selected];
+			if(item->page)
+			{
+				if(menu->depth < MENU_DEPTH_MAX)
+				{
+					menu->parent[menu->depth] = menu->page;
+					menu->parentSel[menu->depth] = menu->selected;
+					menu->depth++;
+					menu->page = item->page;
+					menu->selected = 0;
+					menu->top = 0;
+					menu_draw_page(menu);
+				}
+			}
+			else if(item->action)
+			{
+				item->action();
+				/* Action usually changes the value of the item */
+				menuRefreshItem(menu, menu->page, menu->selected);
+			}
+			else
+			{
+				return menu_back(menu);
+			}
+			break;
+		case MENU_EVENT_BACK:
+			return menu_back(menu);
+	}
+	return 1;
+}
+
+/**
+ * @brief Draws item again, because its value has changed
+ *
+ * Only row of the item is sent to display. Nothing is done if page is not
+ * shown or item is not visible.
+ *
+ * @param menu Pointer to menu object
+ * @param page Page of the item
+ * @param index Index of item on the page
+ */
+void menuRefreshItem (menu_t *menu, const menuPage_t *page, uint8_t index)
+{
+	UG_S16 y;
+
+	if((page != menu->page) || (index >= menu->page->count) || (index < menu->top) || (index >= (menu->top + menu->rows)))
+	{
+		return;
+	}
+	UG_FontSelect(menu->font);
+	menu_draw_row(menu, index);
+	y = menu_row_y(menu, index);
+	displayUpdateArea(menu->area.xs, y, menu->area.xe, y + menu->rowHeight - 1);
+}
@@ -0,0 +1,114 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		menu.h
+* @brief	Event driven menu for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Menu consists of pages. Each page has an optional title and a list of items. Item
+* shows a label on the left and an optional value on the right side of the row. When
+* item is selected, it opens another page, calls its action or, if it has neither,
+* returns to the previous page. Pages and items are constant and can be kept in flash.
+*
+* Menu is driven by events (next, previous, select, back), which application generates
+* from buttons. Display is changed as little as possible:
+* - moving selection inside visible rows only inverts old and new row
+* - moving selection past the first or last visible row scrolls the list in display
+*   buffer by one row and draws only the new row
+* - changed value of an item is redrawn with menuRefreshItem
+* - opening or closing a page redraws the menu area
+*
+* Every event results in at most one displayUpdateArea call covering the menu area or
+* a part of it.
+*/
+
+#ifndef MENU_H_
+#define MENU_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "ugui/ugui.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Maximum number of nested pages */
+#define MENU_DEPTH_MAX	4
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Menu navigation events */
+typedef enum
+{
+	MENU_EVENT_NEXT,		/**< Move selection to next item */
+	MENU_EVENT_PREV,		/**< Move selection to previous item */
+	MENU_EVENT_SELECT,		/**< Activate selected item */
+	MENU_EVENT_BACK			/**< Return to previous page */
+}menuEvent_t;
+
+typedef struct menuPage_s menuPage_t;
+
+/** @brief Menu item */
+typedef struct
+{
+	const char *label;				/**< Text on the left side of the row */
+	const char *(*value)(void);		/**< Returns text on the right side of the row, or NULL */
+	const menuPage_t *page;			/**< Page opened on select, or NULL */
+	void (*action)(void);			/**< Function called on select, or NULL */
+}menuItem_t;
+
+/** @brief Menu page */
+struct menuPage_s
+{
+	const char *title;				/**< Title above the items, or NULL */
+	const menuItem_t *items;		/**< Array of items */
+	uint8_t count;					/**< Number of items */
+};
+
+/** @brief Menu object */
+typedef struct
+{
+	const UG_FONT *font;						/**< Font used for drawing */
+	const menuPage_t *page;						/**< Currently shown page */
+	const menuPage_t *parent[MENU_DEPTH_MAX];	/**< Pages to return to */
+	uint8_t parentSel[MENU_DEPTH_MAX];			/**< Selected items of pages to return to */
+	UG_AREA area;								/**< Display area of the menu */
+	UG_S16 listY;								/**< Y coordinate of the first row */
+	uint8_t depth;								/**< Number of pages to return to */
+	uint8_t selected;							/**< Index of selected item */
+	uint8_t top;								/**< Index of item in the first row */
+	uint8_t rows;								/**< Number of visible rows */
+	uint8_t rowHeight;							/**< Height of a row in pixels */
+}menu_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void menuInit (menu_t *menu, const menuPage_t *root, const UG_FONT *font, UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2);
+void menuDraw (menu_t *menu);
+uint8_t menuEvent (menu_t *menu, menuEvent_t event);
+void menuRefreshItem (menu_t *menu, const menuPage_t *page, uint8_t index);
+
+
+
+#endif /* MENU_H_ */
@@ -0,0 +1,196 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		numfield.c
+* @brief	Numeric display field for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "numfield.h"
+#include "display.h"
+
+
+/**
+ * @brief Formats number into string of fixed width
+ *
+ * Number is aligned to the right and padded with spaces. If decimals is not 0,
+ * value is treated as fixed point number, so value 1234 with 2 decimals is
+ * formatted as "12.34". If number does not fit, all characters are set to
+ * NUMFIELD_OVERFLOW_CHAR.
+ *
+ * @param str Output buffer, must hold at least width + 1 characters
+ * @param width Number of characters
+ * @param decimals Number of digits after decimal point
+ * @param value Value to format
+ * @return 1 on success, 0 if number did not fit
+ */
+uint8_t numFieldFormat (char *str, uint8_t width, uint8_t decimals, int32_t value)
+{
+	uint32_t mag;
+	uint8_t pos, digits;
+
+	/* Magnitude is computed so, that INT32_MIN does not overflow */
+	mag = (value < 0) ? ((uint32_t)(-(value + 1)) + 1) : (uint32_t)value;
+	pos = width;
+	digits = 0;
+	str[width] = 0;
+
+	do
+	{
+		if(decimals && (digits == decimals))
+		{
+			if(!pos)
+			{
+				break;
+			}
+			str[--pos] = '.';
+		}
+		if(!pos)
+		{
+			break;
+		}
+		str[--pos] = (char)('0' + (mag % 10));
+		mag /= 10;
+		digits++;
+	}while(mag || (digits <= decimals));
+
+	if(value < 0)
+	{
+		if(pos)
+		{
+			str[--pos] = '-';
+		}
+		else
+		{
+			mag = 1; // sign did not fit
+		}
+	}
+
+	if(mag || (digits <= decimals))
+	{
+		for(pos = 0; pos < width; pos++)
+		{
+			str[pos] = NUMFIELD_OVERFLOW_CHAR;
+		}
+		return 0;
+	}
+
+	while(pos)
+	{
+		str[--pos] = ' ';
+	}
+	return 1;
+}
+
+/**
+ * @brief Initializes numeric field
+ *
+ * Nothing is drawn until first call of numFieldSet.
+ *
+ * @param field Pointer to numeric field object
+ * @param x X coordinate of top left corner
+ * @param y Y coordinate of top left corner
+ * @param font Font used for drawing
+ * @param width Number of characters, including sign and decimal point
+ * @param decimals Number of digits after decimal point, 0 for integers
+ */
+void numFieldInit (numField_t *field, UG_S16 x, UG_S16 y, const UG_FONT *font, uint8_t width, uint8_t decimals)
+{
+	if(width > NUMFIELD_MAX_WIDTH)
+	{
+		width = NUMFIELD_MAX_WIDTH;
+	}
+	field->font = font;
+	field->x = x;
+	field->y = y;
+	field->fc = C_WHITE;
+	field->bc = C_BLACK;
+	field->width = width;
+	field->decimals = decimals;
+	numFieldInvalidate(field);
+}
+
+/**
+ * @brief Forces redraw of all characters on next numFieldSet
+ *
+ * Call this after the area under the field has been overwritten,
+ * for example after clearing the screen.
+ *
+ * @param field Pointer to numeric field object
+ */
+void numFieldInvalidate (numField_t *field)
+{
+	uint8_t n;
+	for(n = 0; n < NUMFIELD_MAX_WIDTH; n++)
+	{
+		field->shown[n] = 0;
+	}
+}
+
+/**
+ * @brief Shows new value in numeric field
+ *
+ * Only characters that differ from the ones on display are drawn and
+ * only the span from first to last changed character is sent to display.
+ * Font of the field stays selected after the call.
+ *
+ * @param field Pointer to numeric field object
+ * @param value New value
+ */
+void numFieldSet (numField_t *field, int32_t value)
+{
+	char str[NUMFIELD_MAX_WIDTH + 1];
+	uint8_t n, first, last;
+	UG_S16 pitch, xs;
+
+	numFieldFormat(str, field->width, field->decimals, value);
+
+	first = field->width;
+	last = 0;
+	for(n = 0; n < field->width; n++)
+	{
+		if(str[n] != field->shown[n])
+		{
+			if(first == field->width)
+			{
+				first = n;
+			}
+			last = n;
+		}
+	}
+	if(first == field->width)
+	{
+		return; // nothing has changed
+	}
+
+	UG_FontSelect(field->font);
+	pitch = field->font->char_width + 1;
+	for(n = first; n <= last; n++)
+	{
+		if(str[n] != field->shown[n])
+		{
+			UG_PutChar(str[n], field->x + (n * pitch), field->y, field->fc, field->bc);
+			field->shown[n] = str[n];
+		}
+	}
+
+	xs = field->x + (first * pitch);
+	displayUpdateArea(xs, field->y, field->x + (last * pitch) + field->font->char_width - 1,
+					  field->y + field->font->char_height - 1);
+}
@@ -0,0 +1,78 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		numfield.h
+* @brief	Numeric display field for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Numeric field shows integer or fixed point number with fixed number of characters
+* at fixed position on the display. Number is formatted without sprintf, so printf
+* code from newlib is not needed.
+*
+* Field remembers the last shown characters. When new value is set, only characters
+* which have changed are drawn to display buffer and only that part of the buffer is
+* sent to display. Counter going from 41 to 42 therefore sends only one character cell
+* over I2C.
+*/
+
+#ifndef NUMFIELD_H_
+#define NUMFIELD_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "ugui/ugui.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Maximum number of characters in numeric field */
+#define NUMFIELD_MAX_WIDTH	12
+/** @brief Character shown in all cells when number does not fit in the field */
+#define NUMFIELD_OVERFLOW_CHAR	'*'
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Numeric field object */
+typedef struct
+{
+	const UG_FONT *font;					/**< Font used for drawing */
+	UG_S16 x;								/**< X coordinate of top left corner */
+	UG_S16 y;								/**< Y coordinate of top left corner */
+	UG_COLOR fc;							/**< Fore color */
+	UG_COLOR bc;							/**< Back color */
+	uint8_t width;							/**< Number of characters in field */
+	uint8_t decimals;						/**< Number of digits after decimal point */
+	char shown[NUMFIELD_MAX_WIDTH];			/**< Characters currently on display */
+}numField_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint8_t numFieldFormat (char *str, uint8_t width, uint8_t decimals, int32_t value);
+void numFieldInit (numField_t *field, UG_S16 x, UG_S16 y, const UG_FONT *font, uint8_t width, uint8_t decimals);
+void numFieldInvalidate (numField_t *field);
+void numFieldSet (numField_t *field, int32_t value);
+
+
+
+#endif /* NUMFIELD_H_ */
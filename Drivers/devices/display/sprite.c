@@ -0,0 +1,463 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		sprite.c
+* @brief	Sprite engine for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "sprite.h"
+#include "display.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Number of pages in display buffer */
+#define SPRITE_PAGES	(SSD1306_HEIGHT / 8)
+
+
+/**
+ * @brief Returns page of display buffer that holds pixel row y
+ *
+ * @param y Pixel row, can be negative
+ * @return Page number, rounded towards minus infinity
+ */
+static int16_t sprite_page (int16_t y)
+{
+	if(y >= 0)
+	{
+		return y / 8;
+	}
+	return -((-y + 7) / 8);
+}
+
+/**
+ * @brief Combines one byte of sprite with one byte of display buffer
+ *
+ * @param dst Pointer to byte in display buffer
+ * @param img Image bits
+ * @param mask Mask bits, only these bits are changed
+ * @param blend Drawing mode
+ */
+static void sprite_blend_byte (uint8_t *dst, uint8_t img, uint8_t mask, spriteBlend_t blend)
+{
+	img &= mask;
+	switch(blend)
+	{
+		case SPRITE_BLEND_COPY:
+			*dst = (*dst & (uint8_t)~mask) | img;
+			break;
+		case SPRITE_BLEND_OR:
+			*dst |= img;
+			break;
+		case SPRITE_BLEND_AND:
+			*dst &= (uint8_t)(img | (uint8_t)~mask);
+			break;
+		case SPRITE_BLEND_XOR:
+			*dst ^= img;
+			break;
+	}
+}
+
+/**
+ * @brief Draws sprite image into display buffer
+ *
+ * Each image byte covers 8 rows and lands on one or two pages of display
+ * buffer, depending on vertical alignment.
+ *
+ * @param sprite Pointer to sprite
+ * @param blend Drawing mode
+ * @param erase If set, masked pixels are cleared instead of drawn
+ */
+static void sprite_draw (sprite_t *sprite, spriteBlend_t blend, uint8_t erase)
+{
+	const spriteImage_t *img = sprite->img;
+	uint8_t *buff = displayGetBuffer();
+	uint8_t srcPages = (img->height + 7) / 8;
+	uint8_t col, sp, src, mask;
+	int16_t dx, page, shift;
+
+	for(col = 0; col < img->width; col++)
+	{
+		dx = sprite->x + col;
+		if((dx < 0) || (dx >= SSD1306_WIDTH))
+		{
+			continue;
+		}
+		for(sp = 0; sp < srcPages; sp++)
+		{
+			src = erase ? 0 : img->image[(sp * img->width) + col];
+			mask = img->mask ? img->mask[(sp * img->width) + col] : 0xFF;
+			if((sp == (srcPages - 1)) && (img->height % 8))
+			{
+				mask &= (uint8_t)((1 << (img->height % 8)) - 1);
+			}
+
+			page = sprite_page(sprite->y + (sp * 8));
+			shift = sprite->y + (sp * 8) - (page * 8);
+			if((page >= 0) && (page < SPRITE_PAGES))
+			{
+				sprite_blend_byte(&buff[(page * SSD1306_WIDTH) + dx], (uint8_t)(src << shift),
+								  (uint8_t)(mask << shift), blend);
+			}
+			page++;
+			if(shift && (page >= 0) && (page < SPRITE_PAGES))
+			{
+				sprite_blend_byte(&buff[(page * SSD1306_WIDTH) + dx], (uint8_t)(src >> (8 - shift)),
+								  (uint8_t)(mask >> (8 - shift)), blend);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Copies display buffer under the sprite to save buffer or back
+ *
+ * @param sprite Pointer to sprite
+ * @param restore If set, save buffer is copied to display buffer
+ */
+static void sprite_save (sprite_t *sprite, uint8_t restore)
+{
+	uint8_t *buff = displayGetBuffer();
+	uint8_t width = sprite->img->width;
+	int16_t page, firstPage, lastPage, dx;
+	uint8_t col;
+	uint8_t *save;
+
+	firstPage = sprite_page(sprite->y);
+	lastPage = sprite_page(sprite->y + sprite->img->height - 1);
+	for(page = firstPage; page <= lastPage; page++)
+	{
+		if((page < 0) || (page >= SPRITE_PAGES))
+		{
+			continue;
+		}
+		save = &sprite->save[(page - firstPage) * width];
+		for(col = 0; col < width; col++)
+		{
+			dx = sprite->x + col;
+			if((dx < 0) || (dx >= SSD1306_WIDTH))
+			{
+				continue;
+			}
+			if(restore)
+			{
+				buff[(page * SSD1306_WIDTH) + dx] = save[col];
+			}
+			else
+			{
+				save[col] = buff[(page * SSD1306_WIDTH) + dx];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Returns area covered by sprite, clipped to display
+ *
+ * @param sprite Pointer to sprite
+ * @param area Pointer to area to fill
+ * @return 1 if sprite is at least partly on display, otherwise 0
+ */
+static uint8_t sprite_area (sprite_t *sprite, UG_AREA *area)
+{
+	area->xs = sprite->x < 0 ? 0 : sprite->x;
+	area->ys = sprite->y < 0 ? 0 : sprite->y;
+	area->xe = sprite->x + sprite->img->width - 1;
+	area->ye = sprite->y + sprite->img->height - 1;
+	if(area->xe >= SSD1306_WIDTH)
+	{
+		area->xe = SSD1306_WIDTH - 1;
+	}
+	if(area->ye >= SSD1306_HEIGHT)
+	{
+		area->ye = SSD1306_HEIGHT - 1;
+	}
+	return (area->xs <= area->xe) && (area->ys <= area->ye);
+}
+
+/**
+ * @brief Expands area a so that it also covers area b
+ *
+ * @param a Area to expand
+ * @param b Area to add
+ */
+void spriteAreaUnion (UG_AREA *a, const UG_AREA *b)
+{
+	if(b->xs < a->xs)
+	{
+		a->xs = b->xs;
+	}
+	if(b->ys < a->ys)
+	{
+		a->ys = b->ys;
+	}
+	if(b->xe > a->xe)
+	{
+		a->xe = b->xe;
+	}
+	if(b->ye > a->ye)
+	{
+		a->ye = b->ye;
+	}
+}
+
+/**
+ * @brief Initializes sprite
+ *
+ * @param sprite Pointer to sprite
+ * @param img Sprite image
+ * @param blend Drawing mode
+ * @param save Background save buffer of SPRITE_SAVE_SIZE bytes or NULL
+ */
+void spriteInit (sprite_t *sprite, const spriteImage_t *img, spriteBlend_t blend, uint8_t *save)
+{
+	sprite->img = img;
+	sprite->save = save;
+	sprite->blend = blend;
+	sprite->x = 0;
+	sprite->y = 0;
+	sprite->newX = 0;
+	sprite->newY = 0;
+	sprite->visible = 0;
+}
+
+/**
+ * @brief Draws sprite to display buffer
+ *
+ * @param sprite Pointer to sprite
+ * @param x X coordinate of top left corner
+ * @param y Y coordinate of top left corner
+ * @param dirty Filled with changed area, can be NULL
+ * @return 1 if display buffer has changed, otherwise 0
+ */
+uint8_t spriteShow (sprite_t *sprite, int16_t x, int16_t y, UG_AREA *dirty)
+{
+	UG_AREA area;
+
+	if(sprite->visible)
+	{
+		return spriteMove(sprite, x, y, dirty);
+	}
+	sprite->x = x;
+	sprite->y = y;
+	sprite->newX = x;
+	sprite->newY = y;
+	if(sprite->save)
+	{
+		sprite_save(sprite, 0);
+	}
+	sprite_draw(sprite, sprite->blend, 0);
+	sprite->visible = 1;
+
+	if(!sprite_area(sprite, &area))
+	{
+		return 0;
+	}
+	if(dirty)
+	{
+		*dirty = area;
+	}
+	return 1;
+}
+
+/**
+ * @brief Removes sprite from display buffer
+ *
+ * @param sprite Pointer to sprite
+ * @param dirty Filled with changed area, can be NULL
+ * @return 1 if display buffer has changed, otherwise 0
+ */
+uint8_t spriteHide (sprite_t *sprite, UG_AREA *dirty)
+{
+	UG_AREA area;
+
+	if(!sprite->visible)
+	{
+		return 0;
+	}
+	if(sprite->save)
+	{
+		sprite_save(sprite, 1);
+	}
+	else if(sprite->blend == SPRITE_BLEND_XOR)
+	{
+		sprite_draw(sprite, SPRITE_BLEND_XOR, 0);
+	}
+	else
+	{
+		sprite_draw(sprite, SPRITE_BLEND_COPY, 1);
+	}
+	sprite->visible = 0;
+
+	if(!sprite_area(sprite, &area))
+	{
+		return 0;
+	}
+	if(dirty)
+	{
+		*dirty = area;
+	}
+	return 1;
+}
+
+/**
+ * @brief Moves sprite to new position
+ *
+ * Reported area covers both old and new position of the sprite.
+ *
+ * @param sprite Pointer to sprite
+ * @param x New X coordinate of top left corner
+ * @param y New Y coordinate of top left corner
+ * @param dirty Filled with changed area, can be NULL
+ * @return 1 if display buffer has changed, otherwise 0
+ */
+uint8_t spriteMove (sprite_t *sprite, int16_t x, int16_t y, UG_AREA *dirty)
+{
+	UG_AREA oldArea, newArea;
+	uint8_t oldChanged, newChanged;
+
+	if(sprite->visible && (sprite->x == x) && (sprite->y == y))
+	{
+		return 0;
+	}
+	oldChanged = spriteHide(sprite, &oldArea);
+	newChanged = spriteShow(sprite, x, y, &newArea);
+
+	if(oldChanged && newChanged)
+	{
+		spriteAreaUnion(&newArea, &oldArea);
+	}
+	else if(oldChanged)
+	{
+		newArea = oldArea;
+	}
+	if(dirty && (oldChanged || newChanged))
+	{
+		*dirty = newArea;
+	}
+	return oldChanged || newChanged;
+}
+
+/**
+ * @brief Initializes empty sprite layer
+ *
+ * @param layer Pointer to layer
+ */
+void spriteLayerInit (spriteLayer_t *layer)
+{
+	layer->count = 0;
+}
+
+/**
+ * @brief Puts sprite on top of the layer
+ *
+ * @param layer Pointer to layer
+ * @param sprite Pointer to sprite
+ * @return 1 on success, 0 if layer is full
+ */
+uint8_t spriteLayerAdd (spriteLayer_t *layer, sprite_t *sprite)
+{
+	if(layer->count >= SPRITE_LAYER_MAX)
+	{
+		return 0;
+	}
+	layer->sprites[layer->count++] = sprite;
+	return 1;
+}
+
+/**
+ * @brief Sets position at which sprite will be drawn on next layer update
+ *
+ * @param sprite Pointer to sprite
+ * @param x X coordinate of top left corner
+ * @param y Y coordinate of top left corner
+ */
+void spriteLayerSetPosition (sprite_t *sprite, int16_t x, int16_t y)
+{
+	sprite->newX = x;
+	sprite->newY = y;
+}
+
+/**
+ * @brief Redraws all sprites of a layer at their new positions
+ *
+ * Sprites are removed from top to bottom, so each one restores the
+ * background it has saved, and then drawn again from bottom to top.
+ * If no sprite has moved, display buffer is not touched.
+ *
+ * @param layer Pointer to layer
+ * @param dirty Filled with changed area, can be NULL
+ * @return 1 if display buffer has changed, otherwise 0
+ */
+uint8_t spriteLayerUpdate (spriteLayer_t *layer, UG_AREA *dirty)
+{
+	UG_AREA total, area;
+	uint8_t n, changed = 0;
+
+	for(n = 0; n < layer->count; n++)
+	{
+		if(!layer->sprites[n]->visible || (layer->sprites[n]->x != layer->sprites[n]->newX) ||
+		   (layer->sprites[n]->y != layer->sprites[n]->newY))
+		{
+			break;
+		}
+	}
+	if(n == layer->count)
+	{
+		return 0;
+	}
+
+	for(n = layer->count; n > 0; n--)
+	{
+		if(spriteHide(layer->sprites[n - 1], &area))
+		{
+			if(changed)
+			{
+				spriteAreaUnion(&total, &area);
+			}
+			else
+			{
+				total = area;
+			}
+			changed = 1;
+		}
+	}
+	for(n = 0; n < layer->count; n++)
+	{
+		if(spriteShow(layer->sprites[n], layer->sprites[n]->newX, layer->sprites[n]->newY, &area))
+		{
+			if(changed)
+			{
+				spriteAreaUnion(&total, &area);
+			}
+			else
+			{
+				total = area;
+			}
+			changed = 1;
+		}
+	}
+	if(dirty && changed)
+	{
+		*dirty = total;
+	}
+	return changed;
+}
@@ -0,0 +1,125 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		sprite.h
+* @brief	Sprite engine for on board OLED display.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Sprites are 1 bit images, which are drawn directly into display buffer, a whole
+* byte (8 vertical pixels) at a time, instead of pixel by pixel through uGUI.
+*
+* Sprite image and mask are stored in the same format as display buffer: image is
+* split into pages of 8 pixel rows, each page is <b>width</b> bytes long and bit 0
+* of each byte is the top pixel. Only pixels with mask bit set are drawn. If mask is
+* NULL, whole rectangle of the image is drawn.
+*
+* Drawing modes:
+* - SPRITE_BLEND_COPY pixels under mask are replaced with image
+* - SPRITE_BLEND_OR image pixels are turned on
+* - SPRITE_BLEND_AND pixels, that are off in image, are turned off
+* - SPRITE_BLEND_XOR image pixels invert the background
+*
+* If sprite has a save buffer, background under the sprite is saved before drawing and
+* restored when sprite is hidden or moved. XOR sprites do not need save buffer, they
+* are removed by drawing them again. Other sprites without save buffer leave cleared
+* pixels behind.
+*
+* Every function that changes display buffer reports the bounding box of changed
+* pixels, which can be passed to displayUpdateArea.
+*
+* Overlapping sprites must be removed in reverse order of drawing. Sprite layer does
+* that: sprites are added to layer from bottom to top and spriteLayerUpdate redraws
+* all of them at their new positions.
+*/
+
+#ifndef SPRITE_H_
+#define SPRITE_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "ugui/ugui.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Size of save buffer in bytes for sprite of given size */
+#define SPRITE_SAVE_SIZE(w, h)	((w) * ((((h) + 7) / 8) + 1))
+/** @brief Maximum number of sprites in a layer */
+#define SPRITE_LAYER_MAX		8
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Sprite drawing modes */
+typedef enum
+{
+	SPRITE_BLEND_COPY,		/**< Replace background */
+	SPRITE_BLEND_OR,		/**< Turn pixels on */
+	SPRITE_BLEND_AND,		/**< Turn pixels off */
+	SPRITE_BLEND_XOR		/**< Invert pixels */
+}spriteBlend_t;
+
+/** @brief Sprite image, usually stored in flash */
+typedef struct
+{
+	const uint8_t *image;	/**< Image data in display buffer format */
+	const uint8_t *mask;	/**< Mask data in display buffer format or NULL */
+	uint8_t width;			/**< Width in pixels */
+	uint8_t height;			/**< Height in pixels */
+}spriteImage_t;
+
+/** @brief Sprite object */
+typedef struct
+{
+	const spriteImage_t *img;	/**< Sprite image */
+	uint8_t *save;				/**< Background save buffer or NULL */
+	int16_t x;					/**< X position on display */
+	int16_t y;					/**< Y position on display */
+	int16_t newX;				/**< X position for next layer update */
+	int16_t newY;				/**< Y position for next layer update */
+	spriteBlend_t blend;		/**< Drawing mode */
+	uint8_t visible;			/**< Sprite is drawn in display buffer */
+}sprite_t;
+
+/** @brief Stack of sprites, first sprite is on the bottom */
+typedef struct
+{
+	sprite_t *sprites[SPRITE_LAYER_MAX];	/**< Sprites from bottom to top */
+	uint8_t count;							/**< Number of sprites */
+}spriteLayer_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void spriteInit (sprite_t *sprite, const spriteImage_t *img, spriteBlend_t blend, uint8_t *save);
+uint8_t spriteShow (sprite_t *sprite, int16_t x, int16_t y, UG_AREA *dirty);
+uint8_t spriteHide (sprite_t *sprite, UG_AREA *dirty);
+uint8_t spriteMove (sprite_t *sprite, int16_t x, int16_t y, UG_AREA *dirty);
+void spriteAreaUnion (UG_AREA *a, const UG_AREA *b);
+void spriteLayerInit (spriteLayer_t *layer);
+uint8_t spriteLayerAdd (spriteLayer_t *layer, sprite_t *sprite);
+void spriteLayerSetPosition (sprite_t *sprite, int16_t x, int16_t y);
+uint8_t spriteLayerUpdate (spriteLayer_t *layer, UG_AREA *dirty);
+
+
+
+#endif /* SPRITE_H_ */
@@ -4284,7 +4284,7 @@ UG_S16 UG_Init( UG_GUI* g, void (*p)(UG_S16,UG_S16,UG_COLOR), UG_S16 x, UG_S16 y
    g->font.char_h_space = 1;
    g->font.char_v_space = 1;
    g->font.p = NULL;
-   g->desktop_color = 0x5E8BEf;
+   g->desktop_color = UG_RGB(0x5E8BEF);
    g->fore_color = C_WHITE;
    g->back_color = C_BLACK;
    g->next_window = NULL;
@@ -4655,7 +4655,7 @@ void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c )
    }
 }
 
-void UG_PutString( UG_S16 x, UG_S16 y, char* str )
+void UG_PutString( UG_S16 x, UG_S16 y, const char* str )
 {
    UG_S16 xp,yp;
    char chr;
@@ -4740,7 +4740,7 @@ void UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc )
    }
 }
 
-void UG_ConsolePutString( char* str )
+void UG_ConsolePutString( const char* str )
 {
    char chr;
 
@@ -4827,58 +4827,58 @@ void UG_FontSetVSpace( UG_U16 s )
 const UG_COLOR pal_window[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xFFFFFF,
-   0xFFFFFF,
-   0x696969,
-   0x696969,
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0x696969),
+   UG_RGB(0x696969),
    /* Frame 2 */
-   0xE3E3E3,
-   0xE3E3E3,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
 };
 
 const UG_COLOR pal_button_pressed[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xA0A0A0,
-   0xA0A0A0,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
    /* Frame 2 */
-   0xF0F0F0,
-   0xF0F0F0,
-   0xF0F0F0,
-   0xF0F0F0,
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
+   UG_RGB(0xF0F0F0),
 };
 
 const UG_COLOR pal_button_released[] =
 {
    /* Frame 0 */
-   0x646464,
-   0x646464,
-   0x646464,
-   0x646464,
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
+   UG_RGB(0x646464),
    /* Frame 1 */
-   0xFFFFFF,
-   0xFFFFFF,
-   0x696969,
-   0x696969,
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0xFFFFFF),
+   UG_RGB(0x696969),
+   UG_RGB(0x696969),
    /* Frame 2 */
-   0xE3E3E3,
-   0xE3E3E3,
-   0xA0A0A0,
-   0xA0A0A0,
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xE3E3E3),
+   UG_RGB(0xA0A0A0),
+   UG_RGB(0xA0A0A0),
 };
 /* -------------------------------------------------------------------------------- */
 /* -- INTERNAL FUNCTIONS                                                         -- */
@@ -4901,8 +4901,8 @@ void _UG_PutText(UG_TEXT* txt)
 
    unsigned char* p;
 
-   char* str = txt->str;
-   char* c = str;
+   const char* str = txt->str;
+   const char* c = str;
 
    if ( txt->font->p == NULL ) return;
    if ( str == NULL ) return;
@@ -5201,7 +5201,7 @@ void _UG_HandleEvents( UG_WINDOW* wnd )
    }
 }
 
-void _UG_DrawObjectFrame( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye, UG_COLOR* p )
+void _UG_DrawObjectFrame( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye, const UG_COLOR* p )
 {
    // Frame 0
    UG_DrawLine(xs, ys  , xe-1, ys  , *p++);
@@ -5344,7 +5344,7 @@ void UG_DrawBMP( UG_S16 xp, UG_S16 yp, UG_BMP* bmp )
          g<<=2;
          b = (tmp)&0x1F;
          b<<=3;
-         c = ((UG_COLOR)r<<16) | ((UG_COLOR)g<<8) | (UG_COLOR)b;
+         c = UG_RGB(((UG_U32)r<<16) | ((UG_U32)g<<8) | (UG_U32)b);
          UG_DrawPixel( xp++ , yp , c );
       }
       yp++;
@@ -5380,8 +5380,8 @@ UG_RESULT UG_WindowCreate( UG_WINDOW* wnd, UG_OBJECT* objlst, UG_U8 objcnt, void
    wnd->objcnt = objcnt;
    wnd->objlst = objlst;
    wnd->state = WND_STATE_VALID;
-   wnd->fc = 0x000000;
-   wnd->bc = 0xF0F0F0;
+   wnd->fc = UG_RGB(0x000000);
+   wnd->bc = UG_RGB(0xF0F0F0);
    wnd->xs = 0;
    wnd->ys = 0;
    wnd->xe = UG_GetXDim()-1;
@@ -5585,7 +5585,7 @@ UG_RESULT UG_WindowSetTitleInactiveColor( UG_WINDOW* wnd, UG_COLOR c )
    return UG_RESULT_FAIL;
 }
 
-UG_RESULT UG_WindowSetTitleText( UG_WINDOW* wnd, char* str )
+UG_RESULT UG_WindowSetTitleText( UG_WINDOW* wnd, const char* str )
 {
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
@@ -5789,9 +5789,9 @@ UG_COLOR UG_WindowGetTitleInactiveColor( UG_WINDOW* wnd )
    return c;
 }
 
-char* UG_WindowGetTitleText( UG_WINDOW* wnd )
+const char* UG_WindowGetTitleText( UG_WINDOW* wnd )
 {
-   char* str = NULL;
+   const char* str = NULL;
    if ( (wnd != NULL) && (wnd->state & WND_STATE_VALID) )
    {
       str = wnd->title.str;
@@ -6053,7 +6053,7 @@ void _UG_WindowUpdate( UG_WINDOW* wnd )
       /* 3D style? */
       if ( (wnd->style & WND_STYLE_3D) && !(wnd->state & WND_STATE_REDRAW_TITLE) )
       {
-         _UG_DrawObjectFrame(xs,ys,xe,ye,(UG_COLOR*)pal_window);
+         _UG_DrawObjectFrame(xs,ys,xe,ye,pal_window);
          xs+=3;
          ys+=3;
          xe-=3;
@@ -6251,7 +6251,7 @@ UG_RESULT UG_ButtonSetAlternateBackColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR abc
    return UG_RESULT_OK;
 }
 
-UG_RESULT UG_ButtonSetText( UG_WINDOW* wnd, UG_U8 id, char* str )
+UG_RESULT UG_ButtonSetText( UG_WINDOW* wnd, UG_U8 id, const char* str )
 {
    UG_OBJECT* obj=NULL;
    UG_BUTTON* btn=NULL;
@@ -6381,11 +6381,11 @@ UG_COLOR UG_ButtonGetAlternateBackColor( UG_WINDOW* wnd, UG_U8 id )
    return c;
 }
 
-char* UG_ButtonGetText( UG_WINDOW* wnd, UG_U8 id )
+const char* UG_ButtonGetText( UG_WINDOW* wnd, UG_U8 id )
 {
    UG_OBJECT* obj=NULL;
    UG_BUTTON* btn=NULL;
-   char* str = NULL;
+   const char* str = NULL;
 
    obj = _UG_SearchObject( wnd, OBJ_TYPE_BUTTON, id );
    if ( obj != NULL )
@@ -6520,7 +6520,7 @@ void _UG_ButtonUpdate(UG_WINDOW* wnd, UG_OBJECT* obj)
          /* Draw button frame */
          if ( btn->style & BTN_STYLE_3D )
          {  /* 3D */
-            _UG_DrawObjectFrame(obj->a_abs.xs,obj->a_abs.ys,obj->a_abs.xe,obj->a_abs.ye, (btn->state&BTN_STATE_PRESSED)?(UG_COLOR*)pal_button_pressed:(UG_COLOR*)pal_button_released);
+            _UG_DrawObjectFrame(obj->a_abs.xs,obj->a_abs.ys,obj->a_abs.xe,obj->a_abs.ye, (btn->state&BTN_STATE_PRESSED)?pal_button_pressed:pal_button_released);
          }
          else
          {  /* 2D */
@@ -6639,7 +6639,7 @@ UG_RESULT UG_TextboxSetBackColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR bc )
    return UG_RESULT_OK;
 }
 
-UG_RESULT UG_TextboxSetText( UG_WINDOW* wnd, UG_U8 id, char* str )
+UG_RESULT UG_TextboxSetText( UG_WINDOW* wnd, UG_U8 id, const char* str )
 {
    UG_OBJECT* obj=NULL;
    UG_TEXTBOX* txb=NULL;
@@ -6744,11 +6744,11 @@ UG_COLOR UG_TextboxGetBackColor( UG_WINDOW* wnd, UG_U8 id )
    return c;
 }
 
-char* UG_TextboxGetText( UG_WINDOW* wnd, UG_U8 id )
+const char* UG_TextboxGetText( UG_WINDOW* wnd, UG_U8 id )
 {
    UG_OBJECT* obj=NULL;
    UG_TEXTBOX* txb=NULL;
-   char* str = NULL;
+   const char* str = NULL;
 
    obj = _UG_SearchObject( wnd, OBJ_TYPE_TEXTBOX, id );
    if ( obj != NULL )
@@ -56,6 +56,11 @@
 //#define  USE_FONT_24X40
 //#define  USE_FONT_32X53
 
+/* Monochrome profile for 1 bit displays: UG_COLOR is 8 bit wide and every */
+/* color is reduced to 0 (black) or 1 (white) at compile time.             */
+/* Comment out to get full RGB888 colors.                                  */
+#define  UG_USE_MONOCHROME
+
 /* Specify platform-dependent integer types here */
 
 #define __UG_CONST   const
@@ -148,7 +153,14 @@ typedef struct
 typedef struct S_OBJECT                               UG_OBJECT;
 typedef struct S_WINDOW                               UG_WINDOW;
 typedef UG_S8                                         UG_RESULT;
+#ifdef UG_USE_MONOCHROME
+typedef UG_U8                                         UG_COLOR;
+/* Colors with average of R, G and B below 0x80 are black, others are white */
+#define UG_RGB(c)                                     ((UG_COLOR)(((((c)>>16)&0xFF)+(((c)>>8)&0xFF)+((c)&0xFF)) >= 0x180 ? 1 : 0))
+#else
 typedef UG_U32                                        UG_COLOR;
+#define UG_RGB(c)                                     ((UG_COLOR)(c))
+#endif
 /* -------------------------------------------------------------------------------- */
 /* -- DEFINES                                                                    -- */
 /* -------------------------------------------------------------------------------- */
@@ -216,14 +228,14 @@ typedef struct
 /* Text structure */
 typedef struct
 {
-   char* str;
+   const char* str;
    const UG_FONT* font;
    UG_AREA a;
+   UG_S16 h_space;
+   UG_S16 v_space;
    UG_COLOR fc;
    UG_COLOR bc;
    UG_U8 align;
-   UG_S16 h_space;
-   UG_S16 v_space;
 } UG_TEXT;
 
 /* -------------------------------------------------------------------------------- */
@@ -287,15 +299,15 @@ typedef struct
 /* Object structure */
 struct S_OBJECT
 {
-   UG_U8 state;                              /* object state                               */
-   UG_U8 touch_state;                        /* object touch state                         */
    void (*update) (UG_WINDOW*,UG_OBJECT*);   /* pointer to object-specific update function */
+   void* data;                               /* pointer to object-specific data            */
    UG_AREA a_abs;                            /* absolute area of the object                */
    UG_AREA a_rel;                            /* relative area of the object                */
+   UG_U8 state;                              /* object state                               */
+   UG_U8 touch_state;                        /* object touch state                         */
    UG_U8 type;                               /* object type                                */
    UG_U8 id;                                 /* object ID                                  */
    UG_U8 event;                              /* object-specific events                     */
-   void* data;                               /* pointer to object-specific data            */
 };
 
 /* Currently supported objects */
@@ -336,33 +348,33 @@ struct S_OBJECT
 /* Title structure */
 typedef struct
 {
-   char* str;
+   const char* str;
    const UG_FONT* font;
-   UG_S8 h_space;
-   UG_S8 v_space;
-   UG_U8 align;
    UG_COLOR fc;
    UG_COLOR bc;
    UG_COLOR ifc;
    UG_COLOR ibc;
+   UG_S8 h_space;
+   UG_S8 v_space;
+   UG_U8 align;
    UG_U8 height;
 } UG_TITLE;
 
 /* Window structure */
 struct S_WINDOW
 {
-   UG_U8 objcnt;
    UG_OBJECT* objlst;
-   UG_U8 state;
-   UG_COLOR fc;
-   UG_COLOR bc;
+   void (*cb)( UG_MESSAGE* );
+   UG_TITLE title;
    UG_S16 xs;
    UG_S16 ys;
    UG_S16 xe;
    UG_S16 ye;
+   UG_COLOR fc;
+   UG_COLOR bc;
+   UG_U8 objcnt;
+   UG_U8 state;
    UG_U8 style;
-   UG_TITLE title;
-   void (*cb)( UG_MESSAGE* );
 };
 
 /* Window states */
@@ -386,14 +398,14 @@ struct S_WINDOW
 /* Button structure */
 typedef struct
 {
-   UG_U8 state;
-   UG_U8 style;
+   const UG_FONT* font;
+   const char* str;
    UG_COLOR fc;
    UG_COLOR bc;
    UG_COLOR afc;
    UG_COLOR abc;
-   const UG_FONT* font;
-   char* str;
+   UG_U8 state;
+   UG_U8 style;
 }UG_BUTTON;
 
 /* Default button IDs */
@@ -438,11 +450,11 @@ typedef struct
 /* Textbox structure */
 typedef struct
 {
-   char* str;
+   const char* str;
    const UG_FONT* font;
-   UG_U8 style;
    UG_COLOR fc;
    UG_COLOR bc;
+   UG_U8 style;
    UG_U8 align;
    UG_S8 h_space;
    UG_S8 v_space;
@@ -553,11 +565,11 @@ typedef struct
       UG_S8 char_h_space;
       UG_S8 char_v_space;
    } font;
+   UG_DRIVER driver[NUMBER_OF_DRIVERS];
    UG_COLOR fore_color;
    UG_COLOR back_color;
    UG_COLOR desktop_color;
    UG_U8 state;
-   UG_DRIVER driver[NUMBER_OF_DRIVERS];
 } UG_GUI;
 
 #define UG_SATUS_WAIT_FOR_UPDATE                      (1<<0)
@@ -566,145 +578,145 @@ typedef struct
 /* -- GUI COLORS                                                                -- */
 /* -- Source: http://www.rapidtables.com/web/color/RGB_Color.htm                 -- */
 /* -------------------------------------------------------------------------------- */
-#define  C_MAROON                     0x800000
-#define  C_DARK_RED                   0x8B0000
-#define  C_BROWN                      0xA52A2A
-#define  C_FIREBRICK                  0xB22222
-#define  C_CRIMSON                    0xDC143C
-#define  C_RED                        0xFF0000
-#define  C_TOMATO                     0xFF6347
-#define  C_CORAL                      0xFF7F50
-#define  C_INDIAN_RED                 0xCD5C5C
-#define  C_LIGHT_CORAL                0xF08080
-#define  C_DARK_SALMON                0xE9967A
-#define  C_SALMON                     0xFA8072
-#define  C_LIGHT_SALMON               0xFFA07A
-#define  C_ORANGE_RED                 0xFF4500
-#define  C_DARK_ORANGE                0xFF8C00
-#define  C_ORANGE                     0xFFA500
-#define  C_GOLD                       0xFFD700
-#define  C_DARK_GOLDEN_ROD            0xB8860B
-#define  C_GOLDEN_ROD                 0xDAA520
-#define  C_PALE_GOLDEN_ROD            0xEEE8AA
-#define  C_DARK_KHAKI                 0xBDB76B
-#define  C_KHAKI                      0xF0E68C
-#define  C_OLIVE                      0x808000
-#define  C_YELLOW                     0xFFFF00
-#define  C_YELLOW_GREEN               0x9ACD32
-#define  C_DARK_OLIVE_GREEN           0x556B2F
-#define  C_OLIVE_DRAB                 0x6B8E23
-#define  C_LAWN_GREEN                 0x7CFC00
-#define  C_CHART_REUSE                0x7FFF00
-#define  C_GREEN_YELLOW               0xADFF2F
-#define  C_DARK_GREEN                 0x006400
-#define  C_GREEN                      0x00FF00
-#define  C_FOREST_GREEN               0x228B22
-#define  C_LIME                       0x00FF00
-#define  C_LIME_GREEN                 0x32CD32
-#define  C_LIGHT_GREEN                0x90EE90
-#define  C_PALE_GREEN                 0x98FB98
-#define  C_DARK_SEA_GREEN             0x8FBC8F
-#define  C_MEDIUM_SPRING_GREEN        0x00FA9A
-#define  C_SPRING_GREEN               0x00FF7F
-#define  C_SEA_GREEN                  0x2E8B57
-#define  C_MEDIUM_AQUA_MARINE         0x66CDAA
-#define  C_MEDIUM_SEA_GREEN           0x3CB371
-#define  C_LIGHT_SEA_GREEN            0x20B2AA
-#define  C_DARK_SLATE_GRAY            0x2F4F4F
-#define  C_TEAL                       0x008080
-#define  C_DARK_CYAN                  0x008B8B
-#define  C_AQUA                       0x00FFFF
-#define  C_CYAN                       0x00FFFF
-#define  C_LIGHT_CYAN                 0xE0FFFF
-#define  C_DARK_TURQUOISE             0x00CED1
-#define  C_TURQUOISE                  0x40E0D0
-#define  C_MEDIUM_TURQUOISE           0x48D1CC
-#define  C_PALE_TURQUOISE             0xAFEEEE
-#define  C_AQUA_MARINE                0x7FFFD4
-#define  C_POWDER_BLUE                0xB0E0E6
-#define  C_CADET_BLUE                 0x5F9EA0
-#define  C_STEEL_BLUE                 0x4682B4
-#define  C_CORN_FLOWER_BLUE           0x6495ED
-#define  C_DEEP_SKY_BLUE              0x00BFFF
-#define  C_DODGER_BLUE                0x1E90FF
-#define  C_LIGHT_BLUE                 0xADD8E6
-#define  C_SKY_BLUE                   0x87CEEB
-#define  C_LIGHT_SKY_BLUE             0x87CEFA
-#define  C_MIDNIGHT_BLUE              0x191970
-#define  C_NAVY                       0x000080
-#define  C_DARK_BLUE                  0x00008B
-#define  C_MEDIUM_BLUE                0x0000CD
-#define  C_BLUE                       0x0000FF
-#define  C_ROYAL_BLUE                 0x4169E1
-#define  C_BLUE_VIOLET                0x8A2BE2
-#define  C_INDIGO                     0x4B0082
-#define  C_DARK_SLATE_BLUE            0x483D8B
-#define  C_SLATE_BLUE                 0x6A5ACD
-#define  C_MEDIUM_SLATE_BLUE          0x7B68EE
-#define  C_MEDIUM_PURPLE              0x9370DB
-#define  C_DARK_MAGENTA               0x8B008B
-#define  C_DARK_VIOLET                0x9400D3
-#define  C_DARK_ORCHID                0x9932CC
-#define  C_MEDIUM_ORCHID              0xBA55D3
-#define  C_PURPLE                     0x800080
-#define  C_THISTLE                    0xD8BFD8
-#define  C_PLUM                       0xDDA0DD
-#define  C_VIOLET                     0xEE82EE
-#define  C_MAGENTA                    0xFF00FF
-#define  C_ORCHID                     0xDA70D6
-#define  C_MEDIUM_VIOLET_RED          0xC71585
-#define  C_PALE_VIOLET_RED            0xDB7093
-#define  C_DEEP_PINK                  0xFF1493
-#define  C_HOT_PINK                   0xFF69B4
-#define  C_LIGHT_PINK                 0xFFB6C1
-#define  C_PINK                       0xFFC0CB
-#define  C_ANTIQUE_WHITE              0xFAEBD7
-#define  C_BEIGE                      0xF5F5DC
-#define  C_BISQUE                     0xFFE4C4
-#define  C_BLANCHED_ALMOND            0xFFEBCD
-#define  C_WHEAT                      0xF5DEB3
-#define  C_CORN_SILK                  0xFFF8DC
-#define  C_LEMON_CHIFFON              0xFFFACD
-#define  C_LIGHT_GOLDEN_ROD_YELLOW    0xFAFAD2
-#define  C_LIGHT_YELLOW               0xFFFFE0
-#define  C_SADDLE_BROWN               0x8B4513
-#define  C_SIENNA                     0xA0522D
-#define  C_CHOCOLATE                  0xD2691E
-#define  C_PERU                       0xCD853F
-#define  C_SANDY_BROWN                0xF4A460
-#define  C_BURLY_WOOD                 0xDEB887
-#define  C_TAN                        0xD2B48C
-#define  C_ROSY_BROWN                 0xBC8F8F
-#define  C_MOCCASIN                   0xFFE4B5
-#define  C_NAVAJO_WHITE               0xFFDEAD
-#define  C_PEACH_PUFF                 0xFFDAB9
-#define  C_MISTY_ROSE                 0xFFE4E1
-#define  C_LAVENDER_BLUSH             0xFFF0F5
-#define  C_LINEN                      0xFAF0E6
-#define  C_OLD_LACE                   0xFDF5E6
-#define  C_PAPAYA_WHIP                0xFFEFD5
-#define  C_SEA_SHELL                  0xFFF5EE
-#define  C_MINT_CREAM                 0xF5FFFA
-#define  C_SLATE_GRAY                 0x708090
-#define  C_LIGHT_SLATE_GRAY           0x778899
-#define  C_LIGHT_STEEL_BLUE           0xB0C4DE
-#define  C_LAVENDER                   0xE6E6FA
-#define  C_FLORAL_WHITE               0xFFFAF0
-#define  C_ALICE_BLUE                 0xF0F8FF
-#define  C_GHOST_WHITE                0xF8F8FF
-#define  C_HONEYDEW                   0xF0FFF0
-#define  C_IVORY                      0xFFFFF0
-#define  C_AZURE                      0xF0FFFF
-#define  C_SNOW                       0xFFFAFA
-#define  C_BLACK                      0x000000
-#define  C_DIM_GRAY                   0x696969
-#define  C_GRAY                       0x808080
-#define  C_DARK_GRAY                  0xA9A9A9
-#define  C_SILVER                     0xC0C0C0
-#define  C_LIGHT_GRAY                 0xD3D3D3
-#define  C_GAINSBORO                  0xDCDCDC
-#define  C_WHITE_SMOKE                0xF5F5F5
-#define  C_WHITE                      0xFFFFFF
+#define  C_MAROON                     UG_RGB(0x800000)
+#define  C_DARK_RED                   UG_RGB(0x8B0000)
+#define  C_BROWN                      UG_RGB(0xA52A2A)
+#define  C_FIREBRICK                  UG_RGB(0xB22222)
+#define  C_CRIMSON                    UG_RGB(0xDC143C)
+#define  C_RED                        UG_RGB(0xFF0000)
+#define  C_TOMATO                     UG_RGB(0xFF6347)
+#define  C_CORAL                      UG_RGB(0xFF7F50)
+#define  C_INDIAN_RED                 UG_RGB(0xCD5C5C)
+#define  C_LIGHT_CORAL                UG_RGB(0xF08080)
+#define  C_DARK_SALMON                UG_RGB(0xE9967A)
+#define  C_SALMON                     UG_RGB(0xFA8072)
+#define  C_LIGHT_SALMON               UG_RGB(0xFFA07A)
+#define  C_ORANGE_RED                 UG_RGB(0xFF4500)
+#define  C_DARK_ORANGE                UG_RGB(0xFF8C00)
+#define  C_ORANGE                     UG_RGB(0xFFA500)
+#define  C_GOLD                       UG_RGB(0xFFD700)
+#define  C_DARK_GOLDEN_ROD            UG_RGB(0xB8860B)
+#define  C_GOLDEN_ROD                 UG_RGB(0xDAA520)
+#define  C_PALE_GOLDEN_ROD            UG_RGB(0xEEE8AA)
+#define  C_DARK_KHAKI                 UG_RGB(0xBDB76B)
+#define  C_KHAKI                      UG_RGB(0xF0E68C)
+#define  C_OLIVE                      UG_RGB(0x808000)
+#define  C_YELLOW                     UG_RGB(0xFFFF00)
+#define  C_YELLOW_GREEN               UG_RGB(0x9ACD32)
+#define  C_DARK_OLIVE_GREEN           UG_RGB(0x556B2F)
+#define  C_OLIVE_DRAB                 UG_RGB(0x6B8E23)
+#define  C_LAWN_GREEN                 UG_RGB(0x7CFC00)
+#define  C_CHART_REUSE                UG_RGB(0x7FFF00)
+#define  C_GREEN_YELLOW               UG_RGB(0xADFF2F)
+#define  C_DARK_GREEN                 UG_RGB(0x006400)
+#define  C_GREEN                      UG_RGB(0x00FF00)
+#define  C_FOREST_GREEN               UG_RGB(0x228B22)
+#define  C_LIME                       UG_RGB(0x00FF00)
+#define  C_LIME_GREEN                 UG_RGB(0x32CD32)
+#define  C_LIGHT_GREEN                UG_RGB(0x90EE90)
+#define  C_PALE_GREEN                 UG_RGB(0x98FB98)
+#define  C_DARK_SEA_GREEN             UG_RGB(0x8FBC8F)
+#define  C_MEDIUM_SPRING_GREEN        UG_RGB(0x00FA9A)
+#define  C_SPRING_GREEN               UG_RGB(0x00FF7F)
+#define  C_SEA_GREEN                  UG_RGB(0x2E8B57)
+#define  C_MEDIUM_AQUA_MARINE         UG_RGB(0x66CDAA)
+#define  C_MEDIUM_SEA_GREEN           UG_RGB(0x3CB371)
+#define  C_LIGHT_SEA_GREEN            UG_RGB(0x20B2AA)
+#define  C_DARK_SLATE_GRAY            UG_RGB(0x2F4F4F)
+#define  C_TEAL                       UG_RGB(0x008080)
+#define  C_DARK_CYAN                  UG_RGB(0x008B8B)
+#define  C_AQUA                       UG_RGB(0x00FFFF)
+#define  C_CYAN                       UG_RGB(0x00FFFF)
+#define  C_LIGHT_CYAN                 UG_RGB(0xE0FFFF)
+#define  C_DARK_TURQUOISE             UG_RGB(0x00CED1)
+#define  C_TURQUOISE                  UG_RGB(0x40E0D0)
+#define  C_MEDIUM_TURQUOISE           UG_RGB(0x48D1CC)
+#define  C_PALE_TURQUOISE             UG_RGB(0xAFEEEE)
+#define  C_AQUA_MARINE                UG_RGB(0x7FFFD4)
+#define  C_POWDER_BLUE                UG_RGB(0xB0E0E6)
+#define  C_CADET_BLUE                 UG_RGB(0x5F9EA0)
+#define  C_STEEL_BLUE                 UG_RGB(0x4682B4)
+#define  C_CORN_FLOWER_BLUE           UG_RGB(0x6495ED)
+#define  C_DEEP_SKY_BLUE              UG_RGB(0x00BFFF)
+#define  C_DODGER_BLUE                UG_RGB(0x1E90FF)
+#define  C_LIGHT_BLUE                 UG_RGB(0xADD8E6)
+#define  C_SKY_BLUE                   UG_RGB(0x87CEEB)
+#define  C_LIGHT_SKY_BLUE             UG_RGB(0x87CEFA)
+#define  C_MIDNIGHT_BLUE              UG_RGB(0x191970)
+#define  C_NAVY                       UG_RGB(0x000080)
+#define  C_DARK_BLUE                  UG_RGB(0x00008B)
+#define  C_MEDIUM_BLUE                UG_RGB(0x0000CD)
+#define  C_BLUE                       UG_RGB(0x0000FF)
+#define  C_ROYAL_BLUE                 UG_RGB(0x4169E1)
+#define  C_BLUE_VIOLET                UG_RGB(0x8A2BE2)
+#define  C_INDIGO                     UG_RGB(0x4B0082)
+#define  C_DARK_SLATE_BLUE            UG_RGB(0x483D8B)
+#define  C_SLATE_BLUE                 UG_RGB(0x6A5ACD)
+#define  C_MEDIUM_SLATE_BLUE          UG_RGB(0x7B68EE)
+#define  C_MEDIUM_PURPLE              UG_RGB(0x9370DB)
+#define  C_DARK_MAGENTA               UG_RGB(0x8B008B)
+#define  C_DARK_VIOLET                UG_RGB(0x9400D3)
+#define  C_DARK_ORCHID                UG_RGB(0x9932CC)
+#define  C_MEDIUM_ORCHID              UG_RGB(0xBA55D3)
+#define  C_PURPLE                     UG_RGB(0x800080)
+#define  C_THISTLE                    UG_RGB(0xD8BFD8)
+#define  C_PLUM                       UG_RGB(0xDDA0DD)
+#define  C_VIOLET                     UG_RGB(0xEE82EE)
+#define  C_MAGENTA                    UG_RGB(0xFF00FF)
+#define  C_ORCHID                     UG_RGB(0xDA70D6)
+#define  C_MEDIUM_VIOLET_RED          UG_RGB(0xC71585)
+#define  C_PALE_VIOLET_RED            UG_RGB(0xDB7093)
+#define  C_DEEP_PINK                  UG_RGB(0xFF1493)
+#define  C_HOT_PINK                   UG_RGB(0xFF69B4)
+#define  C_LIGHT_PINK                 UG_RGB(0xFFB6C1)
+#define  C_PINK                       UG_RGB(0xFFC0CB)
+#define  C_ANTIQUE_WHITE              UG_RGB(0xFAEBD7)
+#define  C_BEIGE                      UG_RGB(0xF5F5DC)
+#define  C_BISQUE                     UG_RGB(0xFFE4C4)
+#define  C_BLANCHED_ALMOND            UG_RGB(0xFFEBCD)
+#define  C_WHEAT                      UG_RGB(0xF5DEB3)
+#define  C_CORN_SILK                  UG_RGB(0xFFF8DC)
+#define  C_LEMON_CHIFFON              UG_RGB(0xFFFACD)
+#define  C_LIGHT_GOLDEN_ROD_YELLOW    UG_RGB(0xFAFAD2)
+#define  C_LIGHT_YELLOW               UG_RGB(0xFFFFE0)
+#define  C_SADDLE_BROWN               UG_RGB(0x8B4513)
+#define  C_SIENNA                     UG_RGB(0xA0522D)
+#define  C_CHOCOLATE                  UG_RGB(0xD2691E)
+#define  C_PERU                       UG_RGB(0xCD853F)
+#define  C_SANDY_BROWN                UG_RGB(0xF4A460)
+#define  C_BURLY_WOOD                 UG_RGB(0xDEB887)
+#define  C_TAN                        UG_RGB(0xD2B48C)
+#define  C_ROSY_BROWN                 UG_RGB(0xBC8F8F)
+#define  C_MOCCASIN                   UG_RGB(0xFFE4B5)
+#define  C_NAVAJO_WHITE               UG_RGB(0xFFDEAD)
+#define  C_PEACH_PUFF                 UG_RGB(0xFFDAB9)
+#define  C_MISTY_ROSE                 UG_RGB(0xFFE4E1)
+#define  C_LAVENDER_BLUSH             UG_RGB(0xFFF0F5)
+#define  C_LINEN                      UG_RGB(0xFAF0E6)
+#define  C_OLD_LACE                   UG_RGB(0xFDF5E6)
+#define  C_PAPAYA_WHIP                UG_RGB(0xFFEFD5)
+#define  C_SEA_SHELL                  UG_RGB(0xFFF5EE)
+#define  C_MINT_CREAM                 UG_RGB(0xF5FFFA)
+#define  C_SLATE_GRAY                 UG_RGB(0x708090)
+#define  C_LIGHT_SLATE_GRAY           UG_RGB(0x778899)
+#define  C_LIGHT_STEEL_BLUE           UG_RGB(0xB0C4DE)
+#define  C_LAVENDER                   UG_RGB(0xE6E6FA)
+#define  C_FLORAL_WHITE               UG_RGB(0xFFFAF0)
+#define  C_ALICE_BLUE                 UG_RGB(0xF0F8FF)
+#define  C_GHOST_WHITE                UG_RGB(0xF8F8FF)
+#define  C_HONEYDEW                   UG_RGB(0xF0FFF0)
+#define  C_IVORY                      UG_RGB(0xFFFFF0)
+#define  C_AZURE                      UG_RGB(0xF0FFFF)
+#define  C_SNOW                       UG_RGB(0xFFFAFA)
+#define  C_BLACK                      UG_RGB(0x000000)
+#define  C_DIM_GRAY                   UG_RGB(0x696969)
+#define  C_GRAY                       UG_RGB(0x808080)
+#define  C_DARK_GRAY                  UG_RGB(0xA9A9A9)
+#define  C_SILVER                     UG_RGB(0xC0C0C0)
+#define  C_LIGHT_GRAY                 UG_RGB(0xD3D3D3)
+#define  C_GAINSBORO                  UG_RGB(0xDCDCDC)
+#define  C_WHITE_SMOKE                UG_RGB(0xF5F5F5)
+#define  C_WHITE                      UG_RGB(0xFFFFFF)
 
 /* -------------------------------------------------------------------------------- */
 /* -- PROTOTYPES                                                                 -- */
@@ -724,9 +736,9 @@ void UG_DrawCircle( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_COLOR c );
 void UG_FillCircle( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_COLOR c );
 void UG_DrawArc( UG_S16 x0, UG_S16 y0, UG_S16 r, UG_U8 s, UG_COLOR c );
 void UG_DrawLine( UG_S16 x1, UG_S16 y1, UG_S16 x2, UG_S16 y2, UG_COLOR c );
-void UG_PutString( UG_S16 x, UG_S16 y, char* str );
+void UG_PutString( UG_S16 x, UG_S16 y, const char* str );
 void UG_PutChar( char chr, UG_S16 x, UG_S16 y, UG_COLOR fc, UG_COLOR bc );
-void UG_ConsolePutString( char* str );
+void UG_ConsolePutString( const char* str );
 void UG_ConsoleSetArea( UG_S16 xs, UG_S16 ys, UG_S16 xe, UG_S16 ye );
 void UG_ConsoleSetForecolor( UG_COLOR c );
 void UG_ConsoleSetBackcolor( UG_COLOR c );
@@ -761,7 +773,7 @@ UG_RESULT UG_WindowSetTitleTextColor( UG_WINDOW* wnd, UG_COLOR c );
 UG_RESULT UG_WindowSetTitleColor( UG_WINDOW* wnd, UG_COLOR c );
 UG_RESULT UG_WindowSetTitleInactiveTextColor( UG_WINDOW* wnd, UG_COLOR c );
 UG_RESULT UG_WindowSetTitleInactiveColor( UG_WINDOW* wnd, UG_COLOR c );
-UG_RESULT UG_WindowSetTitleText( UG_WINDOW* wnd, char* str );
+UG_RESULT UG_WindowSetTitleText( UG_WINDOW* wnd, const char* str );
 UG_RESULT UG_WindowSetTitleTextFont( UG_WINDOW* wnd, const UG_FONT* font );
 UG_RESULT UG_WindowSetTitleTextHSpace( UG_WINDOW* wnd, UG_S8 hs );
 UG_RESULT UG_WindowSetTitleTextVSpace( UG_WINDOW* wnd, UG_S8 vs );
@@ -778,7 +790,7 @@ UG_COLOR UG_WindowGetTitleTextColor( UG_WINDOW* wnd );
 UG_COLOR UG_WindowGetTitleColor( UG_WINDOW* wnd );
 UG_COLOR UG_WindowGetTitleInactiveTextColor( UG_WINDOW* wnd );
 UG_COLOR UG_WindowGetTitleInactiveColor( UG_WINDOW* wnd );
-char* UG_WindowGetTitleText( UG_WINDOW* wnd );
+const char* UG_WindowGetTitleText( UG_WINDOW* wnd );
 UG_FONT* UG_WindowGetTitleTextFont( UG_WINDOW* wnd );
 UG_S8 UG_WindowGetTitleTextHSpace( UG_WINDOW* wnd );
 UG_S8 UG_WindowGetTitleTextVSpace( UG_WINDOW* wnd );
@@ -804,14 +816,14 @@ UG_RESULT UG_ButtonSetForeColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR fc );
 UG_RESULT UG_ButtonSetBackColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR bc );
 UG_RESULT UG_ButtonSetAlternateForeColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR afc );
 UG_RESULT UG_ButtonSetAlternateBackColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR abc );
-UG_RESULT UG_ButtonSetText( UG_WINDOW* wnd, UG_U8 id, char* str );
+UG_RESULT UG_ButtonSetText( UG_WINDOW* wnd, UG_U8 id, const char* str );
 UG_RESULT UG_ButtonSetFont( UG_WINDOW* wnd, UG_U8 id, const UG_FONT* font );
 UG_RESULT UG_ButtonSetStyle( UG_WINDOW* wnd, UG_U8 id, UG_U8 style );
 UG_COLOR UG_ButtonGetForeColor( UG_WINDOW* wnd, UG_U8 id );
 UG_COLOR UG_ButtonGetBackColor( UG_WINDOW* wnd, UG_U8 id );
 UG_COLOR UG_ButtonGetAlternateForeColor( UG_WINDOW* wnd, UG_U8 id );
 UG_COLOR UG_ButtonGetAlternateBackColor( UG_WINDOW* wnd, UG_U8 id );
-char* UG_ButtonGetText( UG_WINDOW* wnd, UG_U8 id );
+const char* UG_ButtonGetText( UG_WINDOW* wnd, UG_U8 id );
 UG_FONT* UG_ButtonGetFont( UG_WINDOW* wnd, UG_U8 id );
 UG_U8 UG_ButtonGetStyle( UG_WINDOW* wnd, UG_U8 id );
 
@@ -822,14 +834,14 @@ UG_RESULT UG_TextboxShow( UG_WINDOW* wnd, UG_U8 id );
 UG_RESULT UG_TextboxHide( UG_WINDOW* wnd, UG_U8 id );
 UG_RESULT UG_TextboxSetForeColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR fc );
 UG_RESULT UG_TextboxSetBackColor( UG_WINDOW* wnd, UG_U8 id, UG_COLOR bc );
-UG_RESULT UG_TextboxSetText( UG_WINDOW* wnd, UG_U8 id, char* str );
+UG_RESULT UG_TextboxSetText( UG_WINDOW* wnd, UG_U8 id, const char* str );
 UG_RESULT UG_TextboxSetFont( UG_WINDOW* wnd, UG_U8 id, const UG_FONT* font );
 UG_RESULT UG_TextboxSetHSpace( UG_WINDOW* wnd, UG_U8 id, UG_S8 hs );
 UG_RESULT UG_TextboxSetVSpace( UG_WINDOW* wnd, UG_U8 id, UG_S8 vs );
 UG_RESULT UG_TextboxSetAlignment( UG_WINDOW* wnd, UG_U8 id, UG_U8 align );
 UG_COLOR UG_TextboxGetForeColor( UG_WINDOW* wnd, UG_U8 id );
 UG_COLOR UG_TextboxGetBackColor( UG_WINDOW* wnd, UG_U8 id );
-char* UG_TextboxGetText( UG_WINDOW* wnd, UG_U8 id );
+const char* UG_TextboxGetText( UG_WINDOW* wnd, UG_U8 id );
 UG_FONT* UG_TextboxGetFont( UG_WINDOW* wnd, UG_U8 id );
 UG_S8 UG_TextboxGetHSpace( UG_WINDOW* wnd, UG_U8 id );
 UG_S8 UG_TextboxGetVSpace( UG_WINDOW* wnd, UG_U8 id );
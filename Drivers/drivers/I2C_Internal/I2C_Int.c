@@ -14,124 +14,1897 @@
 /**
 * @file		I2C_Int.c
 * @brief	This is driver for on boaard I2C bus, connecting Thermometer,
-*			Accelerometer and OLED Display. This is only basic driver, supporting
-			only non interrupt or DMA operations.
+*			Accelerometer and OLED Display. Transfers are queued and done in
+*			interrupts.
 * @date		04.10.2019
-* @version	1.0
+* @version	1.3
 */
 
 /****************************************************************************************
 * Include files
 ****************************************************************************************/
+#include <string.h>
 #include "I2C_Int.h"
+#include "system_interrupt.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define I2C_INT_DIR_TX		0
+#define I2C_INT_DIR_RX		1
+#define I2C_INT_PHASE_REG	0
+#define I2C_INT_PHASE_DATA	1
+#define I2C_INT_PHASE_DMA	2
+/** @brief Clock pulses needed to release a slave, which holds SDA low */
+#define I2C_INT_RECOVER_CLOCKS	9
+/** @brief Delay loop count for half period of recovery clock, about 5 us */
+#define I2C_INT_RECOVER_DELAY	20
+/** @brief Rise time of SDA and SCL in ns, used for baud rate */
+#define I2C_INT_RISE_TIME		215
+/** @brief Maximum loop count waiting for stop to finish before clock change */
+#define I2C_INT_STOP_WAIT		1000
+/** @brief Pin number of ASF pinmux value */
+#define I2C_INT_PIN(pinmux)		((uint8_t)((pinmux) >> 16))
 
 
 /****************************************************************************************
 * Global variables
 ****************************************************************************************/
-struct i2c_master_module i2cMasterModule;
-struct i2c_master_packet i2cData;
+/** @brief On board bus, SERCOM2 on PA08 (SDA) and PA09 (SCL) */
+i2cIntBus_t i2cIntOnBoard;
+/** @brief Configuration of on board bus */
+const i2cIntBusConfig_t i2cIntOnBoardConfig =
+{
+	.hw = SERCOM2,
+	.pinmuxSda = PINMUX_PA08D_SERCOM2_PAD0,
+	.pinmuxScl = PINMUX_PA09D_SERCOM2_PAD1,
+	.dmaCh = 0
+};
+/** @brief Configuration of bus on GPIO header, SERCOM3 on PA22 (SDA) and PA23 (SCL) */
+const i2cIntBusConfig_t i2cIntHeaderConfig =
+{
+	.hw = SERCOM3,
+	.pinmuxSda = PINMUX_PA22C_SERCOM3_PAD0,
+	.pinmuxScl = PINMUX_PA23C_SERCOM3_PAD1,
+	.dmaCh = 1
+};
+/** @brief Initialized buses, for tick and DMA interrupt */
+static i2cIntBus_t *i2cIntBuses[I2C_INT_BUS_NBR];
+/** @brief Number of used entries in i2cIntBuses */
+static uint8_t i2cIntBusCnt = 0;
+/** @brief Starts and stops i2cIntTick, or NULL if tick runs all the time */
+static void (*i2cIntTickControl)(uint8_t run);
+/** @brief i2cIntTick has been started by i2cIntTickControl */
+static uint8_t i2cIntTickRun = 0;
+/** @brief DMA descriptors, one for each channel up to the last one used by driver */
+COMPILER_ALIGNED(16) static DmacDescriptor i2cIntDmaDesc[I2C_INT_DMA_CH_NBR];
+/** @brief DMA write back descriptors */
+COMPILER_ALIGNED(16) static DmacDescriptor i2cIntDmaWb[I2C_INT_DMA_CH_NBR];
+#if I2C_INT_STATS
+static uint32_t i2c_int_systick (void);
+/** @brief Clock used for statistics */
+static uint32_t (*i2cIntStatsClock)(void) = i2c_int_systick;
+/** @brief Ticks of statistics clock in one us */
+static uint32_t i2cIntStatsTicksPerUs = 1;
+#endif
 
 
 /**
-* @param     clk I2C clock frequency in kHz
-* @return    None.
+* @brief     Initializes DMA controller
+*
+* Controller is shared by all buses, it is initialized only once. Driver owns it,
+* so it is not touched, if someone else has enabled it.
+*
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if DMAC is used by other code
 *
 */
-void i2cIntInit(uint32_t clk)
-{ 
-	struct i2c_master_config i2c;
+static i2cIntRet_t i2c_int_dma_init (void)
+{
+	PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+	PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
 	
-	/* Validate clk and set it to default if it is not ok */
-	if(clk > I2C_INT_CLK_MAX)
+	if(DMAC->CTRL.reg & DMAC_CTRL_DMAENABLE)
 	{
-		clk = I2C_INT_CLK_DEFAULT;
+		return I2C_INT_ERR;
 	}
-	else if (clk < I2C_INT_CLK_MIN)
+	DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+	while(DMAC->CTRL.reg & DMAC_CTRL_SWRST)
 	{
-		clk = I2C_INT_CLK_DEFAULT;
-	}
-	
-	/*Set Pin MUx for I2C Module */
-	PORT->Group[0].PMUX[4].bit.PMUXE = 3;
-	PORT->Group[0].PMUX[4].bit.PMUXO = 3;
-	PORT->Group[0].PINCFG[8].bit.PMUXEN |= (1 << 0);
-	PORT->Group[0].PINCFG[9].bit.PMUXEN |= (1 << 0);
 		
-	i2c_master_get_config_defaults(&i2c);
-	i2c.baud_rate = clk;
-	i2c.buffer_timeout = 100;
-	//i2cMasterModule.buffer_timeout = 10;
-	//i2cMasterModule.unknown_bus_state_timeout = 1;
-	i2c_master_init(&i2cMasterModule, SERCOM2, &i2c);
-	i2c_master_enable(&i2cMasterModule);
+	}
+	DMAC->BASEADDR.reg = (uint32_t)i2cIntDmaDesc;
+	DMAC->WRBADDR.reg = (uint32_t)i2cIntDmaWb;
+	DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+	NVIC_EnableIRQ(DMAC_IRQn);
+	return I2C_INT_OK;
+}
+
+/**
+* @brief     Initializes DMA channel of a bus
+* @param     bus I2C bus
+*
+*/
+static void i2c_int_dma_channel_init (i2cIntBus_t *bus)
+{
+	DMAC->CHID.reg = DMAC_CHID_ID(bus->config->dmaCh);
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+	while(DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+	{
 		
+	}
+	DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
 }
 
+/**
+* @brief     Converts ASF status code to driver status
+* @param     status ASF status code
+* @return    Driver status
+*
+*/
+static i2cIntRet_t i2c_int_status (enum status_code status)
+{
+	switch (status)
+	{
+		case STATUS_OK:
+			return I2C_INT_OK;
+		case STATUS_ERR_BAD_ADDRESS:
+		case STATUS_ERR_OVERFLOW:
+			return I2C_INT_NACK;
+		case STATUS_ERR_TIMEOUT:
+			return I2C_INT_TIMEOUT;
+		case STATUS_ERR_PACKET_COLLISION:
+			return I2C_INT_BUS_ERR;
+		default:
+			return I2C_INT_ERR;
+	}
+}
 
 /**
-* @brief     Transmits data on on board I2C
-* @param     packet Pointer to a structure holding data and settings for transmission
-* @return    I2C_INT_OK on success
-*			 I2C_INT_ERR on error 
+* @brief     Configures SDA and SCL pins for SERCOM
+*
+* Fast-mode Plus needs stronger drive of the pins.
 *
+* @param     bus I2C bus
 */
-i2cIntRet_t i2cIntTx (i2cIntPacket_t *packet)
+static void i2c_int_pin_config (i2cIntBus_t *bus)
+{
+	uint8_t cfg = PORT_PINCFG_PMUXEN;
+	
+	if(bus->busClk > I2C_INT_CLK_FM_MAX)
+	{
+		cfg |= PORT_PINCFG_DRVSTR;
+	}
+	PORT->Group[I2C_INT_PIN(bus->config->pinmuxSda) / 32].PINCFG[I2C_INT_PIN(bus->config->pinmuxSda) % 32].reg = cfg;
+	PORT->Group[I2C_INT_PIN(bus->config->pinmuxScl) / 32].PINCFG[I2C_INT_PIN(bus->config->pinmuxScl) % 32].reg = cfg;
+}
+
+/**
+* @brief     Computes BAUD register value for a clock frequency
+*
+* Same formula as in ASF, but in integer arithmetic, so it can be used in interrupt.
+*
+* @param     bus I2C bus
+* @param     clk Clock frequency in kHz
+* @return    BAUD value
+*
+*/
+static uint8_t i2c_int_baud (i2cIntBus_t *bus, uint32_t clk)
+{
+	uint32_t fscl = clk * 1000;
+	uint32_t rise = ((bus->gclk / 1000) * I2C_INT_RISE_TIME / 1000) * clk;
+	int32_t baud;
+	
+	baud = ((int32_t)bus->gclk - (int32_t)(fscl * 10) - (int32_t)rise + (int32_t)(2 * fscl) - 1) / (int32_t)(2 * fscl);
+	if(baud < 0)
+	{
+		return 0;
+	}
+	return baud > 255 ? 255 : (uint8_t)baud;
+}
+
+/**
+* @brief     Changes clock frequency of I2C module
+*
+* Speed and baud can only be changed while module is disabled, so stop of
+* previous transfer is finished first. Must be called from I2C interrupt or
+* with interrupts disabled, while bus is free.
+*
+* @param     bus I2C bus
+* @param     clk Clock frequency in kHz
+*
+*/
+static void i2c_int_set_clock (i2cIntBus_t *bus, uint32_t clk)
 {
-	uint8_t regAddr[2];
+	SercomI2cm *const i2cm = &bus->module.hw->I2CM;
 	uint16_t n;
 	
-	i2cIntRet_t retVal = I2C_INT_ERR;
-	if(packet->txLen)
+	for(n = 0; (n < I2C_INT_STOP_WAIT) && ((i2cm->STATUS.reg & SERCOM_I2CM_STATUS_BUSSTATE_Msk) == SERCOM_I2CM_STATUS_BUSSTATE(2)); n++)
+	{
+		
+	}
+	i2c_master_disable(&bus->module);
+	i2cm->CTRLA.reg = (i2cm->CTRLA.reg & ~SERCOM_I2CM_CTRLA_SPEED_Msk) |
+					  ((clk > I2C_INT_CLK_FM_MAX) ? SERCOM_I2CM_CTRLA_SPEED(1) : SERCOM_I2CM_CTRLA_SPEED(0));
+	i2cm->BAUD.reg = SERCOM_I2CM_BAUD_BAUD(i2c_int_baud(bus, clk));
+	bus->busClk = clk;
+	i2c_int_pin_config(bus);
+	/* Bus has been idle, state is forced to idle after a short timeout */
+	i2c_master_enable(&bus->module);
+}
+
+/**
+* @brief     Waits for half period of recovery clock
+*
+*/
+static void i2c_int_recover_delay (void)
+{
+	volatile uint16_t n;
+	
+	for(n = 0; n < I2C_INT_RECOVER_DELAY; n++)
 	{
-		/* Transmit device address and register address */
-		regAddr[0] = (uint8_t)(packet->regAddress >> 8) & 0x00FF;
-		regAddr[1] = (uint8_t)packet->regAddress & 0x00FF;
-		i2cData.address = packet->deviceAddress;
-		i2cData.data_length = packet->regAddrLen;
-		i2cData.data = packet->regAddrLen > 1 ? &regAddr[0] : &regAddr[1];
-		i2c_master_write_packet_wait_no_stop(&i2cMasterModule, &i2cData);
 		
-		/* Now write data */
-		for(n = 0; n < packet->txLen; n++)
+	}
+}
+
+/**
+* @brief     Releases bus, which is held by a slave
+*
+* Pins are taken from SERCOM and driven as open drain. SCL is toggled until
+* SDA is released, then stop condition is generated. Pins are given back to
+* SERCOM at the end.
+*
+* @param     bus I2C bus
+*
+*/
+static void i2c_int_bus_recover (i2cIntBus_t *bus)
+{
+	const uint8_t sdaPin = I2C_INT_PIN(bus->config->pinmuxSda);
+	const uint8_t sclPin = I2C_INT_PIN(bus->config->pinmuxScl);
+	/* Both pins of a SERCOM pad pair are in the same port group */
+	PortGroup *const port = &PORT->Group[sdaPin / 32];
+	const uint32_t sda = (1UL << (sdaPin % 32));
+	const uint32_t scl = (1UL << (sclPin % 32));
+	uint8_t n;
+	
+	/* Line is pulled low by output, released by input */
+	port->OUTCLR.reg = sda | scl;
+	port->DIRCLR.reg = sda | scl;
+	port->PINCFG[sdaPin % 32].reg = PORT_PINCFG_INEN;
+	port->PINCFG[sclPin % 32].reg = PORT_PINCFG_INEN;
+	i2c_int_recover_delay();
+	
+	/* Slave, that was interrupted in the middle of a byte, releases SDA at
+	   the latest when it expects acknowledge */
+	for(n = 0; (n < I2C_INT_RECOVER_CLOCKS) && !(port->IN.reg & sda); n++)
+	{
+		port->DIRSET.reg = scl;
+		i2c_int_recover_delay();
+		port->DIRCLR.reg = scl;
+		i2c_int_recover_delay();
+	}
+	
+	/* Stop condition, SDA rises while SCL is high */
+	port->DIRSET.reg = scl;
+	i2c_int_recover_delay();
+	port->DIRSET.reg = sda;
+	i2c_int_recover_delay();
+	port->DIRCLR.reg = scl;
+	i2c_int_recover_delay();
+	port->DIRCLR.reg = sda;
+	i2c_int_recover_delay();
+	
+	i2c_int_pin_config(bus);
+}
+
+/**
+* @brief     Aborts transfer on the bus, recovers bus and restarts I2C module
+*
+* Must be called from I2C interrupt or with interrupts disabled.
+*
+* @param     bus I2C bus
+*/
+static void i2c_int_reset (i2cIntBus_t *bus)
+{
+	DMAC->CHID.reg = DMAC_CHID_ID(bus->config->dmaCh);
+	DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+	DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+	NVIC_ClearPendingIRQ(DMAC_IRQn);
+	
+	i2c_master_cancel_job(&bus->module);
+	bus->module.buffer_length = 0;
+	i2c_master_disable(&bus->module);
+	NVIC_ClearPendingIRQ(bus->irq);
+	
+	i2c_int_bus_recover(bus);
+	/* Bus state is unknown after enable, it is forced to idle after a short timeout */
+	i2c_master_enable(&bus->module);
+}
+
+/**
+* @brief     Inserts job in queue behind all jobs with the same or higher priority
+*
+* Must be called from I2C interrupt or with interrupts disabled.
+*
+* @param     bus I2C bus
+* @param     job Job to insert
+*/
+static void i2c_int_enqueue (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	i2cIntJob_t **link = &bus->queue;
+	
+	while(*link && ((*link)->priority <= job->priority))
+	{
+		link = &(*link)->next;
+	}
+	job->next = *link;
+	*link = job;
+}
+
+/**
+* @brief     Returns one segment of data written by a transmit job
+*
+* Segments are register address, if packet has one, followed by transmit
+* buffer of the packet or by buffers of the vector.
+*
+* @param     bus I2C bus
+* @param     job Transmit job
+* @param     n Segment index
+* @param     data Returns pointer to segment data
+* @return    Length of segment
+*
+*/
+static uint16_t i2c_int_segment (i2cIntBus_t *bus, i2cIntJob_t *job, uint8_t n, const uint8_t **data)
+{
+	i2cIntPacket_t *packet = job->packet;
+	
+	if(packet->regAddrLen)
+	{
+		if(!n)
 		{
-			i2c_master_write_byte(&i2cMasterModule, *((packet->txBuff) + n));
+			*data = packet->regAddrLen > 1 ? &bus->regAddr[0] : &bus->regAddr[1];
+			return packet->regAddrLen > 1 ? 2 : 1;
 		}
-		i2c_master_send_stop(&i2cMasterModule);
-		retVal = I2C_INT_OK;
-		
+		n--;
+	}
+	if(job->vecCnt)
+	{
+		*data = job->vec[n].data;
+		return job->vec[n].len;
+	}
+	*data = packet->txBuff;
+	return packet->txLen;
+}
+
+/**
+* @brief     Moves job->seg past empty segments
+* @param     bus I2C bus
+* @param     job Transmit job
+*
+*/
+static void i2c_int_skip_empty (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	const uint8_t *data;
+	
+	while((job->seg < job->segCnt) && !i2c_int_segment(bus, job, job->seg, &data))
+	{
+		job->seg++;
 	}
-	return retVal;
 }
 
+/**
+* @brief     Checks if a job should be done by DMA
+*
+* Whole transmit, with register address, is checked.
+*
+* @param     bus I2C bus
+* @param     job Job to check
+* @return    1 if DMA should be used, 0 otherwise
+*
+*/
+static uint8_t i2c_int_use_dma (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	const uint8_t *data;
+	uint32_t len;
+	uint8_t n;
+	
+	if(!I2C_INT_DMA_THRESHOLD)
+	{
+		return 0;
+	}
+	if(job->direction == I2C_INT_DIR_RX)
+	{
+		/* Automatic length can count at most 255 bytes */
+		return job->packet->regAddrLen && (job->packet->rxLen >= I2C_INT_DMA_THRESHOLD) && (job->packet->rxLen <= 255);
+	}
+	len = 0;
+	for(n = 0; n < job->segCnt; n++)
+	{
+		len += i2c_int_segment(bus, job, n, &data);
+	}
+	return (len >= I2C_INT_DMA_THRESHOLD) && (len <= 255);
+}
 
 /**
-* @brief     Receives data on on board I2C
-* @param     packet Pointer to a structure holding data and settings for reception
-* @return    I2C_INT_OK on success
-*			  I2C_INT_ERR on error
+* @brief     Lets ASF interrupt handler finish DMA transmit
+*
+* ASF handler sees a finished write, when SERCOM interrupt comes, and calls
+* i2c_int_write_done. ERROR is enabled for the whole transmit, so NACK, which
+* automatic length reports as length error, and bus errors finish the job at once.
+* MB triggers DMA, it is enabled by i2c_int_dma_done after the last byte.
+*
+* @param     bus I2C bus
 *
 */
-i2cIntRet_t i2cIntRx (i2cIntPacket_t *packet)
+static void i2c_int_dma_tx_irq (i2cIntBus_t *bus)
 {
-	uint8_t regAddr[2];
+	bus->module.buffer_length = 1;
+	bus->module.buffer_remaining = 0;
+	bus->module.transfer_direction = I2C_TRANSFER_WRITE;
+	bus->module.send_stop = false;
+	bus->module.status = STATUS_BUSY;
+	bus->module.hw->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+	bus->module.hw->I2CM.INTENSET.reg = SERCOM_I2CM_INTENSET_ERROR;
+}
 
+/**
+* @brief     Starts active job by DMA
+*
+* Receive reads data after register address has been sent. Transmit segments
+* are chained in one DMA transfer, which starts with slave address.
+*
+* @param     bus I2C bus
+* @param     job Active job
+*
+*/
+static void i2c_int_start_dma (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	DmacDescriptor *desc = &i2cIntDmaDesc[bus->config->dmaCh];
+	SercomI2cm *const i2cm = &bus->module.hw->I2CM;
+	const uint8_t *data;
+	uint16_t len, total;
+	uint8_t n, chain;
+	
+	job->phase = I2C_INT_PHASE_DMA;
+	desc->DESCADDR.reg = 0;
+	DMAC->CHID.reg = DMAC_CHID_ID(bus->config->dmaCh);
 	
-	i2cIntRet_t retVal = I2C_INT_ERR;
-	if(packet->rxLen)
+	if(job->direction == I2C_INT_DIR_RX)
 	{
-		/* Transmit device address and register address */
-		regAddr[0] = (uint8_t)(packet->regAddress >> 8) & 0x00FF;
-		regAddr[1] = (uint8_t)packet->regAddress & 0x00FF;
-		i2cData.address = packet->deviceAddress;
-		i2cData.data_length = packet->regAddrLen;
-		i2cData.data = packet->regAddrLen > 1 ? &regAddr[0] : &regAddr[1];
-		i2c_master_write_packet_wait_no_stop(&i2cMasterModule, &i2cData);
-		
-		/* Now receive data */
-		i2cData.data = packet->rxBuff;
-		i2cData.data_length = packet->rxLen;
-		i2c_master_read_packet_wait(&i2cMasterModule, &i2cData);
+		/* Address of incremented buffer is the address after last beat */
+		desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_DSTINC | DMAC_BTCTRL_BLOCKACT_INT;
+		desc->BTCNT.reg = job->packet->rxLen;
+		desc->SRCADDR.reg = (uint32_t)&i2cm->DATA.reg;
+		desc->DSTADDR.reg = (uint32_t)(job->packet->rxBuff + job->packet->rxLen);
+		DMAC->CHCTRLB.reg = DMAC_CHCTRLB_TRIGSRC(bus->dmaRxId) | DMAC_CHCTRLB_TRIGACT_BEAT;
+		DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
 		
+		/* Repeated start, SERCOM sends NACK and stop after last byte */
+		i2c_master_dma_set_transfer(&bus->module, job->packet->deviceAddress,
+									(uint8_t)job->packet->rxLen, I2C_TRANSFER_READ);
+		return;
+	}
+	
+	/* One descriptor for each non empty segment, linked in a chain */
+	chain = 0;
+	total = 0;
+	for(n = 0; n < job->segCnt; n++)
+	{
+		len = i2c_int_segment(bus, job, n, &data);
+		if(!len)
+		{
+			continue;
+		}
+		if(total)
+		{
+			desc->DESCADDR.reg = (uint32_t)&bus->dmaChain[chain];
+			desc = &bus->dmaChain[chain++];
+		}
+		total += len;
+		desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+		desc->BTCNT.reg = len;
+		desc->SRCADDR.reg = (uint32_t)(data + len);
+		desc->DSTADDR.reg = (uint32_t)&i2cm->DATA.reg;
+		desc->DESCADDR.reg = 0;
+	}
+	/* Interrupt only after last block */
+	desc->BTCTRL.reg = (desc->BTCTRL.reg & ~DMAC_BTCTRL_BLOCKACT_Msk) | DMAC_BTCTRL_BLOCKACT_INT;
+	job->seg = job->segCnt;
+	
+	DMAC->CHCTRLB.reg = DMAC_CHCTRLB_TRIGSRC(bus->dmaTxId) | DMAC_CHCTRLB_TRIGACT_BEAT;
+	DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+	i2c_int_dma_tx_irq(bus);
+	
+	/* Start and slave address, every byte is triggered by SERCOM, stop is sent
+	   after the last one */
+	i2c_master_dma_set_transfer(&bus->module, job->packet->deviceAddress, (uint8_t)total, I2C_TRANSFER_WRITE);
+}
+
+/**
+* @brief     Returns result of DMA transmit from SERCOM status
+* @param     bus I2C bus
+* @return    I2C_INT_OK, I2C_INT_NACK or I2C_INT_BUS_ERR
+*
+*/
+static i2cIntRet_t i2c_int_dma_tx_status (i2cIntBus_t *bus)
+{
+	const uint16_t status = bus->module.hw->I2CM.STATUS.reg;
+	
+	if(status & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_LOWTOUT))
+	{
+		return I2C_INT_BUS_ERR;
+	}
+	if(status & (SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_LENERR))
+	{
+		return I2C_INT_NACK;
+	}
+	return I2C_INT_OK;
+}
+
+/**
+* @brief     Continues transmit job with next segment, after previous one is sent
+*
+* Bus is held by the master since previous segment has been sent without stop.
+*
+* @param     bus I2C bus
+* @param     job Active transmit job
+* @return    ASF status of starting the transfer
+*
+*/
+static enum status_code i2c_int_tx_continue (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	enum status_code status;
+	const uint8_t *data;
+	
+	job->phase = I2C_INT_PHASE_DATA;
+	bus->data.data_length = i2c_int_segment(bus, job, job->seg, &data);
+	bus->data.data = (uint8_t *)data;
+	job->seg++;
+	i2c_int_skip_empty(bus, job);
+	
+	/* Segment continues the write, without new start. First byte is sent
+	   from interrupt handler, which is triggered here. */
+	status = i2c_master_write_bytes(&bus->module, &bus->data);
+	bus->module.send_stop = (job->seg == job->segCnt);
+	NVIC_SetPendingIRQ(bus->irq);
+	return status;
+}
+
+/**
+* @brief     Starts reading data of active receive job
+* @param     bus I2C bus
+* @param     job Active receive job
+* @return    ASF status of starting the transfer
+*
+*/
+static enum status_code i2c_int_rx_data (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	if(i2c_int_use_dma(bus, job))
+	{
+		i2c_int_start_dma(bus, job);
+		return STATUS_OK;
+	}
+	
+	/* After register address this generates repeated start */
+	job->phase = I2C_INT_PHASE_DATA;
+	bus->data.data = job->packet->rxBuff;
+	bus->data.data_length = job->packet->rxLen;
+	return i2c_master_read_packet_job(&bus->module, &bus->data);
+}
+
+/**
+* @brief     Starts active job
+*
+* Transmit job starts with its first segment, or as a whole by DMA. Receive job
+* starts with register address, if it has one.
+*
+* @param     bus I2C bus
+* @param     job Active job
+* @return    ASF status of starting the transfer
+*
+*/
+static enum status_code i2c_int_start (i2cIntBus_t *bus, i2cIntJob_t *job)
+{
+	i2cIntPacket_t *packet = job->packet;
+	const uint8_t *data;
+	
+	bus->data.address = packet->deviceAddress;
+	bus->data.ten_bit_address = false;
+	bus->data.high_speed = false;
+	bus->data.hs_master_code = 0;
+	bus->regAddr[0] = (uint8_t)(packet->regAddress >> 8) & 0x00FF;
+	bus->regAddr[1] = (uint8_t)packet->regAddress & 0x00FF;
+	
+	if(job->direction == I2C_INT_DIR_RX)
+	{
+		if(!packet->regAddrLen)
+		{
+			return i2c_int_rx_data(bus, job);
+		}
+		job->phase = I2C_INT_PHASE_REG;
+		bus->data.data = packet->regAddrLen > 1 ? &bus->regAddr[0] : &bus->regAddr[1];
+		bus->data.data_length = packet->regAddrLen > 1 ? 2 : 1;
+		return i2c_master_write_packet_job_no_stop(&bus->module, &bus->data);
+	}
+	
+	job->seg = 0;
+	if(i2c_int_use_dma(bus, job))
+	{
+		i2c_int_start_dma(bus, job);
+		return STATUS_OK;
+	}
+	job->phase = I2C_INT_PHASE_DATA;
+	i2c_int_skip_empty(bus, job);
+	bus->data.data_length = i2c_int_segment(bus, job, job->seg, &data);
+	bus->data.data = (uint8_t *)data;
+	job->seg++;
+	i2c_int_skip_empty(bus, job);
+	if(job->seg == job->segCnt)
+	{
+		return i2c_master_write_packet_job(&bus->module, &bus->data);
+	}
+	return i2c_master_write_packet_job_no_stop(&bus->module, &bus->data);
+}
+
+#if I2C_INT_STATS
+/**
+* @brief     Default statistics clock, SysTick extended to 32 bits
+*
+* SysTick counts CPU cycles down from 0xFFFFFF. Wrap is detected, when counter
+* is higher than on previous call, so it must be called at least once per wrap.
+*
+* @return    Clock ticks
+*
+*/
+static uint32_t i2c_int_systick (void)
+{
+	static uint32_t high = 0;
+	static uint32_t last = 0;
+	uint32_t now = SysTick->VAL;
+	
+	if(now > last)
+	{
+		high += SysTick_LOAD_RELOAD_Msk + 1;
+	}
+	last = now;
+	return high + (SysTick_LOAD_RELOAD_Msk - now);
+}
+
+/**
+* @brief     Clears statistics
+* @param     stats Statistics to clear
+* @param     deviceAddress Address of slave, 0 for whole bus
+*
+*/
+static void i2c_int_stats_clear (i2cIntStats_t *stats, uint8_t deviceAddress)
+{
+	memset(stats, 0, sizeof(i2cIntStats_t));
+	stats->latMin = UINT32_MAX;
+	stats->deviceAddress = deviceAddress;
+}
+
+/**
+* @brief     Finds statistics of a device, adds it if there is room
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @return    Pointer to statistics, or NULL if table is full
+*
+*/
+static i2cIntStats_t *i2c_int_stats_device (i2cIntBus_t *bus, uint8_t deviceAddress)
+{
+	uint8_t n;
+	
+	for(n = 0; n < bus->devStatsCnt; n++)
+	{
+		if(bus->devStats[n].deviceAddress == deviceAddress)
+		{
+			return &bus->devStats[n];
+		}
+	}
+	if(bus->devStatsCnt == I2C_INT_STATS_NBR)
+	{
+		return NULL;
 	}
+	i2c_int_stats_clear(&bus->devStats[bus->devStatsCnt], deviceAddress);
+	return &bus->devStats[bus->devStatsCnt++];
+}
+
+/**
+* @brief     Adds one attempt of active job to bus and device statistics
+*
+* Must be called from I2C interrupt or with interrupts disabled.
+*
+* @param     bus I2C bus
+* @param     job Active job
+* @param     status Result of the attempt
+* @param     finished 0 if job is retried, 1 if it is finished
+*
+*/
+static void i2c_int_stats_update (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntRet_t status, uint8_t finished)
+{
+	i2cIntStats_t *stats[2];
+	i2cIntStats_t *st;
+	uint32_t now = i2cIntStatsClock();
+	uint32_t busy = (now - job->startTime) / i2cIntStatsTicksPerUs;
+	uint32_t latency = (now - job->submitTime) / i2cIntStatsTicksPerUs;
+	uint8_t n, bin;
+	
+	for(bin = 0; ((latency >> bin) > 1) && (bin < (I2C_INT_HIST_BINS - 1)); bin++)
+	{
+		
+	}
+	stats[0] = &bus->stats;
+	stats[1] = i2c_int_stats_device(bus, job->packet->deviceAddress);
+	for(n = 0; n < 2; n++)
+	{
+		st = stats[n];
+		if(!st)
+		{
+			continue;
+		}
+		st->busyUs += busy;
+		if(status == I2C_INT_NACK)
+		{
+			st->nacks++;
+		}
+		else if(status == I2C_INT_TIMEOUT)
+		{
+			st->timeouts++;
+		}
+		else if(status == I2C_INT_BUS_ERR)
+		{
+			st->busErrors++;
+		}
+		if(!finished)
+		{
+			st->retries++;
+			continue;
+		}
+		
+		st->jobs++;
+		if(status == I2C_INT_OK)
+		{
+			st->bytes += job->bytes;
+		}
+		else
+		{
+			st->failed++;
+		}
+		st->latSum += latency;
+		if(latency < st->latMin)
+		{
+			st->latMin = latency;
+		}
+		if(latency > st->latMax)
+		{
+			st->latMax = latency;
+		}
+		st->hist[bin]++;
+	}
+}
+
+/**
+* @brief     Writes label and decimal number
+* @param     putStr Function writing a string
+* @param     label Text written before the number
+* @param     value Number
+*
+*/
+static void i2c_int_put_num (void (*putStr)(const char *str), const char *label, uint64_t value)
+{
+	char str[21];
+	uint8_t pos = sizeof(str) - 1;
+	
+	str[pos] = 0;
+	do
+	{
+		str[--pos] = (char)('0' + (value % 10));
+		value /= 10;
+	}while(value);
+	putStr(label);
+	putStr(&str[pos]);
+}
+
+/**
+* @brief     Writes statistics of bus or one device
+* @param     putStr Function writing a string
+* @param     stats Statistics to write
+*
+*/
+static void i2c_int_stats_print (void (*putStr)(const char *str), const i2cIntStats_t *stats)
+{
+	const char hex[] = "0123456789ABCDEF";
+	char addr[5] = "0x00";
+	uint8_t n;
+	
+	if(stats->deviceAddress)
+	{
+		addr[2] = hex[stats->deviceAddress >> 4];
+		addr[3] = hex[stats->deviceAddress & 0x0F];
+		putStr("I2C dev ");
+		putStr(addr);
+	}
+	else
+	{
+		putStr("I2C bus");
+	}
+	i2c_int_put_num(putStr, "\r\n jobs ", stats->jobs);
+	i2c_int_put_num(putStr, " failed ", stats->failed);
+	i2c_int_put_num(putStr, " bytes ", stats->bytes);
+	i2c_int_put_num(putStr, " busy us ", stats->busyUs);
+	i2c_int_put_num(putStr, "\r\n nack ", stats->nacks);
+	i2c_int_put_num(putStr, " timeout ", stats->timeouts);
+	i2c_int_put_num(putStr, " bus err ", stats->busErrors);
+	i2c_int_put_num(putStr, " retry ", stats->retries);
+	i2c_int_put_num(putStr, "\r\n latency us min ", stats->jobs ? stats->latMin : 0);
+	i2c_int_put_num(putStr, " avg ", stats->jobs ? (stats->latSum / stats->jobs) : 0);
+	i2c_int_put_num(putStr, " max ", stats->latMax);
+	putStr("\r\n hist");
+	for(n = 0; n < I2C_INT_HIST_BINS; n++)
+	{
+		i2c_int_put_num(putStr, " ", stats->hist[n]);
+	}
+	putStr("\r\n");
+}
+#endif
+
+/**
+* @brief     Ends active job and calls its callback
+* @param     bus I2C bus
+* @param     status Result of the job
+*
+*/
+static void i2c_int_complete (i2cIntBus_t *bus, i2cIntRet_t status)
+{
+	i2cIntJob_t *job = bus->active;
+	
+#if I2C_INT_STATS
+	i2c_int_stats_update(bus, job, status, 1);
+#endif
+	bus->active = NULL;
+	bus->timeLeft = 0;
+	job->status = status;
+	if(job->callback)
+	{
+		job->callback(job);
+	}
+}
+
+/**
+* @brief     Starts i2cIntTick when a bus has an active job, stops it when all are idle
+*
+* Must be called from I2C interrupt or with interrupts disabled.
+*
+*/
+static void i2c_int_tick_update (void)
+{
+	uint8_t active = 0;
+	uint8_t n;
+	
+	if(!i2cIntTickControl)
+	{
+		return;
+	}
+	for(n = 0; n < i2cIntBusCnt; n++)
+	{
+		if(i2cIntBuses[n]->active)
+		{
+			active = 1;
+		}
+	}
+	if(active != i2cIntTickRun)
+	{
+		i2cIntTickRun = active;
+		i2cIntTickControl(active);
+	}
+}
+
+/**
+* @brief     Starts next job from queue, if bus is free
+*
+* Must be called from I2C interrupt or with interrupts disabled.
+*
+* @param     bus I2C bus
+*/
+static void i2c_int_next (i2cIntBus_t *bus)
+{
+	enum status_code status;
+	
+	while(!bus->active && bus->queue)
+	{
+		bus->active = bus->queue;
+		bus->queue = bus->queue->next;
+		/* One more, because first tick can come right after the start */
+		bus->timeLeft = bus->active->timeout + 1;
+#if I2C_INT_STATS
+		bus->active->startTime = i2cIntStatsClock();
+#endif
+		if(bus->active->clk != bus->busClk)
+		{
+			i2c_int_set_clock(bus, bus->active->clk);
+		}
+		status = i2c_int_start(bus, bus->active);
+		if(status != STATUS_OK)
+		{
+			i2c_int_complete(bus, i2c_int_status(status));
+		}
+	}
+	i2c_int_tick_update();
+}
+
+/**
+* @brief     ASF callback, write of register address or segment is done
+* @param     module I2C master module
+*
+*/
+static void i2c_int_write_done (struct i2c_master_module *const module)
+{
+	/* Module is the first member of bus */
+	i2cIntBus_t *bus = (i2cIntBus_t *)module;
+	i2cIntJob_t *job = bus->active;
+	SercomI2cm *const i2cm = &module->hw->I2CM;
+	enum status_code status;
+	i2cIntRet_t ret;
+	
+	if(job->phase == I2C_INT_PHASE_DMA)
+	{
+		/* Last byte of DMA transmit has been sent, or slave has not acknowledged a
+		   byte before it, SERCOM has sent stop in both cases */
+		i2cm->INTENCLR.reg = SERCOM_I2CM_INTENCLR_ERROR;
+		i2cm->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+		ret = i2c_int_dma_tx_status(bus);
+		if(ret == I2C_INT_BUS_ERR)
+		{
+			i2c_int_reset(bus);
+		}
+		else if(ret == I2C_INT_NACK)
+		{
+			/* DMA waits for triggers of bytes, which are not sent */
+			DMAC->CHID.reg = DMAC_CHID_ID(bus->config->dmaCh);
+			DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+			DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+		}
+		i2c_int_complete(bus, ret);
+		i2c_int_next(bus);
+		return;
+	}
+	if((job->direction == I2C_INT_DIR_TX) && (job->seg == job->segCnt))
+	{
+		/* Last segment has been sent with stop */
+		i2c_int_complete(bus, I2C_INT_OK);
+		i2c_int_next(bus);
+		return;
+	}
+	
+	if(job->direction == I2C_INT_DIR_RX)
+	{
+		status = i2c_int_rx_data(bus, job);
+	}
+	else
+	{
+		status = i2c_int_tx_continue(bus, job);
+	}
+	if(status == STATUS_OK)
+	{
+		return;
+	}
+	/* Bus was left without stop after previous write */
+	i2c_master_send_stop(module);
+	i2c_int_complete(bus, i2c_int_status(status));
+	i2c_int_next(bus);
+}
+
+/**
+* @brief     ASF callback, read of data is done
+* @param     module I2C master module
+*
+*/
+static void i2c_int_read_done (struct i2c_master_module *const module)
+{
+	/* Module is the first member of bus */
+	i2cIntBus_t *bus = (i2cIntBus_t *)module;
+	i2c_int_complete(bus, I2C_INT_OK);
+	i2c_int_next(bus);
+}
+
+/**
+* @brief     ASF callback, transfer failed
+* @param     module I2C master module
+*
+*/
+static void i2c_int_error (struct i2c_master_module *const module)
+{
+	/* Module is the first member of bus */
+	i2cIntBus_t *bus = (i2cIntBus_t *)module;
+	i2cIntJob_t *job = bus->active;
+	i2cIntRet_t status = i2c_int_status(module->status);
+	
+	if(status == I2C_INT_BUS_ERR)
+	{
+		/* Bus can be left in unknown state, or held by a slave */
+		i2c_int_reset(bus);
+	}
+	else if(!module->send_stop)
+	{
+		/* ASF does not release the bus, if error happens in a write without stop */
+		i2c_master_send_stop(module);
+	}
+	
+	if((module->status == STATUS_ERR_BAD_ADDRESS) && job->retry)
+	{
+		/* Slave may be busy, it is tried again after jobs already in queue */
+		job->retry--;
+#if I2C_INT_STATS
+		i2c_int_stats_update(bus, job, status, 0);
+#endif
+		bus->active = NULL;
+		bus->timeLeft = 0;
+		i2c_int_enqueue(bus, job);
+	}
+	else
+	{
+		i2c_int_complete(bus, status);
+	}
+	i2c_int_next(bus);
+}
+
+/**
+* @brief     DMA transfer of active job on a bus is done
+*
+* Receive is finished, SERCOM has sent NACK and stop. Last byte of transmit is
+* still being sent, MB is enabled and job is finished from SERCOM interrupt.
+*
+* @param     bus I2C bus
+* @param     flags Interrupt flags of DMA channel of the bus
+*
+*/
+static void i2c_int_dma_done (i2cIntBus_t *bus, uint8_t flags)
+{
+	if(!bus->active)
+	{
+		/* Job has been aborted by timeout */
+		return;
+	}
+	if(flags & DMAC_CHINTFLAG_TERR)
+	{
+		i2c_int_reset(bus);
+		i2c_int_complete(bus, I2C_INT_ERR);
+	}
+	else if(bus->active->direction == I2C_INT_DIR_TX)
+	{
+		bus->module.hw->I2CM.INTENSET.reg = SERCOM_I2CM_INTENSET_MB;
+		return;
+	}
+	else
+	{
+		i2c_int_complete(bus, I2C_INT_OK);
+	}
+	i2c_int_next(bus);
+}
+
+/**
+* @brief     DMA interrupt, checks channels of all buses
+*
+*/
+void DMAC_Handler (void)
+{
+	i2cIntBus_t *bus;
+	uint8_t flags;
+	uint8_t n;
+	
+	for(n = 0; n < i2cIntBusCnt; n++)
+	{
+		bus = i2cIntBuses[n];
+		DMAC->CHID.reg = DMAC_CHID_ID(bus->config->dmaCh);
+		flags = DMAC->CHINTFLAG.reg;
+		if(flags)
+		{
+			DMAC->CHINTFLAG.reg = flags;
+			i2c_int_dma_done(bus, flags);
+		}
+	}
+}
+
+/**
+* @brief     Finds settings of a device
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @param     add If not 0, device is added to the table, if it is not there yet
+* @return    Pointer to device settings, or NULL if device is not in table or table is full
+*
+*/
+static i2cIntDevice_t *i2c_int_device (i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t add)
+{
+	i2cIntDevice_t *device;
+	uint8_t n;
+	
+	for(n = 0; n < bus->deviceCnt; n++)
+	{
+		if(bus->devices[n].deviceAddress == deviceAddress)
+		{
+			return &bus->devices[n];
+		}
+	}
+	if(!add || (bus->deviceCnt == I2C_INT_DEVICE_NBR))
+	{
+		return NULL;
+	}
+	device = &bus->devices[bus->deviceCnt++];
+	device->deviceAddress = deviceAddress;
+	device->priority = I2C_INT_PRIO_DEFAULT;
+	device->retries = I2C_INT_RETRY_DEFAULT;
+	device->clk = 0;
+	return device;
+}
+
+/**
+* @brief     Puts job in queue and starts it, if bus is free
+* @param     bus I2C bus
+* @param     job Job to queue
+* @param     packet Transfer description
+* @param     callback Function called when job is finished, or NULL
+* @param     direction I2C_INT_DIR_TX or I2C_INT_DIR_RX
+* @return    I2C_INT_OK if job has been queued
+*			 I2C_INT_BUSY if job is already in queue
+*
+*/
+static i2cIntRet_t i2c_int_submit (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job), uint8_t direction)
+{
+	i2cIntDevice_t *device = i2c_int_device(bus, packet->deviceAddress, 0);
+	const uint8_t *data;
+	uint32_t len;
+	uint8_t n;
+	
+	if(job->status == I2C_INT_BUSY)
+	{
+		return I2C_INT_BUSY;
+	}
+	job->packet = packet;
+	job->segCnt = (packet->regAddrLen ? 1 : 0) + (job->vecCnt ? job->vecCnt : 1);
+	job->callback = callback;
+	job->direction = direction;
+	job->priority = device ? device->priority : I2C_INT_PRIO_DEFAULT;
+	job->retry = device ? device->retries : I2C_INT_RETRY_DEFAULT;
+	job->clk = (device && device->clk) ? device->clk : (uint16_t)bus->clk;
+	
+	/* Time limit is based on number of bytes on the bus */
+	len = packet->regAddrLen;
+	if(direction == I2C_INT_DIR_RX)
+	{
+		len += packet->rxLen;
+	}
+	else
+	{
+		for(n = packet->regAddrLen ? 1 : 0; n < job->segCnt; n++)
+		{
+			len += i2c_int_segment(bus, job, n, &data);
+		}
+	}
+	job->timeout = (uint16_t)(I2C_INT_TIMEOUT_MIN + ((len * I2C_INT_TIMEOUT_BYTE_BITS) / job->clk));
+#if I2C_INT_STATS
+	job->bytes = len;
+#endif
+	job->status = I2C_INT_BUSY;
+	
+	system_interrupt_enter_critical_section();
+#if I2C_INT_STATS
+	job->submitTime = i2cIntStatsClock();
+#endif
+	i2c_int_enqueue(bus, job);
+	i2c_int_next(bus);
+	system_interrupt_leave_critical_section();
+	
+	return I2C_INT_OK;
+}
+
+
+/**
+* @brief     Initializes an I2C bus
+*
+* Bus object must stay valid, it is used by interrupts and i2cIntTick. Bus can
+* be initialized again, for example with another clock, while it has no jobs.
+*
+* @param     bus I2C bus
+* @param     config SERCOM, pins and DMA channel of the bus
+* @param     clk I2C clock frequency in kHz
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if too many buses, DMA channel out of range, SERCOM in use
+*			 or DMAC used by other code
+*
+*/
+i2cIntRet_t i2cIntBusInit (i2cIntBus_t *bus, const i2cIntBusConfig_t *config, uint32_t clk)
+{ 
+	struct i2c_master_config i2c;
+	uint8_t idx = _sercom_get_sercom_inst_index(config->hw);
+	uint8_t first = (i2cIntBusCnt == 0);
+	uint8_t n;
+	
+	if(config->dmaCh >= I2C_INT_DMA_CH_NBR)
+	{
+		return I2C_INT_ERR;
+	}
+	for(n = 0; (n < i2cIntBusCnt) && (i2cIntBuses[n] != bus); n++)
+	{
+		
+	}
+	if(n == I2C_INT_BUS_NBR)
+	{
+		return I2C_INT_ERR;
+	}
+	
+	/* Validate clk and set it to default if it is not ok */
+	if(clk > I2C_INT_CLK_MAX)
+	{
+		clk = I2C_INT_CLK_DEFAULT;
+	}
+	else if (clk < I2C_INT_CLK_MIN)
+	{
+		clk = I2C_INT_CLK_DEFAULT;
+	}
+	
+	if(n < i2cIntBusCnt)
+	{
+		/* ASF does not initialize enabled module */
+		i2c_master_disable(&bus->module);
+	}
+	memset(bus, 0, sizeof(*bus));
+	bus->config = config;
+	bus->clk = clk;
+	bus->busClk = clk;
+	bus->irq = (IRQn_Type)(SERCOM0_IRQn + idx);
+	bus->dmaRxId = SERCOM0_DMAC_ID_RX + 2 * idx;
+	bus->dmaTxId = SERCOM0_DMAC_ID_TX + 2 * idx;
+		
+	i2c_master_get_config_defaults(&i2c);
+	i2c.baud_rate = clk;
+	i2c.sda_scl_rise_time_ns = I2C_INT_RISE_TIME;
+	if(clk > I2C_INT_CLK_FM_MAX)
+	{
+		i2c.transfer_speed = I2C_MASTER_SPEED_FAST_MODE_PLUS;
+	}
+	i2c.pinmux_pad0 = config->pinmuxSda;
+	i2c.pinmux_pad1 = config->pinmuxScl;
+	i2c.buffer_timeout = 100;
+	/* Bus state is forced to idle soon after enable, bus has been recovered */
+	i2c.unknown_bus_state_timeout = 100;
+	/* Slave stretching the clock for 25-35 ms is a bus error */
+	i2c.scl_low_timeout = true;
+	i2c.inactive_timeout = I2C_MASTER_INACTIVE_TIMEOUT_205US;
+	if(i2c_master_init(&bus->module, config->hw, &i2c) != STATUS_OK)
+	{
+		return I2C_INT_ERR;
+	}
+	bus->gclk = system_gclk_chan_get_hz(SERCOM0_GCLK_ID_CORE + idx);
+	/* Slave could have been left in the middle of transfer by reset */
+	i2c_int_bus_recover(bus);
+	
+	i2c_master_register_callback(&bus->module, i2c_int_write_done, I2C_MASTER_CALLBACK_WRITE_COMPLETE);
+	i2c_master_register_callback(&bus->module, i2c_int_read_done, I2C_MASTER_CALLBACK_READ_COMPLETE);
+	i2c_master_register_callback(&bus->module, i2c_int_error, I2C_MASTER_CALLBACK_ERROR);
+	i2c_master_enable_callback(&bus->module, I2C_MASTER_CALLBACK_WRITE_COMPLETE);
+	i2c_master_enable_callback(&bus->module, I2C_MASTER_CALLBACK_READ_COMPLETE);
+	i2c_master_enable_callback(&bus->module, I2C_MASTER_CALLBACK_ERROR);
+	
+	i2c_master_enable(&bus->module);
+	
+	system_interrupt_enter_critical_section();
+	if(first && (i2c_int_dma_init() != I2C_INT_OK))
+	{
+		system_interrupt_leave_critical_section();
+		i2c_master_disable(&bus->module);
+		return I2C_INT_ERR;
+	}
+	i2c_int_dma_channel_init(bus);
+	if(n == i2cIntBusCnt)
+	{
+		i2cIntBuses[i2cIntBusCnt++] = bus;
+	}
+	system_interrupt_leave_critical_section();
+	
+#if I2C_INT_STATS
+	/* SysTick is left alone, if application uses it */
+	if(first && !(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk))
+	{
+		SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+		SysTick->VAL = 0;
+		SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+	}
+	if(i2cIntStatsClock == i2c_int_systick)
+	{
+		i2cIntStatsTicksPerUs = system_cpu_clock_get_hz() / 1000000;
+	}
+	i2c_int_stats_clear(&bus->stats, 0);
+#endif
+	return I2C_INT_OK;
+}
+
+
+/**
+* @param     clk I2C clock frequency in kHz
+* @return    None.
+*
+*/
+void i2cIntInit(uint32_t clk)
+{
+	i2cIntBusInit(&i2cIntOnBoard, &i2cIntOnBoardConfig, clk);
+}
+
+
+/**
+* @brief     Transmits data on I2C bus and waits until transfer is done
+* @param     bus I2C bus
+* @param     packet Pointer to a structure holding data and settings for transmission
+* @return    I2C_INT_OK on success
+*			 I2C_INT_NACK, I2C_INT_TIMEOUT, I2C_INT_BUS_ERR or I2C_INT_ERR on error
+*
+*/
+i2cIntRet_t i2cIntBusTx (i2cIntBus_t *bus, i2cIntPacket_t *packet)
+{
+	i2cIntJob_t job;
+	
+	job.status = I2C_INT_OK;
+	if(i2cIntBusSubmitTx(bus, &job, packet, NULL) != I2C_INT_OK)
+	{
+		return I2C_INT_ERR;
+	}
+	return i2cIntJobWait(&job);
+}
+
+
+/**
+* @brief     Same as i2cIntBusTx, on on board bus
+*
+*/
+i2cIntRet_t i2cIntTx (i2cIntPacket_t *packet)
+{
+	return i2cIntBusTx(&i2cIntOnBoard, packet);
+}
+
+
+/**
+* @brief     Transmits several buffers in one transfer and waits until it is done
+* @param     bus I2C bus
+* @param     packet Pointer to a structure holding device and register address
+* @param     vec Array of buffers
+* @param     cnt Number of buffers, at most I2C_INT_VEC_MAX
+* @return    I2C_INT_OK on success
+*			 I2C_INT_NACK, I2C_INT_TIMEOUT, I2C_INT_BUS_ERR or I2C_INT_ERR on error
+*
+*/
+i2cIntRet_t i2cIntBusTxv (i2cIntBus_t *bus, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt)
+{
+	i2cIntJob_t job;
+	
+	job.status = I2C_INT_OK;
+	if(i2cIntBusSubmitTxv(bus, &job, packet, vec, cnt, NULL) != I2C_INT_OK)
+	{
+		return I2C_INT_ERR;
+	}
+	return i2cIntJobWait(&job);
+}
+
+
+/**
+* @brief     Same as i2cIntBusTxv, on on board bus
+*
+*/
+i2cIntRet_t i2cIntTxv (i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt)
+{
+	return i2cIntBusTxv(&i2cIntOnBoard, packet, vec, cnt);
+}
+
+
+/**
+* @brief     Receives data on I2C bus and waits until transfer is done
+* @param     bus I2C bus
+* @param     packet Pointer to a structure holding data and settings for reception
+* @return    I2C_INT_OK on success
+*			 I2C_INT_NACK, I2C_INT_TIMEOUT, I2C_INT_BUS_ERR or I2C_INT_ERR on error
+*
+*/
+i2cIntRet_t i2cIntBusRx (i2cIntBus_t *bus, i2cIntPacket_t *packet)
+{
+	i2cIntJob_t job;
+	
+	job.status = I2C_INT_OK;
+	if(i2cIntBusSubmitRx(bus, &job, packet, NULL) != I2C_INT_OK)
+	{
+		return I2C_INT_ERR;
+	}
+	return i2cIntJobWait(&job);
+}
+
+
+/**
+* @brief     Same as i2cIntBusRx, on on board bus
+*
+*/
+i2cIntRet_t i2cIntRx (i2cIntPacket_t *packet)
+{
+	return i2cIntBusRx(&i2cIntOnBoard, packet);
+}
+
+
+/**
+* @brief     Queues transmission on I2C bus and returns immediately
+*
+* Register address (if regAddrLen is not 0) and data are sent in one transfer.
+*
+* @param     bus I2C bus
+* @param     job Job object, must not be in queue already
+* @param     packet Pointer to a structure holding data and settings for transmission
+* @param     callback Function called from interrupt when job is finished, or NULL
+* @return    I2C_INT_OK if job has been queued
+*			 I2C_INT_BUSY if job is still in queue
+*			 I2C_INT_ERR if there is nothing to send
+*
+*/
+i2cIntRet_t i2cIntBusSubmitTx (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job))
+{
+	if(job->status == I2C_INT_BUSY)
+	{
+		return I2C_INT_BUSY;
+	}
+	if(!packet->txLen)
+	{
+		return I2C_INT_ERR;
+	}
+	job->vecCnt = 0;
+	return i2c_int_submit(bus, job, packet, callback, I2C_INT_DIR_TX);
+}
+
+
+/**
+* @brief     Same as i2cIntBusSubmitTx, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSubmitTx (i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job))
+{
+	return i2cIntBusSubmitTx(&i2cIntOnBoard, job, packet, callback);
+}
+
+
+/**
+* @brief     Queues transmission of several buffers in one transfer and returns immediately
+*
+* Register address (if regAddrLen is not 0) and all buffers of the vector are sent
+* between one start and stop, without copying. txBuff and txLen of the packet are
+* not used. Vector must stay valid until job is finished.
+*
+* @param     bus I2C bus
+* @param     job Job object, must not be in queue already
+* @param     packet Pointer to a structure holding device and register address
+* @param     vec Array of buffers
+* @param     cnt Number of buffers, at most I2C_INT_VEC_MAX
+* @param     callback Function called from interrupt when job is finished, or NULL
+* @return    I2C_INT_OK if job has been queued
+*			 I2C_INT_BUSY if job is still in queue
+*			 I2C_INT_ERR if there is nothing to send or vector is too long
+*
+*/
+i2cIntRet_t i2cIntBusSubmitTxv (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt, void (*callback)(i2cIntJob_t *job))
+{
+	uint32_t len = 0;
+	uint8_t n;
+	
+	if(job->status == I2C_INT_BUSY)
+	{
+		return I2C_INT_BUSY;
+	}
+	if(!cnt || (cnt > I2C_INT_VEC_MAX))
+	{
+		return I2C_INT_ERR;
+	}
+	for(n = 0; n < cnt; n++)
+	{
+		len += vec[n].len;
+	}
+	if(!len)
+	{
+		return I2C_INT_ERR;
+	}
+	job->vec = vec;
+	job->vecCnt = cnt;
+	return i2c_int_submit(bus, job, packet, callback, I2C_INT_DIR_TX);
+}
+
+
+/**
+* @brief     Same as i2cIntBusSubmitTxv, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSubmitTxv (i2cIntJob_t *job, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt, void (*callback)(i2cIntJob_t *job))
+{
+	return i2cIntBusSubmitTxv(&i2cIntOnBoard, job, packet, vec, cnt, callback);
+}
+
+
+/**
+* @brief     Queues reception on I2C bus and returns immediately
+*
+* If regAddrLen is not 0, register address is written first and data is read
+* after repeated start.
+*
+* @param     bus I2C bus
+* @param     job Job object, must not be in queue already
+* @param     packet Pointer to a structure holding data and settings for reception
+* @param     callback Function called from interrupt when job is finished, or NULL
+* @return    I2C_INT_OK if job has been queued
+*			 I2C_INT_BUSY if job is still in queue
+*			 I2C_INT_ERR if there is nothing to receive
+*
+*/
+i2cIntRet_t i2cIntBusSubmitRx (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job))
+{
+	if(job->status == I2C_INT_BUSY)
+	{
+		return I2C_INT_BUSY;
+	}
+	if(!packet->rxLen)
+	{
+		return I2C_INT_ERR;
+	}
+	job->vecCnt = 0;
+	return i2c_int_submit(bus, job, packet, callback, I2C_INT_DIR_RX);
+}
+
+
+/**
+* @brief     Same as i2cIntBusSubmitRx, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSubmitRx (i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job))
+{
+	return i2cIntBusSubmitRx(&i2cIntOnBoard, job, packet, callback);
+}
+
+
+/**
+* @brief     Returns status of a job
+* @param     job Job object
+* @return    I2C_INT_BUSY while job is in queue or on the bus
+*			 I2C_INT_OK if job has finished successfully
+*			 I2C_INT_NACK, I2C_INT_TIMEOUT, I2C_INT_BUS_ERR or I2C_INT_ERR if job has failed
+*
+*/
+i2cIntRet_t i2cIntJobGetStatus (i2cIntJob_t *job)
+{
+	return job->status;
+}
+
+
+/**
+* @brief     Waits until job is finished
+*
+* Must not be called from interrupts or with interrupts disabled. Wait is
+* bounded by time limits of the jobs, if i2cIntTick is called.
+*
+* @param     job Job object
+* @return    I2C_INT_OK if job has finished successfully
+*			 I2C_INT_NACK, I2C_INT_TIMEOUT, I2C_INT_BUS_ERR or I2C_INT_ERR if job has failed
+*
+*/
+i2cIntRet_t i2cIntJobWait (i2cIntJob_t *job)
+{
+	while(job->status == I2C_INT_BUSY)
+	{
+		
+	}
+	return job->status;
+}
+
+
+/**
+* @brief     Sets priority of jobs for a device
+*
+* Priority of a job is taken when it is submitted.
+*
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @param     priority Priority, lower number is done first
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if device table is full
+*
+*/
+i2cIntRet_t i2cIntBusSetDevicePriority (i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t priority)
+{
+	i2cIntDevice_t *device = i2c_int_device(bus, deviceAddress, 1);
+	
+	if(!device)
+	{
+		return I2C_INT_ERR;
+	}
+	device->priority = priority;
+	return I2C_INT_OK;
+}
+
+
+/**
+* @brief     Same as i2cIntBusSetDevicePriority, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSetDevicePriority (uint8_t deviceAddress, uint8_t priority)
+{
+	return i2cIntBusSetDevicePriority(&i2cIntOnBoard, deviceAddress, priority);
+}
+
+
+/**
+* @brief     Sets number of retries after address NACK for a device
+*
+* Number of retries of a job is taken when it is submitted. Each retry is done
+* after jobs, that are already in queue.
+*
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @param     retries Number of retries, 0 disables retry
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if device table is full
+*
+*/
+i2cIntRet_t i2cIntBusSetDeviceRetries (i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t retries)
+{
+	i2cIntDevice_t *device = i2c_int_device(bus, deviceAddress, 1);
+	
+	if(!device)
+	{
+		return I2C_INT_ERR;
+	}
+	device->retries = retries;
+	return I2C_INT_OK;
+}
+
+
+/**
+* @brief     Same as i2cIntBusSetDeviceRetries, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSetDeviceRetries (uint8_t deviceAddress, uint8_t retries)
+{
+	return i2cIntBusSetDeviceRetries(&i2cIntOnBoard, deviceAddress, retries);
+}
+
+
+/**
+* @brief     Sets clock frequency for a device
+*
+* Clock of a job is taken when it is submitted. Module is switched to it when
+* job is started.
+*
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @param     clk Clock frequency in kHz, from I2C_INT_CLK_MIN to I2C_INT_CLK_MAX,
+*			 0 for clock given to i2cIntInit
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if frequency is out of range or device table is full
+*
+*/
+i2cIntRet_t i2cIntBusSetDeviceClock (i2cIntBus_t *bus, uint8_t deviceAddress, uint32_t clk)
+{
+	i2cIntDevice_t *device;
+	
+	if(clk && ((clk < I2C_INT_CLK_MIN) || (clk > I2C_INT_CLK_MAX)))
+	{
+		return I2C_INT_ERR;
+	}
+	device = i2c_int_device(bus, deviceAddress, 1);
+	if(!device)
+	{
+		return I2C_INT_ERR;
+	}
+	device->clk = (uint16_t)clk;
+	return I2C_INT_OK;
+}
+
+
+/**
+* @brief     Same as i2cIntBusSetDeviceClock, on on board bus
+*
+*/
+i2cIntRet_t i2cIntSetDeviceClock (uint8_t deviceAddress, uint32_t clk)
+{
+	return i2cIntBusSetDeviceClock(&i2cIntOnBoard, deviceAddress, clk);
+}
+
+
+/**
+* @brief     Counts down time limits of active jobs on all buses
+*
+* Must be called every millisecond while a job is active, from main loop or
+* interrupt. When time limit runs out, transfer is aborted, bus is recovered and
+* job finishes with I2C_INT_TIMEOUT.
+*
+*/
+void i2cIntTick (void)
+{
+	i2cIntBus_t *bus;
+	i2cIntRet_t status;
+	uint8_t n;
+	
+	system_interrupt_enter_critical_section();
+	for(n = 0; n < i2cIntBusCnt; n++)
+	{
+		bus = i2cIntBuses[n];
+		if(bus->active && bus->timeLeft)
+		{
+			bus->timeLeft--;
+			if(!bus->timeLeft)
+			{
+				status = I2C_INT_TIMEOUT;
+				if(bus->active->phase == I2C_INT_PHASE_DMA)
+				{
+					/* Error of DMA transmit, that its interrupt has not reported yet */
+					status = i2c_int_dma_tx_status(bus);
+					status = (status == I2C_INT_OK) ? I2C_INT_TIMEOUT : status;
+				}
+				i2c_int_reset(bus);
+				i2c_int_complete(bus, status);
+				i2c_int_next(bus);
+			}
+		}
+	}
+	system_interrupt_leave_critical_section();
+}
+
+/**
+* @brief     Sets function, which starts and stops i2cIntTick
+*
+* Function is called from interrupt with 1, when a bus gets an active job and
+* tick is not running, and with 0, when no bus has an active job. Tick does not
+* have to run, while buses are idle. It is called at once, if a job is active.
+*
+* @param     control Function, or NULL if tick runs all the time
+*
+*/
+void i2cIntSetTickControl (void (*control)(uint8_t run))
+{
+	system_interrupt_enter_critical_section();
+	i2cIntTickControl = control;
+	i2cIntTickRun = 0;
+	i2c_int_tick_update();
+	system_interrupt_leave_critical_section();
+}
+
+#if I2C_INT_STATS
+/**
+* @brief     Sets clock used for statistics
+*
+* Clock must count up and wrap from 0xFFFFFFFF to 0.
+*
+* @param     now Function returning clock ticks
+* @param     ticksPerUs Number of ticks in one us
+*
+*/
+void i2cIntStatsSetClock (uint32_t (*now)(void), uint32_t ticksPerUs)
+{
+	system_interrupt_enter_critical_section();
+	i2cIntStatsClock = now;
+	i2cIntStatsTicksPerUs = ticksPerUs ? ticksPerUs : 1;
+	system_interrupt_leave_critical_section();
+}
+
+
+/**
+* @brief     Clears statistics of bus and all devices
+* @param     bus I2C bus
+*
+*/
+void i2cIntBusStatsReset (i2cIntBus_t *bus)
+{
+	system_interrupt_enter_critical_section();
+	i2c_int_stats_clear(&bus->stats, 0);
+	bus->devStatsCnt = 0;
+	system_interrupt_leave_critical_section();
+}
+
+
+/**
+* @brief     Same as i2cIntBusStatsReset, on on board bus
+*
+*/
+void i2cIntStatsReset (void)
+{
+	i2cIntBusStatsReset(&i2cIntOnBoard);
+}
+
+
+/**
+* @brief     Copies statistics of a device
+* @param     bus I2C bus
+* @param     deviceAddress Address of slave
+* @param     stats Returns statistics
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if device has no statistics
+*
+*/
+i2cIntRet_t i2cIntBusStatsGet (i2cIntBus_t *bus, uint8_t deviceAddress, i2cIntStats_t *stats)
+{
+	i2cIntRet_t ret = I2C_INT_ERR;
+	uint8_t n;
+	
+	system_interrupt_enter_critical_section();
+	for(n = 0; n < bus->devStatsCnt; n++)
+	{
+		if(bus->devStats[n].deviceAddress == deviceAddress)
+		{
+			*stats = bus->devStats[n];
+			ret = I2C_INT_OK;
+			break;
+		}
+	}
+	system_interrupt_leave_critical_section();
+	return ret;
+}
+
+
+/**
+* @brief     Same as i2cIntBusStatsGet, on on board bus
+*
+*/
+i2cIntRet_t i2cIntStatsGet (uint8_t deviceAddress, i2cIntStats_t *stats)
+{
+	return i2cIntBusStatsGet(&i2cIntOnBoard, deviceAddress, stats);
+}
+
+
+/**
+* @brief     Copies statistics of whole bus
+* @param     bus I2C bus
+* @param     stats Returns statistics
+*
+*/
+void i2cIntBusStatsGetBus (i2cIntBus_t *bus, i2cIntStats_t *stats)
+{
+	system_interrupt_enter_critical_section();
+	*stats = bus->stats;
+	system_interrupt_leave_critical_section();
+}
+
+
+/**
+* @brief     Same as i2cIntBusStatsGetBus, on on board bus
+*
+*/
+void i2cIntStatsGetBus (i2cIntStats_t *stats)
+{
+	i2cIntBusStatsGetBus(&i2cIntOnBoard, stats);
+}
+
+
+/**
+* @brief     Writes statistics of bus and all devices as text
+*
+* Statistics are copied one at a time, so they can be written to a slow
+* debug channel while jobs are running.
+*
+* @param     bus I2C bus
+* @param     putStr Function writing a string, for example to UART
+*
+*/
+void i2cIntBusStatsDump (i2cIntBus_t *bus, void (*putStr)(const char *str))
+{
+	i2cIntStats_t stats;
+	uint8_t n;
+	
+	i2cIntBusStatsGetBus(bus, &stats);
+	i2c_int_stats_print(putStr, &stats);
+	for(n = 0; n < bus->devStatsCnt; n++)
+	{
+		system_interrupt_enter_critical_section();
+		stats = bus->devStats[n];
+		system_interrupt_leave_critical_section();
+		i2c_int_stats_print(putStr, &stats);
+	}
+}
+
+
+/**
+* @brief     Same as i2cIntBusStatsDump, on on board bus
+*
+*/
+void i2cIntStatsDump (void (*putStr)(const char *str))
+{
+	i2cIntBusStatsDump(&i2cIntOnBoard, putStr);
 }
+#endif
@@ -14,10 +14,75 @@
 /**
 * @file		I2C_Int.h
 * @brief	This is driver for on boaard I2C bus, connecting Thermometer,
-*			Accelerometer and OLED Display. This is only basic driver, supporting
-*			only non interrupt or DMA operations.
+*			Accelerometer and OLED Display.
 * @date		04.10.2019
-* @version	0.1
+* @version	0.5
+*
+* @details
+* Transfers are done in interrupts, using ASF I2C master job API. Each transfer is
+* described by a job, which is placed in a queue. Jobs are sorted by priority of the
+* device they address, jobs with the same priority are done in order of submission.
+* Job, that is already on the bus, is always finished, so a large transfer should be
+* split into several jobs, to let other devices use the bus in between.
+*
+* Transfers of at least I2C_INT_DMA_THRESHOLD bytes are done by DMA. Both directions
+* use automatic length of SERCOM, which sends stop by itself, so they are limited to
+* 255 bytes; longer transfers are done in interrupts. Whole transmit, register address
+* included, is one DMA transfer. Job is finished from SERCOM interrupt, when the last
+* byte is on the bus, so no interrupt waits for the bus. Slave, that does not
+* acknowledge before the last byte, stops the transfer; SERCOM sets length error and
+* job is finished with NACK from its ERROR interrupt. Receive sends register address in interrupts and
+* reads data by DMA after repeated start, SERCOM sends NACK and stop after last byte.
+*
+* Driver owns DMA controller: it resets it, places its descriptors at BASEADDR and
+* WRBADDR and defines DMAC_Handler. Other code must not use DMAC, bus initialization
+* fails, if DMAC has already been enabled by someone else.
+*
+* Job and packet are owned by caller and must stay valid until the job is finished.
+* Caller can poll job status or get a callback, which is called from interrupt.
+* i2cIntTx and i2cIntRx submit a job and wait for it, they must not be called from
+* interrupts or with interrupts disabled.
+*
+* Every job ends with a status, which tells what went wrong: slave did not acknowledge
+* (I2C_INT_NACK), bus error or lost arbitration (I2C_INT_BUS_ERR) or transfer did not
+* finish in time (I2C_INT_TIMEOUT). If slave does not acknowledge its address, job is
+* put back in queue and tried again, as many times as set for the device.
+*
+* i2cIntTick must be called every millisecond while a job is active, for example
+* from a software timer. Function given to i2cIntSetTickControl is told when to
+* start and stop it, so there is no tick interrupt while buses are idle. Each job
+* gets a time limit computed from its length and clock frequency. When it runs out,
+* or when bus error is detected, transfer is aborted and bus is recovered: SCL is
+* toggled until a slave holding SDA low releases it, stop condition is sent and I2C
+* module is restarted. So a misbehaving slave can block the bus for at most the time
+* limit of one job. Without i2cIntTick, jobs are not timed.
+*
+* Each device can have its own clock frequency, up to 1 MHz. Frequencies above
+* I2C_INT_CLK_FM_MAX use Fast-mode Plus and stronger drive of SDA and SCL pins.
+* Clock is changed between jobs, when next job addresses a device with different
+* clock, so it costs a short restart of I2C module only when target changes.
+* Slowest device on the bus must still ignore transfers at the fastest clock.
+*
+* If I2C_INT_STATS is 1, driver counts jobs, bytes, NACKs, timeouts, bus errors,
+* retries and time on the bus, for the whole bus and for each device. Latency of a
+* job is measured from submit to finish, so it includes waiting in queue, and is
+* kept as minimum, average, maximum and log2 histogram. Time is taken from SysTick,
+* which runs without interrupt and must be read at least every 0.3 s during a job,
+* or from a clock given with i2cIntStatsSetClock.
+*
+* Driver can run several buses at once. Each bus is an i2cIntBus_t object with its
+* own SERCOM, pins, DMA channel, queue, device table and statistics, initialized
+* with i2cIntBusInit and used with i2cIntBus... functions. On board bus is
+* i2cIntOnBoard, functions without bus argument use it. Bus on GPIO header uses
+* SERCOM3 on PA22 (SDA) and PA23 (SCL), it is described by i2cIntHeaderConfig:
+*
+* @code
+* i2cIntBus_t headerBus;
+* i2cIntBusInit(&headerBus, &i2cIntHeaderConfig, 400);
+* i2cIntBusTx(&headerBus, &packet);
+* @endcode
+*
+* One i2cIntTick serves all buses. Clock for statistics is shared.
 */
 
 #ifndef _I2C_INIT_H_
@@ -30,6 +95,7 @@
 #include "samd21g18a.h"
 #include "sercom.h"
 #include "i2c_master.h"
+#include "i2c_master_interrupt.h"
 #include "ioport.h"
 
 
@@ -39,9 +105,39 @@
 /** @brief On board I2C minimum clock frequency in  kHz */
 #define I2C_INT_CLK_MIN		50
 /** @brief On board I2C maximum clock frequency in  kHz */
-#define I2C_INT_CLK_MAX		400
+#define I2C_INT_CLK_MAX		1000
+/** @brief Maximum clock frequency in kHz of Fast-mode, Fast-mode Plus is used above it */
+#define I2C_INT_CLK_FM_MAX	400
 /** @brief On board I2C default clock frequency in  kHz */
 #define I2C_INT_CLK_DEFAULT	100
+/** @brief Number of devices, which can have priority, retries or clock set */
+#define I2C_INT_DEVICE_NBR	4
+/** @brief Highest job priority */
+#define I2C_INT_PRIO_HIGH		0
+/** @brief Priority of devices, which have not been given one */
+#define I2C_INT_PRIO_DEFAULT	1
+/** @brief Lowest job priority */
+#define I2C_INT_PRIO_LOW		2
+/** @brief Minimum data length transferred by DMA, 0 disables DMA */
+#define I2C_INT_DMA_THRESHOLD	16
+/** @brief Maximum number of initialized buses */
+#define I2C_INT_BUS_NBR			2
+/** @brief Number of DMA channels, from 0 on, which buses can use */
+#define I2C_INT_DMA_CH_NBR		2
+/** @brief Maximum number of buffers in one vector transfer */
+#define I2C_INT_VEC_MAX			4
+/** @brief Retries after address NACK for devices, which have not been given a number */
+#define I2C_INT_RETRY_DEFAULT	1
+/** @brief Time limit of a job in ms, on top of time needed for its bytes */
+#define I2C_INT_TIMEOUT_MIN		2
+/** @brief Bit times allowed for each byte, twice the nominal 9 to allow clock stretching */
+#define I2C_INT_TIMEOUT_BYTE_BITS	18
+/** @brief Set to 0 to remove statistics */
+#define I2C_INT_STATS			1
+/** @brief Number of devices with their own statistics */
+#define I2C_INT_STATS_NBR		4
+/** @brief Number of bins in latency histogram */
+#define I2C_INT_HIST_BINS		16
 
 
 /****************************************************************************************
@@ -65,9 +161,116 @@ typedef enum
 {
 	I2C_INT_ERR,		/**< I2C error */
 	I2C_INT_BUSY,		/**< I2C bussy */
-	I2C_INT_OK			/**< I2C ok */
+	I2C_INT_OK,			/**< I2C ok */
+	I2C_INT_NACK,		/**< Slave did not acknowledge address or data */
+	I2C_INT_TIMEOUT,	/**< Transfer did not finish in time */
+	I2C_INT_BUS_ERR		/**< Bus error or lost arbitration */
 }i2cIntRet_t;
 
+/** @brief One buffer of a vector transfer */
+typedef struct
+{
+	const uint8_t *data;		/**< Pointer to data */
+	uint16_t len;				/**< Length of data */
+}i2cIntVec_t;
+
+typedef struct i2cIntJob_s i2cIntJob_t;
+
+/** @brief On board I2C job, one queued transfer */
+struct i2cIntJob_s
+{
+	i2cIntPacket_t *packet;				/**< Transfer description */
+	void (*callback)(i2cIntJob_t *job);	/**< Called from interrupt when job is finished, or NULL */
+	const i2cIntVec_t *vec;				/**< Buffers of vector transfer */
+	i2cIntJob_t *next;					/**< Next job in queue */
+	volatile i2cIntRet_t status;		/**< I2C_INT_BUSY until job is finished, then result */
+	uint8_t priority;					/**< Priority, lower number is done first */
+	uint8_t direction;					/**< Transmit or receive */
+	uint8_t phase;						/**< Register address or data phase */
+	uint8_t vecCnt;						/**< Number of buffers in vec, 0 for packet buffer */
+	uint8_t seg;						/**< Next segment to transmit */
+	uint8_t segCnt;						/**< Number of segments to transmit */
+	uint8_t retry;						/**< Remaining retries after address NACK */
+	uint16_t timeout;					/**< Time limit in ms */
+	uint16_t clk;						/**< Clock frequency in kHz */
+#if I2C_INT_STATS
+	uint32_t bytes;						/**< Number of bytes after slave address */
+	uint32_t submitTime;				/**< Clock ticks when job was submitted */
+	uint32_t startTime;					/**< Clock ticks when job was started on the bus */
+#endif
+};
+
+/** @brief Settings of one device on on board I2C */
+typedef struct
+{
+	uint8_t deviceAddress;		/**< Address of slave */
+	uint8_t priority;			/**< Priority of jobs for this slave */
+	uint8_t retries;			/**< Retries after address NACK */
+	uint16_t clk;				/**< Clock frequency in kHz, 0 for bus clock */
+}i2cIntDevice_t;
+
+
+/** @brief Statistics of jobs of one device or of whole bus */
+typedef struct
+{
+	uint32_t jobs;							/**< Finished jobs */
+	uint32_t failed;						/**< Jobs finished with error */
+	uint32_t bytes;							/**< Bytes of successful jobs, after slave address */
+	uint32_t nacks;							/**< NACKs, including retried ones */
+	uint32_t timeouts;						/**< Jobs aborted by time limit */
+	uint32_t busErrors;						/**< Bus errors and lost arbitrations */
+	uint32_t retries;						/**< Retries after address NACK */
+	uint64_t busyUs;						/**< Time on the bus in us */
+	uint64_t latSum;						/**< Sum of latencies in us, for average */
+	uint32_t latMin;						/**< Minimum latency in us */
+	uint32_t latMax;						/**< Maximum latency in us */
+	uint32_t hist[I2C_INT_HIST_BINS];		/**< Bin n counts latencies from 2^n to 2^(n+1)-1 us, last bin all longer */
+	uint8_t deviceAddress;					/**< Address of slave, 0 for whole bus */
+}i2cIntStats_t;
+
+/** @brief Hardware of one I2C bus */
+typedef struct
+{
+	Sercom *hw;					/**< SERCOM module */
+	uint32_t pinmuxSda;			/**< ASF pinmux of SDA, on pad 0 */
+	uint32_t pinmuxScl;			/**< ASF pinmux of SCL, on pad 1 */
+	uint8_t dmaCh;				/**< DMA channel, below I2C_INT_DMA_CH_NBR */
+}i2cIntBusConfig_t;
+
+/** @brief State of one I2C bus */
+typedef struct
+{
+	struct i2c_master_module module;		/**< ASF module, must be first */
+	struct i2c_master_packet data;			/**< ASF packet of current phase */
+	COMPILER_ALIGNED(16) DmacDescriptor dmaChain[I2C_INT_VEC_MAX];	/**< Linked descriptors of vector transfer */
+	const i2cIntBusConfig_t *config;		/**< Hardware of the bus */
+	uint8_t regAddr[2];						/**< Register address bytes of active job, static for DMA */
+	i2cIntJob_t *volatile active;			/**< Job on the bus, or NULL */
+	i2cIntJob_t *queue;						/**< Waiting jobs, sorted by priority */
+	i2cIntDevice_t devices[I2C_INT_DEVICE_NBR];	/**< Device settings */
+	uint8_t deviceCnt;						/**< Number of used entries in devices */
+	uint32_t clk;							/**< Default clock frequency in kHz */
+	uint32_t busClk;						/**< Clock frequency in kHz, module is set to */
+	uint32_t gclk;							/**< Frequency of SERCOM core clock in Hz */
+	volatile uint16_t timeLeft;				/**< Time left for active job in ms, 0 if not timed */
+	IRQn_Type irq;							/**< SERCOM interrupt */
+	uint8_t dmaTxId;						/**< DMA trigger of SERCOM transmit */
+	uint8_t dmaRxId;						/**< DMA trigger of SERCOM receive */
+#if I2C_INT_STATS
+	i2cIntStats_t stats;					/**< Statistics of whole bus */
+	i2cIntStats_t devStats[I2C_INT_STATS_NBR];	/**< Statistics of devices */
+	uint8_t devStatsCnt;					/**< Number of used entries in devStats */
+#endif
+}i2cIntBus_t;
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+extern i2cIntBus_t i2cIntOnBoard;
+extern const i2cIntBusConfig_t i2cIntOnBoardConfig;
+extern const i2cIntBusConfig_t i2cIntHeaderConfig;
+
 
 /****************************************************************************************
 * Function prototypes
@@ -75,5 +278,37 @@ typedef enum
 void i2cIntInit(uint32_t clk);
 i2cIntRet_t i2cIntTx ( i2cIntPacket_t *packet);
 i2cIntRet_t i2cIntRx (i2cIntPacket_t *packet);
+i2cIntRet_t i2cIntTxv (i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt);
+i2cIntRet_t i2cIntSubmitTx (i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntSubmitTxv (i2cIntJob_t *job, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntSubmitRx (i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntJobGetStatus (i2cIntJob_t *job);
+i2cIntRet_t i2cIntJobWait (i2cIntJob_t *job);
+i2cIntRet_t i2cIntSetDevicePriority (uint8_t deviceAddress, uint8_t priority);
+i2cIntRet_t i2cIntSetDeviceRetries (uint8_t deviceAddress, uint8_t retries);
+i2cIntRet_t i2cIntSetDeviceClock (uint8_t deviceAddress, uint32_t clk);
+void i2cIntTick (void);
+void i2cIntSetTickControl (void (*control)(uint8_t run));
+i2cIntRet_t i2cIntBusInit (i2cIntBus_t *bus, const i2cIntBusConfig_t *config, uint32_t clk);
+i2cIntRet_t i2cIntBusTx (i2cIntBus_t *bus, i2cIntPacket_t *packet);
+i2cIntRet_t i2cIntBusRx (i2cIntBus_t *bus, i2cIntPacket_t *packet);
+i2cIntRet_t i2cIntBusTxv (i2cIntBus_t *bus, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt);
+i2cIntRet_t i2cIntBusSubmitTx (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntBusSubmitTxv (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, const i2cIntVec_t *vec, uint8_t cnt, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntBusSubmitRx (i2cIntBus_t *bus, i2cIntJob_t *job, i2cIntPacket_t *packet, void (*callback)(i2cIntJob_t *job));
+i2cIntRet_t i2cIntBusSetDevicePriority (i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t priority);
+i2cIntRet_t i2cIntBusSetDeviceRetries (i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t retries);
+i2cIntRet_t i2cIntBusSetDeviceClock (i2cIntBus_t *bus, uint8_t deviceAddress, uint32_t clk);
+#if I2C_INT_STATS
+void i2cIntStatsSetClock (uint32_t (*now)(void), uint32_t ticksPerUs);
+void i2cIntStatsReset (void);
+i2cIntRet_t i2cIntStatsGet (uint8_t deviceAddress, i2cIntStats_t *stats);
+void i2cIntStatsGetBus (i2cIntStats_t *stats);
+void i2cIntStatsDump (void (*putStr)(const char *str));
+void i2cIntBusStatsReset (i2cIntBus_t *bus);
+i2cIntRet_t i2cIntBusStatsGet (i2cIntBus_t *bus, uint8_t deviceAddress, i2cIntStats_t *stats);
+void i2cIntBusStatsGetBus (i2cIntBus_t *bus, i2cIntStats_t *stats);
+void i2cIntBusStatsDump (i2cIntBus_t *bus, void (*putStr)(const char *str));
+#endif
 
 #endif /*_I2C_INIT_H_ */
\ No newline at end of file
@@ -0,0 +1,316 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		I2C_RegCache.c
+* @brief	Register cache for devices on on board I2C bus.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "I2C_RegCache.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Maximum number of clean registers written again to join two dirty runs */
+#define I2C_REGCACHE_GAP_MAX	2
+
+
+/**
+* @brief     Reads registers from device
+* @param     cache Register cache
+* @param     n Index of first register
+* @param     len Number of registers
+* @param     data Receive buffer
+* @return    Status of transfer
+*
+*/
+static i2cIntRet_t i2c_regcache_rx (i2cRegCache_t *cache, uint16_t n, uint16_t len, uint8_t *data)
+{
+	cache->packet.regAddress = cache->base + n;
+	cache->packet.rxBuff = data;
+	cache->packet.rxLen = len;
+	return i2cIntBusRx(cache->bus, &cache->packet);
+}
+
+/**
+* @brief     Writes registers to device
+* @param     cache Register cache
+* @param     n Index of first register
+* @param     len Number of registers
+* @param     data Data to write
+* @return    Status of transfer
+*
+*/
+static i2cIntRet_t i2c_regcache_tx (i2cRegCache_t *cache, uint16_t n, uint16_t len, uint8_t *data)
+{
+	cache->packet.regAddress = cache->base + n;
+	cache->packet.txBuff = data;
+	cache->packet.txLen = len;
+	return i2cIntBusTx(cache->bus, &cache->packet);
+}
+
+
+/**
+* @brief     Initializes register cache
+*
+* All registers are invalid after init. Volatile flags, which are already set
+* in flags array, are kept.
+*
+* @param     cache Register cache
+* @param     bus I2C bus, NULL for on board bus
+* @param     deviceAddress Address of slave
+* @param     regAddrLen Length of register address in bytes
+* @param     base Address of first cached register
+* @param     count Number of cached registers
+* @param     values Array of count values
+* @param     flags Array of count flags
+* @param     policy Write policy
+*/
+void i2cRegCacheInit (i2cRegCache_t *cache, i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t regAddrLen,
+					  uint16_t base, uint16_t count, uint8_t *values, uint8_t *flags, i2cRegCachePolicy_t policy)
+{
+	cache->bus = bus ? bus : &i2cIntOnBoard;
+	cache->packet.deviceAddress = deviceAddress;
+	cache->packet.regAddrLen = regAddrLen;
+	cache->values = values;
+	cache->flags = flags;
+	cache->base = base;
+	cache->count = count;
+	cache->policy = policy;
+	cache->burst = 1;
+	i2cRegCacheInvalidate(cache);
+}
+
+/**
+* @brief     Sets, if device increments register address in a transfer
+*
+* Burst is enabled after init. Disable it for devices, which take only one register
+* per transfer, then i2cRegCacheSync writes every dirty register separately.
+*
+* @param     cache Register cache
+* @param     burst 1 if device increments register address, 0 otherwise
+*/
+void i2cRegCacheSetBurst (i2cRegCache_t *cache, uint8_t burst)
+{
+	cache->burst = burst;
+}
+
+/**
+* @brief     Reads a register
+*
+* Value is taken from cache if it is known, otherwise it is read from device.
+*
+* @param     cache Register cache
+* @param     reg Register address
+* @param     value Returns register value
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if register is not cached, or error of the transfer
+*/
+i2cIntRet_t i2cRegCacheRead (i2cRegCache_t *cache, uint16_t reg, uint8_t *value)
+{
+	uint16_t n = reg - cache->base;
+	i2cIntRet_t ret;
+
+	if((reg < cache->base) || (n >= cache->count))
+	{
+		return I2C_INT_ERR;
+	}
+	if(!(cache->flags[n] & I2C_REGCACHE_VOLATILE) && (cache->flags[n] & (I2C_REGCACHE_VALID | I2C_REGCACHE_DIRTY)))
+	{
+		*value = cache->values[n];
+		return I2C_INT_OK;
+	}
+
+	ret = i2c_regcache_rx(cache, n, 1, value);
+	if((ret == I2C_INT_OK) && !(cache->flags[n] & I2C_REGCACHE_VOLATILE))
+	{
+		cache->values[n] = *value;
+		cache->flags[n] |= I2C_REGCACHE_VALID;
+	}
+	return ret;
+}
+
+/**
+* @brief     Writes a register
+*
+* Write is skipped if register already has this value. Volatile registers are
+* always written immediately, other registers according to write policy.
+*
+* @param     cache Register cache
+* @param     reg Register address
+* @param     value New value
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if register is not cached, or error of the transfer
+*/
+i2cIntRet_t i2cRegCacheWrite (i2cRegCache_t *cache, uint16_t reg, uint8_t value)
+{
+	uint16_t n = reg - cache->base;
+	uint8_t *flags;
+	i2cIntRet_t ret;
+
+	if((reg < cache->base) || (n >= cache->count))
+	{
+		return I2C_INT_ERR;
+	}
+	flags = &cache->flags[n];
+
+	if(*flags & I2C_REGCACHE_VOLATILE)
+	{
+		return i2c_regcache_tx(cache, n, 1, &value);
+	}
+	if((*flags & (I2C_REGCACHE_VALID | I2C_REGCACHE_DIRTY)) && (cache->values[n] == value))
+	{
+		return I2C_INT_OK;
+	}
+
+	cache->values[n] = value;
+	if(cache->policy == I2C_REGCACHE_WRITE_BACK)
+	{
+		*flags = (*flags & ~I2C_REGCACHE_VALID) | I2C_REGCACHE_DIRTY;
+		return I2C_INT_OK;
+	}
+
+	/* Value in device is unknown, until write succeeds */
+	*flags &= ~(I2C_REGCACHE_VALID | I2C_REGCACHE_DIRTY);
+	ret = i2c_regcache_tx(cache, n, 1, &cache->values[n]);
+	if(ret == I2C_INT_OK)
+	{
+		*flags |= I2C_REGCACHE_VALID;
+	}
+	return ret;
+}
+
+/**
+* @brief     Changes some bits of a register
+* @param     cache Register cache
+* @param     reg Register address
+* @param     mask Bits to change
+* @param     value New value of bits
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR if register is not cached, or error of the transfer
+*/
+i2cIntRet_t i2cRegCacheUpdateBits (i2cRegCache_t *cache, uint16_t reg, uint8_t mask, uint8_t value)
+{
+	uint8_t old;
+	i2cIntRet_t ret;
+
+	ret = i2cRegCacheRead(cache, reg, &old);
+	if(ret != I2C_INT_OK)
+	{
+		return ret;
+	}
+	return i2cRegCacheWrite(cache, reg, (old & ~mask) | (value & mask));
+}
+
+/**
+* @brief     Writes all dirty registers to device
+*
+* If device increments register address, consecutive dirty registers are written in
+* one transfer. Up to I2C_REGCACHE_GAP_MAX clean registers with known value
+* are written again, if that joins two runs of dirty registers. Volatile registers
+* are never included.
+*
+* @param     cache Register cache
+* @return    I2C_INT_OK on success
+*			 error of the first failed transfer, registers not written stay dirty
+*/
+i2cIntRet_t i2cRegCacheSync (i2cRegCache_t *cache)
+{
+	uint8_t *flags = cache->flags;
+	uint16_t n, end, next;
+	i2cIntRet_t ret;
+
+	n = 0;
+	while(n < cache->count)
+	{
+		if(!(flags[n] & I2C_REGCACHE_DIRTY))
+		{
+			n++;
+			continue;
+		}
+
+		end = n + 1;
+		next = end;
+		while(cache->burst && (next < cache->count))
+		{
+			if(flags[next] & I2C_REGCACHE_DIRTY)
+			{
+				end = ++next;
+			}
+			else if(((flags[next] & (I2C_REGCACHE_VOLATILE | I2C_REGCACHE_VALID)) == I2C_REGCACHE_VALID) &&
+					((next - end) < I2C_REGCACHE_GAP_MAX))
+			{
+				next++;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		ret = i2c_regcache_tx(cache, n, end - n, &cache->values[n]);
+		if(ret != I2C_INT_OK)
+		{
+			return ret;
+		}
+		for(; n < end; n++)
+		{
+			flags[n] = (flags[n] & ~I2C_REGCACHE_DIRTY) | I2C_REGCACHE_VALID;
+		}
+	}
+	return I2C_INT_OK;
+}
+
+/**
+* @brief     Forgets all cached values
+*
+* Call this after device has been reset. Dirty registers are not written.
+*
+* @param     cache Register cache
+*/
+void i2cRegCacheInvalidate (i2cRegCache_t *cache)
+{
+	uint16_t n;
+
+	for(n = 0; n < cache->count; n++)
+	{
+		cache->flags[n] &= ~(I2C_REGCACHE_VALID | I2C_REGCACHE_DIRTY);
+	}
+}
+
+/**
+* @brief     Marks all known registers dirty
+*
+* Call this after device has lost its configuration, for example after power
+* down, and then i2cRegCacheSync to restore it.
+*
+* @param     cache Register cache
+*/
+void i2cRegCacheMarkDirty (i2cRegCache_t *cache)
+{
+	uint16_t n;
+
+	for(n = 0; n < cache->count; n++)
+	{
+		if(!(cache->flags[n] & I2C_REGCACHE_VOLATILE) && (cache->flags[n] & (I2C_REGCACHE_VALID | I2C_REGCACHE_DIRTY)))
+		{
+			cache->flags[n] = (cache->flags[n] & ~I2C_REGCACHE_VALID) | I2C_REGCACHE_DIRTY;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		I2C_RegCache.h
+* @brief	Register cache for devices on I2C bus.
+* @date		19.10.2026
+* @version	0.3
+*
+* @details
+* Cache keeps a copy of a range of 8 bit registers of one device. Reading a cached
+* register does not use the bus and writing the value, that register already has,
+* is skipped.
+*
+* Each register has flags. Registers marked I2C_REGCACHE_VOLATILE (status, data,
+* interrupt source) can be changed by the device, so they are always read from and
+* written to the device. Other registers become valid after they are read or written
+* once.
+*
+* With write through policy every changed value is written immediately. With write
+* back policy writes only change the cache and mark registers dirty, and
+* i2cRegCacheSync writes all dirty registers later. If device increments register
+* address by itself, consecutive dirty registers are written in one transfer. This is
+* the default, i2cRegCacheSetBurst disables it for devices that do not.
+*
+* Values and flags arrays are given by the caller, so that flags can be initialized
+* with volatile registers. Cache uses blocking i2cIntBusTx and i2cIntBusRx on the bus
+* given to i2cRegCacheInit, so it must not be used from interrupts.
+*/
+
+#ifndef I2C_REGCACHE_H_
+#define I2C_REGCACHE_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "I2C_Int.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Register is changed by device, it is never cached */
+#define I2C_REGCACHE_VOLATILE	0x01
+/** @brief Cached value is the same as in device */
+#define I2C_REGCACHE_VALID		0x02
+/** @brief Cached value has not been written to device yet */
+#define I2C_REGCACHE_DIRTY		0x04
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Write policy */
+typedef enum
+{
+	I2C_REGCACHE_WRITE_THROUGH,		/**< Changed value is written immediately */
+	I2C_REGCACHE_WRITE_BACK			/**< Changed value is written by i2cRegCacheSync */
+}i2cRegCachePolicy_t;
+
+/** @brief Register cache object */
+typedef struct
+{
+	i2cIntBus_t *bus;				/**< Bus of the device */
+	i2cIntPacket_t packet;			/**< Packet used for transfers */
+	uint8_t *values;				/**< Cached values, one for each register */
+	uint8_t *flags;					/**< Flags, one for each register */
+	uint16_t base;					/**< Address of first cached register */
+	uint16_t count;					/**< Number of cached registers */
+	i2cRegCachePolicy_t policy;		/**< Write policy */
+	uint8_t burst;					/**< Device increments register address in a transfer */
+}i2cRegCache_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void i2cRegCacheInit (i2cRegCache_t *cache, i2cIntBus_t *bus, uint8_t deviceAddress, uint8_t regAddrLen,
+					  uint16_t base, uint16_t count, uint8_t *values, uint8_t *flags, i2cRegCachePolicy_t policy);
+void i2cRegCacheSetBurst (i2cRegCache_t *cache, uint8_t burst);
+i2cIntRet_t i2cRegCacheRead (i2cRegCache_t *cache, uint16_t reg, uint8_t *value);
+i2cIntRet_t i2cRegCacheWrite (i2cRegCache_t *cache, uint16_t reg, uint8_t value);
+i2cIntRet_t i2cRegCacheUpdateBits (i2cRegCache_t *cache, uint16_t reg, uint8_t mask, uint8_t value);
+i2cIntRet_t i2cRegCacheSync (i2cRegCache_t *cache);
+void i2cRegCacheInvalidate (i2cRegCache_t *cache);
+void i2cRegCacheMarkDirty (i2cRegCache_t *cache);
+
+
+
+#endif /* I2C_REGCACHE_H_ */
@@ -0,0 +1,126 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		I2C_Script.c
+* @brief	Player of command scripts for devices on on board I2C bus.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "I2C_Script.h"
+
+
+/**
+* @brief     Plays a script
+*
+* Writes are collected and sent with i2cIntBusTxv, so function waits for every
+* transfer and must not be called from interrupts.
+*
+* @param     bus I2C bus, NULL for on board bus
+* @param     deviceAddress Address of slave, until script changes it
+* @param     script Script, ended with I2C_SCRIPT_END
+* @param     delay Function waiting given number of ms, may be NULL if script has no delays
+* @return    I2C_INT_OK on success
+*			 I2C_INT_ERR on unknown opcode or delay without delay function,
+*			 or error of the first failed transfer
+*
+*/
+i2cIntRet_t i2cScriptRun (i2cIntBus_t *bus, uint8_t deviceAddress, const uint8_t *script, void (*delay)(uint16_t ms))
+{
+	i2cIntPacket_t packet;
+	i2cIntVec_t vec[I2C_INT_VEC_MAX];
+	i2cIntRet_t ret = I2C_INT_OK;
+	uint8_t cnt = 0;
+	uint8_t op, lastOp = I2C_SCRIPT_OP_END;
+	uint8_t reg, len;
+	uint16_t nextReg = 0;
+
+	if(!bus)
+	{
+		bus = &i2cIntOnBoard;
+	}
+	packet.deviceAddress = deviceAddress;
+	packet.regAddrLen = 1;
+
+	while(1)
+	{
+		op = *script++;
+
+		if((op == I2C_SCRIPT_OP_WRITE) || (op == I2C_SCRIPT_OP_STREAM))
+		{
+			reg = script[0];
+			len = script[1];
+			script += 2;
+
+			/* Join to collected writes, if bytes follow them on the device */
+			if(!cnt || (op != lastOp) || (cnt == I2C_INT_VEC_MAX) || (reg != nextReg))
+			{
+				if(cnt)
+				{
+					ret = i2cIntBusTxv(bus, &packet, vec, cnt);
+					if(ret != I2C_INT_OK)
+					{
+						return ret;
+					}
+				}
+				cnt = 0;
+				packet.regAddress = reg;
+				nextReg = reg;
+			}
+			vec[cnt].data = script;
+			vec[cnt].len = len;
+			cnt++;
+			lastOp = op;
+			if(op == I2C_SCRIPT_OP_WRITE)
+			{
+				nextReg += len;
+			}
+			script += len;
+			continue;
+		}
+
+		/* Everything else ends collected writes */
+		if(cnt)
+		{
+			ret = i2cIntBusTxv(bus, &packet, vec, cnt);
+			if(ret != I2C_INT_OK)
+			{
+				return ret;
+			}
+			cnt = 0;
+		}
+
+		switch (op)
+		{
+			case I2C_SCRIPT_OP_END:
+				return I2C_INT_OK;
+			case I2C_SCRIPT_OP_DELAY:
+				if(!delay)
+				{
+					return I2C_INT_ERR;
+				}
+				delay((uint16_t)(script[0] | (script[1] << 8)));
+				script += 2;
+				break;
+			case I2C_SCRIPT_OP_DEVICE:
+				packet.deviceAddress = *script++;
+				break;
+			default:
+				return I2C_INT_ERR;
+		}
+	}
+}
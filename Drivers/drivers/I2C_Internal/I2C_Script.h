@@ -0,0 +1,88 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+/**
+* @file		I2C_Script.h
+* @brief	Player of command scripts for devices on I2C bus.
+* @date		19.10.2026
+* @version	0.2
+*
+* @details
+* Script is a constant byte array, which is kept in flash and built with macros below:
+*
+* @code
+* static const uint8_t init[] =
+* {
+*	I2C_SCRIPT_WRITE(0x20, 0x57, 0x00),		// two registers from 0x20
+*	I2C_SCRIPT_DELAY(10),
+*	I2C_SCRIPT_STREAM(0x00, 0xAE, 0xAF),	// two bytes into register 0x00
+*	I2C_SCRIPT_END
+* };
+* @endcode
+*
+* I2C_SCRIPT_WRITE writes registers, which device increments by itself. Next write
+* is joined to the same transfer, if it continues at the next register.
+* I2C_SCRIPT_STREAM writes all bytes into the same register, like commands of a
+* display controller. Next stream to the same register is joined to the same transfer.
+* At most I2C_INT_VEC_MAX writes are joined, data is sent directly from the script.
+* Delay and device change end the transfer.
+*
+* Script is played on the given bus, NULL selects on board bus i2cIntOnBoard.
+*/
+
+#ifndef I2C_SCRIPT_H_
+#define I2C_SCRIPT_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "I2C_Int.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief End of script */
+#define I2C_SCRIPT_OP_END		0x00
+/** @brief Write registers: register, length, data */
+#define I2C_SCRIPT_OP_WRITE		0x01
+/** @brief Write bytes into one register: register, length, data */
+#define I2C_SCRIPT_OP_STREAM	0x02
+/** @brief Wait: milliseconds, low byte first */
+#define I2C_SCRIPT_OP_DELAY		0x03
+/** @brief Change device: slave address */
+#define I2C_SCRIPT_OP_DEVICE	0x04
+
+/** @brief Number of bytes in argument list, at most 255 */
+#define I2C_SCRIPT_LEN(...)		sizeof((const uint8_t[]){__VA_ARGS__})
+/** @brief Writes registers from reg on */
+#define I2C_SCRIPT_WRITE(reg, ...)		I2C_SCRIPT_OP_WRITE, (reg), I2C_SCRIPT_LEN(__VA_ARGS__), __VA_ARGS__
+/** @brief Writes all bytes into register reg */
+#define I2C_SCRIPT_STREAM(reg, ...)		I2C_SCRIPT_OP_STREAM, (reg), I2C_SCRIPT_LEN(__VA_ARGS__), __VA_ARGS__
+/** @brief Waits ms milliseconds */
+#define I2C_SCRIPT_DELAY(ms)			I2C_SCRIPT_OP_DELAY, (uint8_t)(ms), (uint8_t)((ms) >> 8)
+/** @brief Sends following writes to slave with address adr */
+#define I2C_SCRIPT_DEVICE(adr)			I2C_SCRIPT_OP_DEVICE, (adr)
+/** @brief Ends script */
+#define I2C_SCRIPT_END					I2C_SCRIPT_OP_END
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+i2cIntRet_t i2cScriptRun (i2cIntBus_t *bus, uint8_t deviceAddress, const uint8_t *script, void (*delay)(uint16_t ms));
+
+
+
+#endif /* I2C_SCRIPT_H_ */
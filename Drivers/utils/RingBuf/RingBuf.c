@@ -0,0 +1,121 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		RingBuf.c
+* @brief	Lock free single producer, single consumer ring buffer.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "RingBuf.h"
+#include "samd21.h"
+#include <string.h>
+
+
+/**
+* @brief     Initializes empty ring buffer
+* @param     rb Ring buffer
+* @param     buf Storage of len * itemSize bytes
+* @param     itemSize Size of one item in bytes
+* @param     len Number of items, power of two
+* @return    0 on error, 1 on success
+*/
+uint32_t ringBufInit (ringBuf_t *rb, void *buf, uint16_t itemSize, uint16_t len)
+{
+	if(!buf || !itemSize || !len || (len & (len - 1)) || (len > 0x8000))
+	{
+		return 0;
+	}
+	rb->buf = buf;
+	rb->itemSize = itemSize;
+	rb->mask = len - 1;
+	rb->head = 0;
+	rb->tail = 0;
+	rb->dropped = 0;
+	return 1;
+}
+
+/**
+* @brief     Puts item to ring buffer, called by producer only
+* @param     rb Ring buffer
+* @param     item Item, itemSize bytes are copied
+* @return    0 if buffer is full and item is dropped, 1 on success
+*/
+uint32_t ringBufPut (ringBuf_t *rb, const void *item)
+{
+	const uint16_t head = rb->head;
+	
+	if((uint16_t)(head - rb->tail) > rb->mask)
+	{
+		rb->dropped++;
+		return 0;
+	}
+	memcpy(&rb->buf[(head & rb->mask) * rb->itemSize], item, rb->itemSize);
+	/* Item is stored, before consumer can see it */
+	__DMB();
+	rb->head = head + 1;
+	return 1;
+}
+
+/**
+* @brief     Takes the oldest item from ring buffer, called by consumer only
+* @param     rb Ring buffer
+* @param     item Item, itemSize bytes are copied to it
+* @return    0 if buffer is empty, 1 on success
+*/
+uint32_t ringBufGet (ringBuf_t *rb, void *item)
+{
+	const uint16_t tail = rb->tail;
+	
+	if(rb->head == tail)
+	{
+		return 0;
+	}
+	/* Item is read after head, that published it */
+	__DMB();
+	memcpy(item, &rb->buf[(tail & rb->mask) * rb->itemSize], rb->itemSize);
+	/* Item is copied, before producer can reuse its slot */
+	__DMB();
+	rb->tail = tail + 1;
+	return 1;
+}
+
+/**
+* @brief     Returns number of items in ring buffer
+*
+* Result is exact for the consumer. Producer may see less free space than there is.
+*
+* @param     rb Ring buffer
+* @return    Number of items
+*/
+uint16_t ringBufCount (const ringBuf_t *rb)
+{
+	return (uint16_t)(rb->head - rb->tail);
+}
+
+/**
+* @brief     Returns number of dropped items
+* @param     rb Ring buffer
+* @return    Number of items, that did not fit into buffer
+*/
+uint32_t ringBufDropped (const ringBuf_t *rb)
+{
+	return rb->dropped;
+}
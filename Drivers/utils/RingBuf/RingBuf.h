@@ -0,0 +1,73 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		RingBuf.h
+* @brief	Lock free single producer, single consumer ring buffer.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Ring buffer passes items of fixed size from one producer to one consumer, e.g.
+* from an interrupt to main loop or back, without disabling interrupts. Producer
+* only writes head and consumer only writes tail. Both are 16 bit and free running,
+* so their difference is number of items and all slots can be used. Number of
+* items must be power of two, at most 32768. Store and load of 16 bit index is
+* atomic on Cortex-M0+, memory barrier orders item data and index.
+*
+* Each side must be used from one context only. More producers need their own ring
+* buffers, or a lock. Item, that does not fit into full buffer, is dropped and
+* counted, so loss can be detected.
+*
+* Storage is given by caller:
+*
+* static uint16_t samples[8];
+* static ringBuf_t sampleRing;
+* ringBufInit(&sampleRing, samples, sizeof(samples[0]), 8);
+*/
+
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Ring buffer */
+typedef struct
+{
+	uint8_t *buf;				/**< Storage of items */
+	uint16_t itemSize;			/**< Size of one item in bytes */
+	uint16_t mask;				/**< Number of items - 1 */
+	volatile uint16_t head;		/**< Number of items put, written by producer */
+	volatile uint16_t tail;		/**< Number of items taken, written by consumer */
+	volatile uint32_t dropped;	/**< Items, that did not fit, written by producer */
+}ringBuf_t;
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint32_t ringBufInit (ringBuf_t *rb, void *buf, uint16_t itemSize, uint16_t len);
+uint32_t ringBufPut (ringBuf_t *rb, const void *item);
+uint32_t ringBufGet (ringBuf_t *rb, void *item);
+uint16_t ringBufCount (const ringBuf_t *rb);
+uint32_t ringBufDropped (const ringBuf_t *rb);
+
+#endif /* RINGBUF_H_ */
@@ -19,20 +19,21 @@
 *
 * @details
 * This is demo firmware for MOSI M1 Lite module. It demonstrates use of LED, button, 
-* display and software timer. Device constantly cycles through all LED colors. On button
-* press toggling alternates between faster or slower. Each button press is also counted
-* and displayed on OLED display.
+* display and software timer. Device constantly cycles through all LED colors. OLED
+* shows a menu, in which cycling speed can be toggled between faster and slower and
+* button press counter can be viewed and reset.
 *
 * Led cycling and button reading is done using software timer. At the beginning of code
 * LED timer is configured to change LED color every 600 ms. Button timer is configure to
 * read button every 10 ms. This way all pulses generated when button changes state are 
-* ignored.
+* ignored. Short button press moves to next menu item, long press selects it.
 *
-* After power up, OLED shows logo for a short time, then it displays the number of
-* button presses. Because updating OLED display over I2C is a slow task, it is preformed
-* in main loop and not in the software timer callback function. That way interrupts from
-* other sources can be executed while OLED is being updated. Display is only updated, if
-* new value of button preses is different form the old one. 
+* After power up, OLED shows logo for a short time, then it displays the menu. Because
+* updating OLED display over I2C is a slow task, it is preformed in main loop and not in
+* the software timer callback function. That way interrupts from other sources can be
+* executed while OLED is being updated. Button timer only puts presses and menu events
+* into a ring buffer, which is emptied in main loop. New LED period is passed to LED timer
+* the other way. Menu only sends changed rows to display.
 */
 
 
@@ -42,37 +43,90 @@
 #include "button.h"
 #include "I2C_Int.h"
 #include "display.h"
+#include "numfield.h"
+#include "menu.h"
 //#include "GPIO.h"
 #include "STimer.h"
+#include "Event.h"
+#include "RingBuf.h"
 #include "logo.h"
 
 volatile bool displayNewData = false;
-volatile uint16_t ledUpdateInterval = 600;
-volatile uint32_t btnPressCnt = 0;
+/* Owned by main loop, other contexts get changes through ring buffers */
+uint16_t ledUpdateInterval = 600;
+uint32_t btnPressCnt = 0;
 
 #define LED_TMR	0
 #define BTN_TMR	1
 #define CLK_TMR	2
+#define I2C_TMR	3
+
+/* Button held for this many button task periods (10 ms) is a long press */
+#define BTN_LONG_PRESS	60
+
+/* Priority of display refresh events */
+#define EVT_PRIO_DISPLAY	1
+
+/* Button task item for a press, other items are menu events */
+#define BTN_EVT_PRESS	0xFF
+
+menu_t mainMenu;
+
+/* Button task (PendSV) passes presses and menu events to main loop */
+static uint8_t btnEvtBuf[8];
+static ringBuf_t btnEvtRing;
+/* Main loop passes new LED period to led task (PendSV) */
+static uint16_t ledPeriodBuf[4];
+static ringBuf_t ledPeriodRing;
+
+void pressCntUpdate (void);
+
+/* Takes button items in main loop */
+static void btnEvtHandler (void *ctx, uint32_t arg)
+{
+	uint8_t evt;
+	(void)arg;
+	while(ringBufGet(&btnEvtRing, &evt))
+	{
+		if(evt == BTN_EVT_PRESS)
+		{
+			btnPressCnt++;
+			pressCntUpdate();
+		}
+		else
+		{
+			menuEvent((menu_t *)ctx, (menuEvent_t)evt);
+		}
+	}
+}
+
+/* Refreshes count of button presses in main loop */
+static void pressCntHandler (void *ctx, uint32_t arg)
+{
+	(void)ctx;
+	(void)arg;
+	pressCntUpdate();
+}
+
+/* Passes button item to main loop */
+static void btnPost (uint8_t evt)
+{
+	ringBufPut(&btnEvtRing, &evt);
+}
 
 /* button reading task */
 void buttonTask (void)
 {
 	static bool pressed = false;
+	static uint8_t heldCnt = 0;
 	/* By using pressed variable, only changes in button state can be detected */
 	if(pressed == false)
 	{
 		if(buttonGet())
 		{
 			pressed = true;
-			btnPressCnt++;
-			if(ledUpdateInterval > 500)
-			{
-				ledUpdateInterval = 60;
-			}	
-			else
-			{
-				ledUpdateInterval = 600;
-			}
+			heldCnt = 0;
+			btnPost(BTN_EVT_PRESS);
 		}
 	}
 	else
@@ -80,67 +134,191 @@ void buttonTask (void)
 		if(!buttonGet())
 		{
 			pressed = false;
+			/* Short press is reported on release */
+			if(heldCnt < BTN_LONG_PRESS)
+			{
+				btnPost(MENU_EVENT_NEXT);
+			}
+		}
+		else if(heldCnt < BTN_LONG_PRESS)
+		{
+			/* Long press is reported while button is still held */
+			heldCnt++;
+			if(heldCnt == BTN_LONG_PRESS)
+			{
+				btnPost(MENU_EVENT_SELECT);
+			}
 		}
 	}
 
 }
 
+/* State of led switching task, given to it as callback context */
+typedef struct
+{
+	ringBuf_t *periods;
+	uint8_t state;
+}ledBlink_t;
+
+static ledBlink_t ledBlink = {&ledPeriodRing, 0};
+
 /* led switching task */
-void ledTask (void)
+void ledTask (void *ctx)
 {
-	static uint16_t currentUpdateIterval = 1000;
-	static uint8_t ledState = 0;
-	switch (ledState)
+	ledBlink_t *blink = ctx;
+	uint16_t period;
+	switch (blink->state)
 	{
 		case 0:
 			ledClearR();
 			ledSetG();
-			ledState = 1;
+			blink->state = 1;
 			break;
 		case 1:
 			ledClearG();
 			ledSetB();
-			ledState = 2;
+			blink->state = 2;
 			break;
 		case 2:
 			ledClearB();
 			ledSetR();
-			ledState = 0;
+			blink->state = 0;
 			break;
 	}
-	if(ledUpdateInterval != currentUpdateIterval)
+	while(ringBufGet(blink->periods, &period))
+	{
+		/* New period counts from this expiry */
+		stimerSetTime(LED_TMR, period, 1);
+	}
+}
+
+/* Menu item values and actions */
+static const char *ledSpeedValue (void)
+{
+	return (ledUpdateInterval > 500) ? "slow" : "fast";
+}
+
+static void ledSpeedToggle (void)
+{
+	if(ledUpdateInterval > 500)
+	{
+		ledUpdateInterval = 60;
+	}	
+	else
 	{
-		currentUpdateIterval = ledUpdateInterval;
-		stimerSetTime(LED_TMR, currentUpdateIterval, 1);
+		ledUpdateInterval = 600;
 	}
+	ringBufPut(&ledPeriodRing, &ledUpdateInterval);
+}
+
+static const char *pressCntValue (void)
+{
+	static char str[6];
+	numFieldFormat(str, 5, 0, (int32_t)btnPressCnt);
+	return str;
 }
 
-/* Update display with new button preses ncount */
+static void pressCntReset (void)
+{
+	btnPressCnt = 0;
+	eventPost(EVT_PRIO_DISPLAY, pressCntHandler, 0, 0);
+}
+
+/* Menu pages, constant, so they are stored in flash */
+static const menuItem_t aboutItems[] =
+{
+	{"MOSI M1 Lite", NULL, NULL, NULL},
+	{"by Siworks", NULL, NULL, NULL},
+	{"Back", NULL, NULL, NULL}
+};
+
+static const menuPage_t aboutPage = {"About", aboutItems, 3};
+
+#define MAIN_ITEM_PRESSES	1
+
+static const menuItem_t mainItems[] =
+{
+	{"LED speed", ledSpeedValue, NULL, ledSpeedToggle},
+	{"Presses", pressCntValue, NULL, NULL},
+	{"Reset count", NULL, NULL, pressCntReset},
+	{"About", NULL, &aboutPage, NULL}
+};
+
+const menuPage_t mainPage = {"MOSI M1 DEMO", mainItems, 4};
+
+/* Update menu item with new button preses count. Only its row is sent to display */
 void pressCntUpdate (void)
 {
-	char str[25];
-	/* Delete old string */
-	UG_FillFrame(5, 50, 120, 60, 0);
-	sprintf(str, "Button pressed: %3u", btnPressCnt);
-	UG_FontSelect(&FONT_5X12);
-	/*Write new string */
-	UG_PutString(5, 50, str);
+	menuRefreshItem(&mainMenu, &mainPage, MAIN_ITEM_PRESSES);
 }
 
 
 
-/* Main loop */
-int main (void)
+/* Logo has been shown, application starts */
+static void splashDone (void *ctx, uint32_t arg)
 {
+	(void)ctx;
+	(void)arg;
+	displayClear();
 	
-	static uint16_t curretnBtnPressCnt = 0;
+	/* Setup all other software timers. Their tasks do not need exact timing, so
+	   they run from PendSV and do not delay I2C tick. */
+	stimerSetTime(LED_TMR, ledUpdateInterval, 1);
+	stimerRegisterCallbackCtx(LED_TMR, ledTask, &ledBlink);
+	stimerSetLevel(LED_TMR, STIMER_LEVEL_DEFERRED);
+	stimerStart(LED_TMR);
 	
+	stimerSetTime(BTN_TMR, 10, 1);
+	stimerRegisterCallback(BTN_TMR, buttonTask);
+	stimerSetLevel(BTN_TMR, STIMER_LEVEL_DEFERRED);
+	stimerStart(BTN_TMR);
+	
+	/* Menu covers whole OLED */
+	menuInit(&mainMenu, &mainPage, &FONT_5X12, 0, 0, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1);
+	menuDraw(&mainMenu);
+}
+
+/* CLK_TMR expired, logo is replaced from main loop */
+static void splashTimeout (void *ctx)
+{
+	eventPost(EVT_PRIO_DISPLAY, splashDone, ctx, 0);
+}
+
+/* I2C_TMR only runs while an I2C job is on the bus */
+static void i2cTickControl (uint8_t run)
+{
+	if(run)
+	{
+		stimerSetTime(I2C_TMR, 1, 1);
+		stimerStart(I2C_TMR);
+	}
+	else
+	{
+		stimerStop(I2C_TMR);
+	}
+}
+
+/* Main loop */
+int main (void)
+{
 	/* Initialize the system */
 	system_init();
+	eventInit();
+	ringBufInit(&btnEvtRing, btnEvtBuf, sizeof(btnEvtBuf[0]), sizeof(btnEvtBuf) / sizeof(btnEvtBuf[0]));
+	ringBufInit(&ledPeriodRing, ledPeriodBuf, sizeof(ledPeriodBuf[0]), sizeof(ledPeriodBuf) / sizeof(ledPeriodBuf[0]));
 	ledInit();
+	stimerInit();
+#if I2C_INT_STATS && STIMER_US
+	/* I2C statistics are timed by microsecond clock instead of SysTick */
+	i2cIntStatsSetClock(stimerNowUs, 1);
+#endif
+	
+	/* I2C_TMR times I2C transfers, it must be set up before display is used */
+	stimerRegisterCallback(I2C_TMR, i2cIntTick);
+	i2cIntSetTickControl(i2cTickControl);
+	
 	displayInit();
 	buttonInit(BTN_POLLING);
-	stimerInit();
 	
 	/*Logo display */
 	ledSetR();
@@ -148,47 +326,14 @@ int main (void)
 	displayDrawImage(128, 64, sw_logo);
 	displayUpdate();
 	
-	/* CLK_TMR is used to stop program execution for 2 s */
+	/* Logo is shown for 2 s, CPU sleeps meanwhile */
 	stimerSetTime(CLK_TMR, 2000, 0);
+	stimerRegisterCallbackCtx(CLK_TMR, splashTimeout, 0);
 	stimerStart(CLK_TMR);
-	while(stimerGetTime(CLK_TMR))
-	{
-		
-	}
-	
-	displayClear();
-	
-	/* Setup all other software timers */
-	stimerSetTime(LED_TMR, ledUpdateInterval, 1);
-	stimerRegisterCallback(LED_TMR, ledTask);
-	stimerStart(LED_TMR);
-	
-	stimerSetTime(BTN_TMR, 10, 1);
-	stimerRegisterCallback(BTN_TMR, buttonTask);
-	stimerStart(BTN_TMR);
-	
-	/* Write stuff on OLED */
-	UG_FontSelect(&FONT_10X16);
-	UG_FillScreen(0);
-	UG_PutString(5, 10, "MOSI M1");
-	UG_PutString(65, 28, "DEMO");
-	pressCntUpdate();
-	displayUpdate();
-	UG_FontSelect(&FONT_5X12);
-	
-	while(1)
-	{
-		/* If button has been pressed since last loop execution
-		   update display with new count */
-		if(curretnBtnPressCnt != btnPressCnt)
-		{
-			curretnBtnPressCnt = btnPressCnt;
-			pressCntUpdate();
-			displayUpdate();
-		}
-	}
-	
 	
+	/* Main loop handles events and sleeps between them */
+	eventWatch(&btnEvtRing, btnEvtHandler, &mainMenu);
+	eventSetPoll(stimerDispatch);
+	eventSetPending(stimerDispatchPending);
+	eventRun();
 }
-
-
@@ -0,0 +1,501 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		bench.c
+* @brief	Scenarios of I2C driver and display, run on simulated buses.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Each scenario is measured in bytes on the wire and in simulated time. Byte counts
+* must match exactly, a change means the driver sends more or less than before.
+* Time must stay below its limit, limits are measured values with a small margin.
+* Program returns 1 if any check fails, so it can be used as a regression test.
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "sim_ssd1306.h"
+#include "sim_regfile.h"
+#include "I2C_Int.h"
+#include "I2C_RegCache.h"
+#include "I2C_Script.h"
+#include "display.h"
+#include "system_interrupt.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define BENCH_SENSOR_ADR		0x48
+#define BENCH_HEADER_ADR		0x50
+#define BENCH_SENSOR_REGS		32
+/** @brief Register of sensor, that counts its reads */
+#define BENCH_SENSOR_COUNTER	0x0F
+#define BENCH_RX_LEN			32
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Measurement of one scenario */
+typedef struct
+{
+	simBusStats_t bus;			/**< Counters of the bus at start */
+	uint64_t time;				/**< Simulated time at start */
+	Sercom *hw;					/**< Measured bus */
+}benchMark_t;
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+static simSsd1306_t benchDisplay;
+static simRegfile_t benchSensor;
+static simRegfile_t benchHeaderSensor;
+static i2cIntBus_t benchHeaderBus;
+static i2cRegCache_t benchCache;
+static uint8_t benchCacheValues[16];
+static uint8_t benchCacheFlags[16];
+static i2cRegCache_t benchHeaderCache;
+static uint8_t benchHeaderCacheValues[4];
+static uint8_t benchHeaderCacheFlags[4];
+static const uint8_t benchHeaderScript[] =
+{
+	I2C_SCRIPT_WRITE(12, 0xC1, 0xC2),
+	I2C_SCRIPT_END
+};
+/* DMA buffers must be static */
+static uint8_t benchRx[BENCH_RX_LEN];
+static uint8_t benchTx[8];
+static i2cIntJob_t benchJob;
+static i2cIntPacket_t benchPacket;
+static uint64_t benchJobDone;
+static uint8_t benchFailed;
+/** @brief Driver wants i2cIntTick to run */
+static uint8_t benchTickRun;
+
+
+/**
+* @brief     Reports result of a check
+* @param     name Description of the check
+* @param     ok Result
+*
+*/
+static void bench_expect (const char *name, uint8_t ok)
+{
+	if(!ok)
+	{
+		printf("FAIL  %s\n", name);
+		benchFailed = 1;
+	}
+}
+
+/**
+* @brief     Starts measurement of a scenario
+* @param     mark Measurement
+* @param     hw SERCOM of measured bus
+*
+*/
+static void bench_start (benchMark_t *mark, Sercom *hw)
+{
+	mark->hw = hw;
+	simBusStatsGet(hw, &mark->bus);
+	mark->time = simNow();
+}
+
+/**
+* @brief     Ends measurement of a scenario and checks it
+* @param     mark Measurement
+* @param     name Name of scenario
+* @param     bytes Expected number of bytes on the wire
+* @param     maxUs Time limit in us
+*
+*/
+static void bench_end (benchMark_t *mark, const char *name, uint32_t bytes, uint32_t maxUs)
+{
+	simBusStats_t now;
+	uint32_t us = (uint32_t)((simNow() - mark->time) / 1000);
+	uint32_t cnt;
+
+	simBusStatsGet(mark->hw, &now);
+	cnt = simBusBytes(&now) - simBusBytes(&mark->bus);
+	printf("%-4s  %-28s %6lu bytes (%6lu)  %7lu us (<= %7lu)\n",
+		   ((cnt == bytes) && (us <= maxUs)) ? "ok" : "FAIL", name,
+		   (unsigned long)cnt, (unsigned long)bytes, (unsigned long)us, (unsigned long)maxUs);
+	if((cnt != bytes) || (us > maxUs))
+	{
+		benchFailed = 1;
+	}
+}
+
+/**
+* @brief     Checks, that display RAM is the same as shown canvas
+* @return    1 if equal
+*
+*/
+static uint8_t bench_display_equal (void)
+{
+	return !memcmp(benchDisplay.ram, displayGetBuffer(), sizeof(benchDisplay.ram));
+}
+
+static void bench_put_str (const char *str)
+{
+	fputs(str, stdout);
+}
+
+static void bench_tick_control (uint8_t run)
+{
+	benchTickRun = run;
+}
+
+static void bench_job_done (i2cIntJob_t *job)
+{
+	(void)job;
+	benchJobDone = simNow();
+}
+
+/**
+* @brief     Display initialization and clear
+*
+*/
+static void bench_display_init (void)
+{
+	benchMark_t mark;
+
+	memset(benchDisplay.ram, 0xA5, sizeof(benchDisplay.ram));
+	bench_start(&mark, SERCOM2);
+	displayInit();
+	displayWait();
+	/* Script is sent in one transfer: address, control byte and 25 comand bytes */
+	bench_end(&mark, "display init and clear", 27 + 8 * (1 + DISPLAY_PAGE_CMD_LEN + SSD1306_WIDTH), 11500);
+
+	bench_expect("display is on", benchDisplay.on && benchDisplay.chargePump);
+	bench_expect("display in horizontal mode", benchDisplay.memMode == 0);
+	bench_expect("display protocol", !benchDisplay.errors);
+	bench_expect("display is cleared", bench_display_equal());
+	bench_expect("display runs on Fm+", simBusClock(SERCOM2) > 900);
+}
+
+/**
+* @brief     Full and partial display updates
+*
+*/
+static void bench_display_update (void)
+{
+	uint8_t *buf = displayGetBuffer();
+	benchMark_t mark;
+	uint16_t n;
+
+	for(n = 0; n < SSD1306_BUFFERSIZE; n++)
+	{
+		buf[n] = (uint8_t)(n * 7 + 3);
+	}
+	bench_start(&mark, SERCOM2);
+	displayUpdate();
+	displayWait();
+	bench_end(&mark, "display full update", 8 * (1 + DISPLAY_PAGE_CMD_LEN + SSD1306_WIDTH), 11500);
+	bench_expect("display shows full update", bench_display_equal());
+
+	/* Rows 10 to 20 are in pages 1 and 2 */
+	for(n = 0; n < SSD1306_BUFFERSIZE; n++)
+	{
+		buf[n] ^= 0xFF;
+	}
+	bench_start(&mark, SERCOM2);
+	displayUpdateArea(10, 10, 29, 20);
+	displayWait();
+	bench_end(&mark, "display area update", 2 * (1 + DISPLAY_PAGE_CMD_LEN + 20), 800);
+	bench_expect("display area is updated", !memcmp(&benchDisplay.ram[1][10], &buf[SSD1306_WIDTH + 10], 20) &&
+											!memcmp(&benchDisplay.ram[2][10], &buf[2 * SSD1306_WIDTH + 10], 20));
+	bench_expect("display outside area is kept", benchDisplay.ram[1][9] != buf[SSD1306_WIDTH + 9]);
+	bench_expect("display protocol", !benchDisplay.errors);
+}
+
+/**
+* @brief     Register cache of a sensor, reads and write back
+*
+*/
+static void bench_regcache (void)
+{
+	benchMark_t mark;
+	uint8_t value, value2;
+
+	benchCacheFlags[BENCH_SENSOR_COUNTER] = I2C_REGCACHE_VOLATILE;
+	i2cRegCacheInit(&benchCache, NULL, BENCH_SENSOR_ADR, 1, 0, sizeof(benchCacheValues), benchCacheValues, benchCacheFlags,
+					I2C_REGCACHE_WRITE_BACK);
+	benchSensor.regs[2] = 0x5A;
+
+	bench_start(&mark, SERCOM2);
+	bench_expect("cache first read", (i2cRegCacheRead(&benchCache, 2, &value) == I2C_INT_OK) && (value == 0x5A));
+	bench_end(&mark, "cache miss read", 4, 150);
+
+	bench_start(&mark, SERCOM2);
+	bench_expect("cache second read", (i2cRegCacheRead(&benchCache, 2, &value) == I2C_INT_OK) && (value == 0x5A));
+	bench_end(&mark, "cache hit read", 0, 0);
+
+	bench_start(&mark, SERCOM2);
+	i2cRegCacheWrite(&benchCache, 4, 0x11);
+	i2cRegCacheWrite(&benchCache, 5, 0x22);
+	i2cRegCacheWrite(&benchCache, 6, 0x33);
+	i2cRegCacheWrite(&benchCache, 7, 0x44);
+	bench_expect("cache sync", i2cRegCacheSync(&benchCache) == I2C_INT_OK);
+	bench_end(&mark, "cache write back of 4", 6, 200);
+	bench_expect("cache written to sensor", (benchSensor.regs[4] == 0x11) && (benchSensor.regs[7] == 0x44));
+
+	i2cRegCacheSetBurst(&benchCache, 0);
+	bench_start(&mark, SERCOM2);
+	i2cRegCacheWrite(&benchCache, 8, 0x55);
+	i2cRegCacheWrite(&benchCache, 9, 0x66);
+	bench_expect("cache sync without burst", i2cRegCacheSync(&benchCache) == I2C_INT_OK);
+	bench_end(&mark, "cache write without burst", 6, 250);
+	bench_expect("cache written one by one", (benchSensor.regs[8] == 0x55) && (benchSensor.regs[9] == 0x66));
+	i2cRegCacheSetBurst(&benchCache, 1);
+
+	bench_start(&mark, SERCOM2);
+	i2cRegCacheRead(&benchCache, BENCH_SENSOR_COUNTER, &value);
+	i2cRegCacheRead(&benchCache, BENCH_SENSOR_COUNTER, &value2);
+	bench_end(&mark, "cache volatile reads", 8, 250);
+	bench_expect("volatile register read from sensor", value2 == (uint8_t)(value + 1));
+}
+
+/**
+* @brief     Blocking read, long enough for DMA
+*
+*/
+static void bench_rx (void)
+{
+	i2cIntPacket_t packet = {0};
+	benchMark_t mark;
+	uint8_t n;
+
+	for(n = 0; n < BENCH_RX_LEN; n++)
+	{
+		benchSensor.regs[n] = n ^ 0x3C;
+	}
+	benchSensor.flags[BENCH_SENSOR_COUNTER] = 0;
+	packet.deviceAddress = BENCH_SENSOR_ADR;
+	packet.regAddrLen = 1;
+	packet.rxBuff = benchRx;
+	packet.rxLen = BENCH_RX_LEN;
+
+	bench_start(&mark, SERCOM2);
+	bench_expect("DMA read", i2cIntRx(&packet) == I2C_INT_OK);
+	bench_end(&mark, "DMA read of 32", 3 + BENCH_RX_LEN, 900);
+	bench_expect("DMA read data", !memcmp(benchRx, benchSensor.regs, BENCH_RX_LEN));
+	benchSensor.flags[BENCH_SENSOR_COUNTER] = SIM_REGFILE_COUNTER;
+}
+
+/**
+* @brief     Second bus on SERCOM3 of the header
+*
+*/
+static void bench_header_bus (void)
+{
+	i2cIntPacket_t packet = {0};
+	benchMark_t mark, other;
+
+	bench_expect("header bus init", i2cIntBusInit(&benchHeaderBus, &i2cIntHeaderConfig, 100) == I2C_INT_OK);
+	benchTx[0] = 1;
+	benchTx[1] = 2;
+	benchTx[2] = 3;
+	benchTx[3] = 4;
+	packet.deviceAddress = BENCH_HEADER_ADR;
+	packet.regAddrLen = 1;
+	packet.regAddress = 8;
+	packet.txBuff = benchTx;
+	packet.txLen = 4;
+
+	bench_start(&other, SERCOM2);
+	bench_start(&mark, SERCOM3);
+	bench_expect("header bus write", i2cIntBusTx(&benchHeaderBus, &packet) == I2C_INT_OK);
+	bench_end(&mark, "header bus write of 4", 6, 650);
+	bench_end(&other, "on board bus unused", 0, 650);
+	bench_expect("header bus data", !memcmp(&benchHeaderSensor.regs[8], benchTx, 4));
+	bench_expect("header bus at 100 kHz", (simBusClock(SERCOM3) > 90) && (simBusClock(SERCOM3) <= 100));
+
+	bench_start(&other, SERCOM2);
+	bench_start(&mark, SERCOM3);
+	bench_expect("header bus script", i2cScriptRun(&benchHeaderBus, BENCH_HEADER_ADR, benchHeaderScript, NULL) == I2C_INT_OK);
+	bench_end(&mark, "header bus script of 2", 4, 500);
+	bench_end(&other, "on board unused by script", 0, 500);
+	bench_expect("header bus script data", (benchHeaderSensor.regs[12] == 0xC1) && (benchHeaderSensor.regs[13] == 0xC2));
+
+	i2cRegCacheInit(&benchHeaderCache, &benchHeaderBus, BENCH_HEADER_ADR, 1, 12, sizeof(benchHeaderCacheValues),
+					benchHeaderCacheValues, benchHeaderCacheFlags, I2C_REGCACHE_WRITE_THROUGH);
+	bench_start(&other, SERCOM2);
+	bench_start(&mark, SERCOM3);
+	bench_expect("header bus cache write", i2cRegCacheWrite(&benchHeaderCache, 14, 0xC3) == I2C_INT_OK);
+	bench_expect("header bus cache read", (i2cRegCacheRead(&benchHeaderCache, 13, &benchTx[0]) == I2C_INT_OK) &&
+				 (benchTx[0] == 0xC2));
+	bench_end(&mark, "header bus cache", 7, 1000);
+	bench_end(&other, "on board unused by cache", 0, 1000);
+	bench_expect("header bus cache data", benchHeaderSensor.regs[14] == 0xC3);
+}
+
+/**
+* @brief     Injected faults, driver must report them and recover
+*
+*/
+static void bench_faults (void)
+{
+	i2cIntPacket_t packet = {0};
+	simBusStats_t bus;
+	i2cIntStats_t stats;
+	benchMark_t mark;
+	simFault_t fault = {0};
+	uint32_t recoveries;
+
+	packet.deviceAddress = BENCH_SENSOR_ADR;
+	packet.regAddrLen = 1;
+	packet.regAddress = 0x10;
+	packet.txBuff = benchTx;
+	packet.txLen = 4;
+	fault.address = BENCH_SENSOR_ADR;
+	fault.count = 1;
+
+	fault.type = SIM_FAULT_ADDR_NACK;
+	simFaultAdd(SERCOM2, &fault);
+	bench_start(&mark, SERCOM2);
+	bench_expect("address NACK is retried", i2cIntTx(&packet) == I2C_INT_OK);
+	bench_end(&mark, "write after address NACK", 1 + 6, 250);
+
+	fault.count = 100;
+	simFaultAdd(SERCOM2, &fault);
+	bench_expect("address NACK is reported", i2cIntTx(&packet) == I2C_INT_NACK);
+	simFaultClear(SERCOM2);
+
+	fault.type = SIM_FAULT_DATA_NACK;
+	fault.count = 1;
+	fault.byte = 2;
+	simFaultAdd(SERCOM2, &fault);
+	bench_expect("data NACK is reported", i2cIntTx(&packet) == I2C_INT_NACK);
+	bench_expect("bus works after data NACK", i2cIntTx(&packet) == I2C_INT_OK);
+
+	/* Automatic length of DMA write stops at NACK, job ends from ERROR interrupt */
+	simFaultClear(SERCOM2);
+	packet.regAddress = 0;
+	packet.txBuff = benchRx;
+	packet.txLen = 20;
+	fault.byte = 5;
+	simFaultAdd(SERCOM2, &fault);
+	simBusStatsGet(SERCOM2, &bus);
+	recoveries = bus.recoveries;
+	bench_start(&mark, SERCOM2);
+	bench_expect("data NACK in DMA write is reported", i2cIntTx(&packet) == I2C_INT_NACK);
+	bench_end(&mark, "DMA write until data NACK", 1 + 6, 200);
+	simBusStatsGet(SERCOM2, &bus);
+	bench_expect("DMA write NACK without recovery", bus.recoveries == recoveries);
+	bench_expect("DMA write works after NACK", i2cIntTx(&packet) == I2C_INT_OK);
+	simFaultClear(SERCOM2);
+	packet.regAddress = 0x10;
+	packet.txBuff = benchTx;
+	packet.txLen = 4;
+	fault.byte = 2;
+
+	simBusStatsGet(SERCOM2, &bus);
+	recoveries = bus.recoveries;
+	fault.type = SIM_FAULT_STALL;
+	simFaultAdd(SERCOM2, &fault);
+	bench_expect("stall ends with timeout", i2cIntTx(&packet) == I2C_INT_TIMEOUT);
+	simBusStatsGet(SERCOM2, &bus);
+	bench_expect("stalled bus is recovered", bus.recoveries == (recoveries + 1));
+	bench_expect("bus works after stall", i2cIntTx(&packet) == I2C_INT_OK);
+
+	fault.type = SIM_FAULT_ARB_LOST;
+	simFaultAdd(SERCOM2, &fault);
+	bench_expect("lost arbitration is reported", i2cIntTx(&packet) == I2C_INT_BUS_ERR);
+	bench_expect("bus works after lost arbitration", i2cIntTx(&packet) == I2C_INT_OK);
+
+	/* Page 3 of display stalls in its DMA part, other pages are sent */
+	fault.type = SIM_FAULT_STALL;
+	fault.address = DISPLAY_ADR;
+	fault.skip = 3;
+	fault.byte = DISPLAY_PAGE_CMD_LEN + 40;
+	simFaultAdd(SERCOM2, &fault);
+	memset(benchDisplay.ram, 0, sizeof(benchDisplay.ram));
+	displayUpdate();
+	displayWait();
+	bench_expect("display stall ends with timeout", (i2cIntStatsGet(DISPLAY_ADR, &stats) == I2C_INT_OK) && (stats.timeouts == 1));
+	bench_expect("display pages after stall are sent", !memcmp(benchDisplay.ram[7], &displayGetBuffer()[7 * SSD1306_WIDTH], SSD1306_WIDTH));
+	displayUpdate();
+	displayWait();
+	bench_expect("display works after stall", bench_display_equal());
+}
+
+/**
+* @brief     Sensor read queued together with full display update
+*
+* Display has low priority, so the read waits only for the page on the bus.
+*
+*/
+static void bench_priority (void)
+{
+	benchMark_t mark;
+	uint64_t submit;
+
+	benchPacket.deviceAddress = BENCH_SENSOR_ADR;
+	benchPacket.regAddrLen = 1;
+	benchPacket.regAddress = 0;
+	benchPacket.rxBuff = benchRx;
+	benchPacket.rxLen = 2;
+
+	bench_start(&mark, SERCOM2);
+	system_interrupt_enter_critical_section();
+	displayUpdate();
+	submit = simNow();
+	i2cIntSubmitRx(&benchJob, &benchPacket, bench_job_done);
+	system_interrupt_leave_critical_section();
+	displayWait();
+	i2cIntJobWait(&benchJob);
+	bench_end(&mark, "display update and read", 8 * (1 + DISPLAY_PAGE_CMD_LEN + SSD1306_WIDTH) + 5, 11700);
+	printf("      sensor read latency %lu us\n", (unsigned long)((benchJobDone - submit) / 1000));
+	bench_expect("sensor read overtakes display", (benchJobDone - submit) < 3000000);
+}
+
+
+int main (void)
+{
+	simInit();
+	simSsd1306Init(&benchDisplay, DISPLAY_ADR);
+	simRegfileInit(&benchSensor, BENCH_SENSOR_ADR, BENCH_SENSOR_REGS);
+	benchSensor.flags[BENCH_SENSOR_COUNTER] = SIM_REGFILE_COUNTER;
+	simRegfileInit(&benchHeaderSensor, BENCH_HEADER_ADR, 16);
+	simDeviceAdd(SERCOM2, &benchDisplay.dev);
+	simDeviceAdd(SERCOM2, &benchSensor.dev);
+	simDeviceAdd(SERCOM3, &benchHeaderSensor.dev);
+	i2cIntStatsSetClock(simClock, 1000);
+	simSetTick(i2cIntTick);
+	i2cIntSetTickControl(bench_tick_control);
+
+	bench_display_init();
+	bench_display_update();
+	bench_regcache();
+	bench_rx();
+	bench_header_bus();
+	bench_faults();
+	bench_priority();
+	bench_expect("tick is stopped while buses are idle", !benchTickRun);
+
+	printf("\n");
+	i2cIntStatsDump(bench_put_str);
+	printf("\n%s\n", benchFailed ? "FAILED" : "PASSED");
+	return benchFailed;
+}
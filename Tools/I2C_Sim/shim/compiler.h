@@ -0,0 +1,44 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		compiler.h
+* @brief	Host replacement of ASF compiler abstraction for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef UTILS_COMPILER_H_INCLUDED
+#define UTILS_COMPILER_H_INCLUDED
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <assert.h>
+#include "samd21g18a.h"
+#include "status_codes.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define COMPILER_ALIGNED(a)		__attribute__((__aligned__(a)))
+#define COMPILER_WORD_ALIGNED	__attribute__((__aligned__(4)))
+#define Assert(expr)			assert(expr)
+#define UNUSED(v)				(void)(v)
+
+#endif /* UTILS_COMPILER_H_INCLUDED */
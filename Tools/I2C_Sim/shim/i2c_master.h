@@ -0,0 +1,144 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		i2c_master.h
+* @brief	Host replacement of ASF I2C master driver for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Types keep the names and fields of ASF 3.47, that are used by I2C driver.
+* Functions are implemented by simulator in sim.c.
+*/
+
+#ifndef I2C_MASTER_H_INCLUDED
+#define I2C_MASTER_H_INCLUDED
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "sercom.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define I2C_MASTER_CALLBACK_MODE	true
+#define FEATURE_I2C_FAST_MODE_PLUS_AND_HIGH_SPEED
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+enum i2c_transfer_direction
+{
+	I2C_TRANSFER_WRITE = 0,
+	I2C_TRANSFER_READ = 1
+};
+
+enum i2c_master_start_hold_time
+{
+	I2C_MASTER_START_HOLD_TIME_DISABLED = SERCOM_I2CM_CTRLA_SDAHOLD(0),
+	I2C_MASTER_START_HOLD_TIME_50NS_100NS = SERCOM_I2CM_CTRLA_SDAHOLD(1),
+	I2C_MASTER_START_HOLD_TIME_300NS_600NS = SERCOM_I2CM_CTRLA_SDAHOLD(2),
+	I2C_MASTER_START_HOLD_TIME_400NS_800NS = SERCOM_I2CM_CTRLA_SDAHOLD(3)
+};
+
+enum i2c_master_inactive_timeout
+{
+	I2C_MASTER_INACTIVE_TIMEOUT_DISABLED = SERCOM_I2CM_CTRLA_INACTOUT(0),
+	I2C_MASTER_INACTIVE_TIMEOUT_55US = SERCOM_I2CM_CTRLA_INACTOUT(1),
+	I2C_MASTER_INACTIVE_TIMEOUT_105US = SERCOM_I2CM_CTRLA_INACTOUT(2),
+	I2C_MASTER_INACTIVE_TIMEOUT_205US = SERCOM_I2CM_CTRLA_INACTOUT(3)
+};
+
+enum i2c_master_transfer_speed
+{
+	I2C_MASTER_SPEED_STANDARD_AND_FAST = SERCOM_I2CM_CTRLA_SPEED(0),
+	I2C_MASTER_SPEED_FAST_MODE_PLUS = SERCOM_I2CM_CTRLA_SPEED(1),
+	I2C_MASTER_SPEED_HIGH_SPEED = SERCOM_I2CM_CTRLA_SPEED(2)
+};
+
+enum i2c_master_callback
+{
+	I2C_MASTER_CALLBACK_WRITE_COMPLETE = 0,
+	I2C_MASTER_CALLBACK_READ_COMPLETE = 1,
+	I2C_MASTER_CALLBACK_ERROR = 2,
+	_I2C_MASTER_CALLBACK_N = 3
+};
+
+struct i2c_master_module;
+
+typedef void (*i2c_master_callback_t)(struct i2c_master_module *const module);
+
+struct i2c_master_module
+{
+	Sercom *hw;
+	volatile bool locked;
+	uint16_t unknown_bus_state_timeout;
+	uint16_t buffer_timeout;
+	bool send_stop;
+	bool send_nack;
+	volatile i2c_master_callback_t callbacks[_I2C_MASTER_CALLBACK_N];
+	volatile uint8_t registered_callback;
+	volatile uint8_t enabled_callback;
+	volatile uint16_t buffer_length;
+	volatile uint16_t buffer_remaining;
+	volatile uint8_t *buffer;
+	volatile enum i2c_transfer_direction transfer_direction;
+	volatile enum status_code status;
+};
+
+struct i2c_master_packet
+{
+	uint16_t address;
+	uint16_t data_length;
+	uint8_t *data;
+	bool ten_bit_address;
+	bool high_speed;
+	uint8_t hs_master_code;
+};
+
+struct i2c_master_config
+{
+	uint32_t baud_rate;
+	uint32_t baud_rate_high_speed;
+	enum i2c_master_transfer_speed transfer_speed;
+	uint8_t generator_source;
+	enum i2c_master_start_hold_time start_hold_time;
+	uint16_t unknown_bus_state_timeout;
+	uint16_t buffer_timeout;
+	bool run_in_standby;
+	uint32_t pinmux_pad0;
+	uint32_t pinmux_pad1;
+	bool scl_low_timeout;
+	enum i2c_master_inactive_timeout inactive_timeout;
+	uint16_t sda_scl_rise_time_ns;
+};
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void i2c_master_get_config_defaults (struct i2c_master_config *const config);
+enum status_code i2c_master_init (struct i2c_master_module *const module, Sercom *const hw,
+								  const struct i2c_master_config *const config);
+void i2c_master_enable (const struct i2c_master_module *const module);
+void i2c_master_disable (const struct i2c_master_module *const module);
+void i2c_master_send_stop (struct i2c_master_module *const module);
+void i2c_master_dma_set_transfer (struct i2c_master_module *const module, uint16_t addr, uint8_t length,
+								  enum i2c_transfer_direction direction);
+
+#endif /* I2C_MASTER_H_INCLUDED */
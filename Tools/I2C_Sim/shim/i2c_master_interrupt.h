@@ -0,0 +1,48 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		i2c_master_interrupt.h
+* @brief	Host replacement of ASF I2C master job API for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef I2C_MASTER_INTERRUPT_H_INCLUDED
+#define I2C_MASTER_INTERRUPT_H_INCLUDED
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "i2c_master.h"
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void i2c_master_register_callback (struct i2c_master_module *const module, i2c_master_callback_t callback,
+								   enum i2c_master_callback callback_type);
+void i2c_master_enable_callback (struct i2c_master_module *const module, enum i2c_master_callback callback_type);
+void i2c_master_disable_callback (struct i2c_master_module *const module, enum i2c_master_callback callback_type);
+enum status_code i2c_master_write_packet_job (struct i2c_master_module *const module,
+											  struct i2c_master_packet *const packet);
+enum status_code i2c_master_write_packet_job_no_stop (struct i2c_master_module *const module,
+													  struct i2c_master_packet *const packet);
+enum status_code i2c_master_read_packet_job (struct i2c_master_module *const module,
+											 struct i2c_master_packet *const packet);
+enum status_code i2c_master_write_bytes (struct i2c_master_module *const module,
+										 struct i2c_master_packet *const packet);
+void i2c_master_cancel_job (struct i2c_master_module *const module);
+
+#endif /* I2C_MASTER_INTERRUPT_H_INCLUDED */
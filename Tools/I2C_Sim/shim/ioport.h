@@ -0,0 +1,25 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		ioport.h
+* @brief	Host replacement of ASF IOPORT service for I2C simulator, not used.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef IOPORT_H
+#define IOPORT_H
+
+#endif /* IOPORT_H */
@@ -0,0 +1,153 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		samd21g18a.h
+* @brief	Host replacement of device header for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Register layouts and bit definitions are taken from the real component and
+* instance headers of ASF. Peripherals used by I2C driver are placed in host
+* memory, DMAC is reached through simDmac, which keeps per channel registers.
+*/
+
+#ifndef _SAMD21G18A_
+#define _SAMD21G18A_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define __SAMD21G18A__
+#define __I		volatile const
+#define __O		volatile
+#define __IO	volatile
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+typedef volatile const uint32_t RoReg;
+typedef volatile const uint16_t RoReg16;
+typedef volatile const uint8_t  RoReg8;
+typedef volatile       uint32_t WoReg;
+typedef volatile       uint16_t WoReg16;
+typedef volatile       uint8_t  WoReg8;
+typedef volatile       uint32_t RwReg;
+typedef volatile       uint16_t RwReg16;
+typedef volatile       uint8_t  RwReg8;
+
+/** @brief Interrupt numbers, same as on SAMD21G18A */
+typedef enum IRQn
+{
+	PendSV_IRQn			= -2,
+	SysTick_IRQn		= -1,
+	PM_IRQn				=  0,
+	SYSCTRL_IRQn		=  1,
+	WDT_IRQn			=  2,
+	RTC_IRQn			=  3,
+	EIC_IRQn			=  4,
+	NVMCTRL_IRQn		=  5,
+	DMAC_IRQn			=  6,
+	USB_IRQn			=  7,
+	EVSYS_IRQn			=  8,
+	SERCOM0_IRQn		=  9,
+	SERCOM1_IRQn		= 10,
+	SERCOM2_IRQn		= 11,
+	SERCOM3_IRQn		= 12,
+	SERCOM4_IRQn		= 13,
+	SERCOM5_IRQn		= 14,
+	TCC0_IRQn			= 15,
+	TCC1_IRQn			= 16,
+	TCC2_IRQn			= 17,
+	TC3_IRQn			= 18,
+	TC4_IRQn			= 19,
+	TC5_IRQn			= 20,
+	PERIPH_COUNT_IRQn	= 28
+}IRQn_Type;
+
+/** @brief SysTick registers */
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t LOAD;
+	volatile uint32_t VAL;
+	volatile uint32_t CALIB;
+}SysTick_Type;
+
+#define SysTick_CTRL_ENABLE_Msk		(1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk	(1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk	(1UL << 2)
+#define SysTick_LOAD_RELOAD_Msk		(0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Msk		(0xFFFFFFUL)
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "component/dmac.h"
+#include "component/pm.h"
+#include "component/port.h"
+#include "component/sercom.h"
+#include "instance/sercom0.h"
+#include "instance/sercom1.h"
+#include "instance/sercom2.h"
+#include "instance/sercom3.h"
+#include "instance/sercom4.h"
+#include "instance/sercom5.h"
+#include "pio/samd21g18a.h"
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+extern Sercom simSercom[6];
+extern Port simPort;
+extern Pm simPm;
+extern SysTick_Type simSysTick;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+Dmac *simDmac (void);
+void NVIC_EnableIRQ (IRQn_Type irq);
+void NVIC_DisableIRQ (IRQn_Type irq);
+void NVIC_SetPendingIRQ (IRQn_Type irq);
+void NVIC_ClearPendingIRQ (IRQn_Type irq);
+void NVIC_SetPriority (IRQn_Type irq, uint32_t priority);
+
+
+/****************************************************************************************
+* Peripherals
+****************************************************************************************/
+#define SERCOM0		(&simSercom[0])
+#define SERCOM1		(&simSercom[1])
+#define SERCOM2		(&simSercom[2])
+#define SERCOM3		(&simSercom[3])
+#define SERCOM4		(&simSercom[4])
+#define SERCOM5		(&simSercom[5])
+#define PORT		(&simPort)
+#define PM			(&simPm)
+#define SysTick		(&simSysTick)
+#define DMAC		(simDmac())
+
+#endif /* _SAMD21G18A_ */
@@ -0,0 +1,37 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sercom.h
+* @brief	Host replacement of ASF SERCOM driver for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef SERCOM_H_INCLUDED
+#define SERCOM_H_INCLUDED
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "compiler.h"
+#include "system.h"
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint8_t _sercom_get_sercom_inst_index (Sercom *const sercom_instance);
+
+#endif /* SERCOM_H_INCLUDED */
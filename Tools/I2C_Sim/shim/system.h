@@ -0,0 +1,38 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		system.h
+* @brief	Host replacement of ASF system driver for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef SYSTEM_H_INCLUDED
+#define SYSTEM_H_INCLUDED
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "compiler.h"
+#include "system_interrupt.h"
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+uint32_t system_gclk_chan_get_hz (const uint8_t channel);
+uint32_t system_cpu_clock_get_hz (void);
+
+#endif /* SYSTEM_H_INCLUDED */
@@ -0,0 +1,35 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		system_interrupt.h
+* @brief	Host replacement of ASF interrupt driver for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Simulated hardware runs only when interrupts are enabled again, so pending
+* interrupts are served when the outermost critical section is left.
+*/
+
+#ifndef SYSTEM_INTERRUPT_H_INCLUDED
+#define SYSTEM_INTERRUPT_H_INCLUDED
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void system_interrupt_enter_critical_section (void);
+void system_interrupt_leave_critical_section (void);
+
+#endif /* SYSTEM_INTERRUPT_H_INCLUDED */
@@ -0,0 +1,1180 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim.c
+* @brief	Host simulator of SERCOM I2C master, DMAC and devices on the bus.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "i2c_master_interrupt.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define SIM_OP_NONE			0
+#define SIM_OP_JOB			1
+#define SIM_OP_DMA_TX		2
+#define SIM_OP_DMA_RX		3
+#define SIM_BUSSTATE_IDLE	1
+#define SIM_BUSSTATE_OWNER	2
+/** @brief Number of DMA channels */
+#define SIM_DMA_CH_NBR		12
+/** @brief Number of SERCOM modules */
+#define SIM_SERCOM_NBR		6
+/** @brief Length of ms tick in ns */
+#define SIM_TICK_NS			1000000ULL
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief State of one simulated bus */
+typedef struct
+{
+	struct i2c_master_module *module;		/**< ASF module using the SERCOM */
+	simDevice_t *devices;					/**< Connected devices */
+	simDevice_t *dev;						/**< Addressed device, NULL if none */
+	simFault_t faults[SIM_FAULT_NBR];		/**< Waiting faults */
+	simFault_t *fault;						/**< Fault of current transfer, or NULL */
+	simBusStats_t stats;					/**< Counters */
+	uint64_t start;							/**< Time when operation was started */
+	uint64_t end;							/**< Time when operation finishes */
+	enum status_code result;				/**< Result of operation */
+	uint16_t byteIdx;						/**< Data bytes since address */
+	uint8_t faultCnt;						/**< Number of used entries in faults */
+	uint8_t owner;							/**< Bus is held by master */
+	uint8_t nack;							/**< Last data byte has not been acknowledged */
+	uint8_t op;								/**< Operation in progress */
+	uint8_t stalled;						/**< Operation does not finish, until module is disabled */
+	uint8_t dmaCh;							/**< DMA channel of DMA operation */
+	uint8_t intflag;						/**< SERCOM interrupt flags */
+	uint8_t inten;							/**< Enabled SERCOM interrupts */
+	uint8_t dmaBuf[SIM_DMA_MAX];			/**< Data of DMA transmit */
+}simBus_t;
+
+/** @brief Registers of one DMA channel */
+typedef struct
+{
+	uint8_t ctrla;				/**< CHCTRLA */
+	uint32_t ctrlb;				/**< CHCTRLB */
+	uint8_t inten;				/**< Enabled interrupts */
+	uint8_t flags;				/**< Interrupt flags */
+	uint8_t started;			/**< Transfer has been started on a bus */
+}simDmaCh_t;
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+Sercom simSercom[SIM_SERCOM_NBR];
+Port simPort;
+Pm simPm;
+SysTick_Type simSysTick;
+
+static simBus_t simBuses[SIM_SERCOM_NBR];
+/** @brief DMAC registers seen by the driver, channel registers belong to CHID */
+static Dmac simDmacView;
+static simDmaCh_t simDmaCh[SIM_DMA_CH_NBR];
+/** @brief Channel, which registers are in simDmacView */
+static uint8_t simDmacViewCh;
+static uint64_t simTime;
+static uint64_t simNextTick = SIM_TICK_NS;
+static void (*simTick)(void);
+static uint32_t simIsrNs = SIM_ISR_NS;
+static uint8_t simCritical;
+static uint8_t simRunning;
+
+/* Linker symbols around program code and data */
+extern char __executable_start;
+extern char end;
+
+void DMAC_Handler (void);
+
+
+/**
+* @brief     Converts DMA address to pointer
+*
+* Stops simulation, if address can not be in program data, because it has been
+* truncated from a 64 bit pointer.
+*
+* @param     addr Address from DMA descriptor
+* @return    Pointer
+*
+*/
+static uint8_t *sim_dma_ptr (uint32_t addr)
+{
+	if((addr < (uintptr_t)&__executable_start) || (addr > (uintptr_t)&end))
+	{
+		fprintf(stderr, "sim: DMA address 0x%08lX is not in static data\n", (unsigned long)addr);
+		exit(2);
+	}
+	return (uint8_t *)(uintptr_t)addr;
+}
+
+/**
+* @brief     Returns bus of a SERCOM
+* @param     hw SERCOM module
+* @return    Bus
+*
+*/
+static simBus_t *sim_bus (Sercom *hw)
+{
+	return &simBuses[hw - simSercom];
+}
+
+/**
+* @brief     Returns time of one SCL period in ns
+*
+* Same formula as in SERCOM, BAUDLOW is not used.
+*
+* @param     bus Bus
+* @return    SCL period in ns
+*
+*/
+static uint32_t sim_bit_ns (simBus_t *bus)
+{
+	uint32_t baud = bus->module->hw->I2CM.BAUD.reg & SERCOM_I2CM_BAUD_BAUD_Msk;
+	double period = (10.0 + 2.0 * baud) / SIM_GCLK_HZ + SIM_RISE_NS * 1e-9;
+
+	return (uint32_t)(period * 1e9 + 0.5);
+}
+
+/**
+* @brief     Sets bus state in STATUS register
+* @param     bus Bus
+* @param     state Bus state
+*
+*/
+static void sim_busstate (simBus_t *bus, uint8_t state)
+{
+	SercomI2cm *const i2cm = &bus->module->hw->I2CM;
+
+	i2cm->STATUS.reg = (i2cm->STATUS.reg & ~SERCOM_I2CM_STATUS_BUSSTATE_Msk) | SERCOM_I2CM_STATUS_BUSSTATE(state);
+}
+
+/**
+* @brief     Finds device with an address
+* @param     bus Bus
+* @param     address Slave address
+* @return    Device or NULL
+*
+*/
+static simDevice_t *sim_device (simBus_t *bus, uint8_t address)
+{
+	simDevice_t *dev;
+
+	for(dev = bus->devices; dev; dev = dev->next)
+	{
+		if(dev->address == address)
+		{
+			return dev;
+		}
+	}
+	return NULL;
+}
+
+/**
+* @brief     Takes fault, that affects transfer to an address
+*
+* Faults are counted per address phase, so a read with register address counts
+* twice.
+*
+* @param     bus Bus
+* @param     address Slave address
+* @return    Fault or NULL
+*
+*/
+static simFault_t *sim_fault_take (simBus_t *bus, uint8_t address)
+{
+	simFault_t *f;
+	uint8_t n;
+
+	for(n = 0; n < bus->faultCnt; n++)
+	{
+		f = &bus->faults[n];
+		if((f->address != address) || !f->count)
+		{
+			continue;
+		}
+		if(f->skip)
+		{
+			f->skip--;
+			continue;
+		}
+		f->count--;
+		return f;
+	}
+	return NULL;
+}
+
+/**
+* @brief     Generates stop condition
+* @param     bus Bus
+*
+*/
+static void sim_stop (simBus_t *bus)
+{
+	SercomI2cm *const i2cm = &bus->module->hw->I2CM;
+
+	if(bus->owner)
+	{
+		bus->stats.stops++;
+		if(bus->dev && bus->dev->stop)
+		{
+			bus->dev->stop(bus->dev);
+		}
+	}
+	bus->owner = 0;
+	bus->dev = NULL;
+	bus->nack = 0;
+	bus->byteIdx = 0;
+	bus->intflag = 0;
+	i2cm->STATUS.reg &= ~(SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_BUSERR);
+	sim_busstate(bus, SIM_BUSSTATE_IDLE);
+}
+
+/**
+* @brief     Carries out a transfer on device models and computes when it finishes
+*
+* Devices see bytes immediately, master sees the result at bus->end.
+*
+* @param     bus Bus
+* @param     address Slave address, or -1 to continue transfer of bus owner
+* @param     read 1 for read, 0 for write
+* @param     data Data to write or buffer for read
+* @param     len Number of data bytes
+* @param     dma 1 if bytes are moved by DMA
+*
+*/
+static void sim_transfer (simBus_t *bus, int16_t address, uint8_t read, uint8_t *data, uint16_t len, uint8_t dma)
+{
+	const uint32_t bit = sim_bit_ns(bus);
+	simFault_t *f;
+	uint64_t t = simTime;
+	uint8_t ack;
+	uint16_t n;
+
+	bus->result = STATUS_OK;
+	bus->stalled = 0;
+	bus->start = simTime;
+	if(!dma)
+	{
+		/* Software starts the transfer from interrupt */
+		t += simIsrNs;
+	}
+
+	if(address >= 0)
+	{
+		if(bus->owner && bus->dev && bus->dev->stop)
+		{
+			/* Repeated start ends previous transfer on the device */
+			bus->dev->stop(bus->dev);
+		}
+		bus->owner = 1;
+		bus->nack = 0;
+		bus->byteIdx = 0;
+		/* Writing ADDR clears length error */
+		bus->module->hw->I2CM.STATUS.reg &= ~SERCOM_I2CM_STATUS_LENERR;
+		sim_busstate(bus, SIM_BUSSTATE_OWNER);
+		bus->stats.starts++;
+		bus->stats.addrBytes++;
+		t += 10 * bit;
+
+		bus->dev = sim_device(bus, (uint8_t)address);
+		bus->fault = sim_fault_take(bus, (uint8_t)address);
+		if(bus->fault && (bus->fault->type == SIM_FAULT_ADDR_NACK))
+		{
+			bus->stats.faults++;
+			ack = 0;
+		}
+		else
+		{
+			ack = bus->dev && bus->dev->start(bus->dev, read);
+		}
+		if(!ack)
+		{
+			bus->stats.nacks++;
+			bus->dev = NULL;
+			bus->fault = NULL;
+			bus->result = STATUS_ERR_BAD_ADDRESS;
+			bus->end = t;
+			return;
+		}
+	}
+
+	if(!bus->owner || !bus->dev)
+	{
+		bus->result = STATUS_ERR_PACKET_COLLISION;
+		bus->end = t;
+		return;
+	}
+	if(bus->nack && !dma && len)
+	{
+		/* ASF checks acknowledge of previous byte before writing next one */
+		bus->result = STATUS_ERR_OVERFLOW;
+		bus->end = t;
+		return;
+	}
+
+	f = bus->fault;
+	for(n = 0; n < len; n++)
+	{
+		if(f && (f->byte == bus->byteIdx) && (f->type == SIM_FAULT_STALL))
+		{
+			/* Slave holds SCL, transfer never finishes */
+			bus->stats.faults++;
+			bus->fault = NULL;
+			bus->stalled = 1;
+			return;
+		}
+		if(f && (f->byte == bus->byteIdx) && (f->type == SIM_FAULT_ARB_LOST))
+		{
+			bus->stats.faults++;
+			bus->fault = NULL;
+			if(bus->dev->stop)
+			{
+				bus->dev->stop(bus->dev);
+			}
+			bus->owner = 0;
+			bus->dev = NULL;
+			sim_busstate(bus, SIM_BUSSTATE_IDLE);
+			bus->result = STATUS_ERR_PACKET_COLLISION;
+			bus->end = t + 9 * bit;
+			return;
+		}
+
+		t += 9 * bit + (dma ? 0 : simIsrNs);
+		bus->stats.dataBytes++;
+		if(dma)
+		{
+			bus->stats.dmaBytes++;
+		}
+
+		if(read)
+		{
+			data[n] = bus->dev->read(bus->dev);
+		}
+		else
+		{
+			ack = bus->dev->write(bus->dev, data[n]);
+			if(f && (f->byte == bus->byteIdx) && (f->type == SIM_FAULT_DATA_NACK))
+			{
+				bus->stats.faults++;
+				ack = 0;
+			}
+			bus->nack = !ack;
+			if(!ack)
+			{
+				bus->stats.nacks++;
+				/* Automatic length of DMA write stops after NACK as well */
+				if(n < (len - 1))
+				{
+					bus->byteIdx++;
+					bus->result = STATUS_ERR_OVERFLOW;
+					bus->end = t;
+					return;
+				}
+			}
+		}
+		bus->byteIdx++;
+	}
+	bus->end = t;
+}
+
+/**
+* @brief     Finishes ASF job, as ASF interrupt handler does
+* @param     bus Bus
+*
+*/
+static void sim_job_done (simBus_t *bus)
+{
+	struct i2c_master_module *const module = bus->module;
+	const uint8_t mask = module->enabled_callback & module->registered_callback;
+
+	module->buffer_length = 0;
+	module->buffer_remaining = 0;
+	module->status = bus->result;
+
+	if(bus->result == STATUS_OK)
+	{
+		if(module->send_stop)
+		{
+			sim_stop(bus);
+		}
+		if(module->transfer_direction == I2C_TRANSFER_READ)
+		{
+			if(mask & (1 << I2C_MASTER_CALLBACK_READ_COMPLETE))
+			{
+				module->callbacks[I2C_MASTER_CALLBACK_READ_COMPLETE](module);
+			}
+		}
+		else if(mask & (1 << I2C_MASTER_CALLBACK_WRITE_COMPLETE))
+		{
+			module->callbacks[I2C_MASTER_CALLBACK_WRITE_COMPLETE](module);
+		}
+		return;
+	}
+
+	if((bus->result != STATUS_ERR_PACKET_COLLISION) && module->send_stop)
+	{
+		sim_stop(bus);
+	}
+	if(mask & (1 << I2C_MASTER_CALLBACK_ERROR))
+	{
+		module->callbacks[I2C_MASTER_CALLBACK_ERROR](module);
+	}
+}
+
+/**
+* @brief     Copies registers of channel in view back to channel
+*
+* Interrupt flags belong to simulator, writes to them are ignored.
+*
+*/
+static void sim_dmac_save (void)
+{
+	simDmaCh_t *ch = &simDmaCh[simDmacViewCh];
+	uint8_t n;
+
+	if(simDmacView.CTRL.reg & DMAC_CTRL_SWRST)
+	{
+		memset(simDmaCh, 0, sizeof(simDmaCh));
+		simDmacView.CTRL.reg = 0;
+		simDmacView.CHCTRLA.reg = 0;
+		simDmacView.CHCTRLB.reg = 0;
+		simDmacView.CHINTENSET.reg = 0;
+		return;
+	}
+	if(simDmacView.CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+	{
+		memset(ch, 0, sizeof(*ch));
+		return;
+	}
+
+	ch->ctrla = simDmacView.CHCTRLA.reg;
+	ch->ctrlb = simDmacView.CHCTRLB.reg;
+	ch->inten = simDmacView.CHINTENSET.reg;
+	if(!(ch->ctrla & DMAC_CHCTRLA_ENABLE) && ch->started)
+	{
+		/* Disabled channel stops its transfer */
+		ch->started = 0;
+		for(n = 0; n < SIM_SERCOM_NBR; n++)
+		{
+			if(((simBuses[n].op == SIM_OP_DMA_TX) || (simBuses[n].op == SIM_OP_DMA_RX)) &&
+			   (simBuses[n].dmaCh == simDmacViewCh))
+			{
+				simBuses[n].op = SIM_OP_NONE;
+				simBuses[n].stalled = 0;
+			}
+		}
+	}
+}
+
+/**
+* @brief     Loads registers of channel selected by CHID into view
+*
+*/
+static void sim_dmac_load (void)
+{
+	simDmaCh_t *ch;
+
+	simDmacViewCh = simDmacView.CHID.reg % SIM_DMA_CH_NBR;
+	ch = &simDmaCh[simDmacViewCh];
+	simDmacView.CHCTRLA.reg = ch->ctrla;
+	simDmacView.CHCTRLB.reg = ch->ctrlb;
+	simDmacView.CHINTENSET.reg = ch->inten;
+	simDmacView.CHINTFLAG.reg = ch->flags;
+}
+
+/**
+* @brief     Returns descriptor of a DMA channel
+* @param     ch Channel
+* @return    First descriptor
+*
+*/
+static DmacDescriptor *sim_dma_desc (uint8_t ch)
+{
+	return (DmacDescriptor *)sim_dma_ptr(simDmacView.BASEADDR.reg + ch * sizeof(DmacDescriptor));
+}
+
+/**
+* @brief     Applies writes of the driver to SERCOM interrupt registers
+*
+* Flags and enables belong to simulator, registers hold only what the driver has
+* written since last call. Writing INTFLAG clears flags, INTENCLR and INTENSET
+* disable and enable interrupts, as on SERCOM.
+*
+* @param     bus Bus
+*
+*/
+static void sim_sercom_regs (simBus_t *bus)
+{
+	SercomI2cm *const i2cm = &bus->module->hw->I2CM;
+
+	bus->intflag &= ~i2cm->INTFLAG.reg;
+	bus->inten = (bus->inten & ~i2cm->INTENCLR.reg) | i2cm->INTENSET.reg;
+	i2cm->INTFLAG.reg = 0;
+	i2cm->INTENCLR.reg = 0;
+	i2cm->INTENSET.reg = 0;
+}
+
+/**
+* @brief     Calls SERCOM interrupt, as ASF handler does at the end of a write
+*
+* Only the case used by DMA transmit is modeled: all bytes have been given to
+* SERCOM and MB interrupt is enabled, or slave has not acknowledged a byte and
+* ERROR interrupt is enabled.
+*
+* @param     bus Bus
+*
+*/
+static void sim_sercom_irq (simBus_t *bus)
+{
+	struct i2c_master_module *const module = bus->module;
+	const uint8_t mask = module->enabled_callback & module->registered_callback;
+
+	sim_sercom_regs(bus);
+	if(!(bus->inten & bus->intflag & (SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_ERROR)))
+	{
+		return;
+	}
+	if((module->buffer_length > 0) && !module->buffer_remaining && (module->status == STATUS_BUSY) &&
+	   (module->transfer_direction == I2C_TRANSFER_WRITE) && !module->send_stop)
+	{
+		bus->inten &= ~(SERCOM_I2CM_INTENCLR_MB | SERCOM_I2CM_INTENCLR_SB);
+		bus->intflag &= ~SERCOM_I2CM_INTFLAG_MB;
+		module->buffer_length = 0;
+		module->status = STATUS_OK;
+		if(mask & (1 << I2C_MASTER_CALLBACK_WRITE_COMPLETE))
+		{
+			module->callbacks[I2C_MASTER_CALLBACK_WRITE_COMPLETE](module);
+		}
+	}
+}
+
+/**
+* @brief     Finishes DMA transfer and calls DMA interrupt
+* @param     bus Bus
+* @param     op SIM_OP_DMA_TX or SIM_OP_DMA_RX
+*
+*/
+static void sim_dma_done (simBus_t *bus, uint8_t op)
+{
+	SercomI2cm *const i2cm = &bus->module->hw->I2CM;
+	simDmaCh_t *ch = &simDmaCh[bus->dmaCh];
+
+	const uint8_t nack = bus->nack;
+
+	/* Automatic length sends stop after last byte, and NACK before it in receive */
+	sim_stop(bus);
+	if((op == SIM_OP_DMA_TX) && ((bus->result == STATUS_ERR_BAD_ADDRESS) || (bus->result == STATUS_ERR_OVERFLOW)))
+	{
+		/* NACK before last byte, SERCOM sends stop and reports length error, DMA does
+		   not finish, until it is disabled */
+		i2cm->STATUS.reg |= SERCOM_I2CM_STATUS_RXNACK | SERCOM_I2CM_STATUS_LENERR;
+		bus->intflag |= SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_ERROR;
+		sim_sercom_irq(bus);
+		sim_dmac_save();
+		if((bus->op == SIM_OP_NONE) && ch->started)
+		{
+			/* Driver has not taken the interrupt, transfer stays until module is disabled */
+			bus->op = op;
+			bus->stalled = 1;
+		}
+		return;
+	}
+	if(op == SIM_OP_DMA_TX)
+	{
+		bus->intflag |= SERCOM_I2CM_INTFLAG_MB;
+		if(nack)
+		{
+			i2cm->STATUS.reg |= SERCOM_I2CM_STATUS_RXNACK;
+		}
+	}
+	if(bus->result == STATUS_ERR_PACKET_COLLISION)
+	{
+		bus->intflag |= SERCOM_I2CM_INTFLAG_ERROR;
+		i2cm->STATUS.reg |= SERCOM_I2CM_STATUS_ARBLOST;
+	}
+
+	ch->ctrla &= ~DMAC_CHCTRLA_ENABLE;
+	ch->started = 0;
+	ch->flags = DMAC_CHINTFLAG_TCMPL;
+	sim_dmac_load();
+	DMAC_Handler();
+	sim_dmac_save();
+	ch->flags = 0;
+	sim_dmac_load();
+	sim_sercom_irq(bus);
+}
+
+/**
+* @brief     Finishes operation of a bus
+* @param     bus Bus
+*
+*/
+static void sim_complete (simBus_t *bus)
+{
+	uint8_t op = bus->op;
+
+	bus->op = SIM_OP_NONE;
+	bus->stats.busyNs += simTime - bus->start;
+	if(op == SIM_OP_JOB)
+	{
+		sim_job_done(bus);
+	}
+	else
+	{
+		sim_dma_done(bus, op);
+	}
+}
+
+/**
+* @brief     Starts ASF job
+* @param     module ASF module
+* @param     packet ASF packet
+* @param     read 1 for read, 0 for write
+* @param     stop Stop is sent at the end
+* @param     start 1 for start and address, 0 to continue write
+* @return    STATUS_OK or STATUS_BUSY
+*
+*/
+static enum status_code sim_job (struct i2c_master_module *const module, struct i2c_master_packet *const packet,
+								 uint8_t read, uint8_t stop, uint8_t start)
+{
+	simBus_t *bus = sim_bus(module->hw);
+
+	if(bus->op != SIM_OP_NONE)
+	{
+		return STATUS_BUSY;
+	}
+	module->buffer = packet->data;
+	module->buffer_length = start ? 0 : packet->data_length;
+	module->buffer_remaining = packet->data_length;
+	module->transfer_direction = read ? I2C_TRANSFER_READ : I2C_TRANSFER_WRITE;
+	module->status = STATUS_BUSY;
+	module->send_stop = stop;
+	module->send_nack = read;
+
+	bus->op = SIM_OP_JOB;
+	sim_transfer(bus, start ? (int16_t)packet->address : -1, read, packet->data, packet->data_length, 0);
+	return STATUS_OK;
+}
+
+
+/**
+* @brief     Initializes simulator
+*
+* Pins read high, so recovery of the bus sees released SDA.
+*
+*/
+void simInit (void)
+{
+	memset(simSercom, 0, sizeof(simSercom));
+	memset(simBuses, 0, sizeof(simBuses));
+	memset(simDmaCh, 0, sizeof(simDmaCh));
+	memset(&simDmacView, 0, sizeof(simDmacView));
+	memset(&simPort, 0, sizeof(simPort));
+	*(uint32_t *)&simPort.Group[0].IN.reg = 0xFFFFFFFF;
+	*(uint32_t *)&simPort.Group[1].IN.reg = 0xFFFFFFFF;
+	simTime = 0;
+	simNextTick = SIM_TICK_NS;
+	simCritical = 0;
+}
+
+/**
+* @brief     Sets function called every ms of simulated time, normally i2cIntTick
+* @param     tick Tick function, or NULL
+*
+*/
+void simSetTick (void (*tick)(void))
+{
+	simTick = tick;
+	simNextTick = (simTime / SIM_TICK_NS + 1) * SIM_TICK_NS;
+}
+
+/**
+* @brief     Sets CPU time of interrupt handling one byte or start
+* @param     ns Time in ns
+*
+*/
+void simSetIsrTime (uint32_t ns)
+{
+	simIsrNs = ns;
+}
+
+/**
+* @brief     Runs simulated hardware, until all buses are idle
+*
+* Called when critical section is left. Operations finish in order of time, ticks
+* are given at every ms boundary on the way.
+*
+*/
+void simRun (void)
+{
+	simBus_t *next;
+	uint64_t stallStart = 0;
+	uint8_t stalled;
+	uint8_t n;
+
+	if(simRunning)
+	{
+		return;
+	}
+	simRunning = 1;
+	sim_dmac_save();
+
+	while(1)
+	{
+		next = NULL;
+		stalled = 0;
+		for(n = 0; n < SIM_SERCOM_NBR; n++)
+		{
+			if(simBuses[n].op == SIM_OP_NONE)
+			{
+				continue;
+			}
+			if(simBuses[n].stalled)
+			{
+				stalled = 1;
+			}
+			else if(!next || (simBuses[n].end < next->end))
+			{
+				next = &simBuses[n];
+			}
+		}
+		if(!next && !stalled)
+		{
+			break;
+		}
+
+		if(!stalled)
+		{
+			stallStart = 0;
+		}
+		else if(!stallStart)
+		{
+			stallStart = simTime + 1;
+		}
+		if(!simTick && !next)
+		{
+			fprintf(stderr, "sim: bus is stalled and there is no tick to recover it\n");
+			exit(2);
+		}
+		if(stallStart && ((simTime + 1 - stallStart) > SIM_STALL_MAX_NS))
+		{
+			fprintf(stderr, "sim: bus is stalled and driver does not recover it\n");
+			exit(2);
+		}
+
+		if(simTick && (!next || (simNextTick <= next->end)))
+		{
+			simTime = simNextTick;
+			simNextTick += SIM_TICK_NS;
+			simTick();
+		}
+		else
+		{
+			simTime = next->end;
+			sim_complete(next);
+		}
+		sim_dmac_save();
+	}
+	simRunning = 0;
+}
+
+/**
+* @brief     Returns simulated time
+* @return    Time in ns
+*
+*/
+uint64_t simNow (void)
+{
+	return simTime;
+}
+
+/**
+* @brief     Simulated time as clock for I2C driver statistics
+* @return    Time in ns, 1000 ticks per us
+*
+*/
+uint32_t simClock (void)
+{
+	return (uint32_t)simTime;
+}
+
+/**
+* @brief     Connects device to bus of a SERCOM
+* @param     hw SERCOM module
+* @param     dev Device
+*
+*/
+void simDeviceAdd (Sercom *hw, simDevice_t *dev)
+{
+	simBus_t *bus = sim_bus(hw);
+
+	dev->next = bus->devices;
+	bus->devices = dev;
+}
+
+/**
+* @brief     Adds fault to bus of a SERCOM
+* @param     hw SERCOM module
+* @param     fault Fault
+*
+*/
+void simFaultAdd (Sercom *hw, const simFault_t *fault)
+{
+	simBus_t *bus = sim_bus(hw);
+
+	if(bus->faultCnt < SIM_FAULT_NBR)
+	{
+		bus->faults[bus->faultCnt++] = *fault;
+	}
+}
+
+/**
+* @brief     Removes all faults from bus of a SERCOM
+* @param     hw SERCOM module
+*
+*/
+void simFaultClear (Sercom *hw)
+{
+	sim_bus(hw)->faultCnt = 0;
+}
+
+/**
+* @brief     Copies counters of bus of a SERCOM
+* @param     hw SERCOM module
+* @param     stats Returns counters
+*
+*/
+void simBusStatsGet (Sercom *hw, simBusStats_t *stats)
+{
+	*stats = sim_bus(hw)->stats;
+}
+
+/**
+* @brief     Returns number of bytes on the wire
+* @param     stats Counters
+* @return    Address and data bytes
+*
+*/
+uint32_t simBusBytes (const simBusStats_t *stats)
+{
+	return stats->addrBytes + stats->dataBytes;
+}
+
+/**
+* @brief     Returns SCL frequency of bus of a SERCOM
+* @param     hw SERCOM module
+* @return    Frequency in kHz
+*
+*/
+uint32_t simBusClock (Sercom *hw)
+{
+	return 1000000 / sim_bit_ns(sim_bus(hw));
+}
+
+
+/****************************************************************************************
+* Replacements of ASF, CMSIS and device functions
+****************************************************************************************/
+
+/**
+* @brief     DMAC registers, channel registers are those of channel in CHID
+* @return    DMAC registers
+*
+*/
+Dmac *simDmac (void)
+{
+	sim_dmac_save();
+	sim_dmac_load();
+	return &simDmacView;
+}
+
+void NVIC_EnableIRQ (IRQn_Type irq)
+{
+	(void)irq;
+}
+
+void NVIC_DisableIRQ (IRQn_Type irq)
+{
+	(void)irq;
+}
+
+/* Operations are started by ASF functions, pending interrupt adds nothing */
+void NVIC_SetPendingIRQ (IRQn_Type irq)
+{
+	(void)irq;
+}
+
+void NVIC_ClearPendingIRQ (IRQn_Type irq)
+{
+	(void)irq;
+}
+
+void NVIC_SetPriority (IRQn_Type irq, uint32_t priority)
+{
+	(void)irq;
+	(void)priority;
+}
+
+void system_interrupt_enter_critical_section (void)
+{
+	simCritical++;
+}
+
+void system_interrupt_leave_critical_section (void)
+{
+	if(simCritical && !--simCritical)
+	{
+		simRun();
+	}
+}
+
+uint32_t system_gclk_chan_get_hz (const uint8_t channel)
+{
+	(void)channel;
+	return SIM_GCLK_HZ;
+}
+
+uint32_t system_cpu_clock_get_hz (void)
+{
+	return SIM_GCLK_HZ;
+}
+
+uint8_t _sercom_get_sercom_inst_index (Sercom *const sercom_instance)
+{
+	return (uint8_t)(sercom_instance - simSercom);
+}
+
+void i2c_master_get_config_defaults (struct i2c_master_config *const config)
+{
+	memset(config, 0, sizeof(*config));
+	config->baud_rate = 100;
+	config->baud_rate_high_speed = 3400;
+	config->transfer_speed = I2C_MASTER_SPEED_STANDARD_AND_FAST;
+	config->start_hold_time = I2C_MASTER_START_HOLD_TIME_300NS_600NS;
+	config->buffer_timeout = 65535;
+	config->unknown_bus_state_timeout = 65535;
+	config->pinmux_pad0 = 0xFFFFFFFF;
+	config->pinmux_pad1 = 0xFFFFFFFF;
+	config->inactive_timeout = I2C_MASTER_INACTIVE_TIMEOUT_DISABLED;
+	config->sda_scl_rise_time_ns = 215;
+}
+
+/* Baud rate is computed as in ASF */
+enum status_code i2c_master_init (struct i2c_master_module *const module, Sercom *const hw,
+								  const struct i2c_master_config *const config)
+{
+	SercomI2cm *const i2cm = &hw->I2CM;
+	const uint32_t fgclk = system_gclk_chan_get_hz(0);
+	const uint32_t fscl = 1000 * config->baud_rate;
+	int32_t baud;
+
+	if(i2cm->CTRLA.reg & SERCOM_I2CM_CTRLA_SWRST)
+	{
+		return STATUS_BUSY;
+	}
+	if(i2cm->CTRLA.reg & SERCOM_I2CM_CTRLA_ENABLE)
+	{
+		return STATUS_ERR_DENIED;
+	}
+	memset(module, 0, sizeof(*module));
+	module->hw = hw;
+	module->buffer_timeout = config->buffer_timeout;
+	module->unknown_bus_state_timeout = config->unknown_bus_state_timeout;
+	module->status = STATUS_OK;
+	sim_bus(hw)->module = module;
+
+	baud = (int32_t)((fgclk - fscl * (10 + (fgclk * 0.000000001) * config->sda_scl_rise_time_ns) + 2 * fscl - 1) / (2 * fscl));
+	if((baud > 255) || (baud < 0))
+	{
+		return STATUS_ERR_BAUDRATE_UNAVAILABLE;
+	}
+	i2cm->CTRLA.reg = SERCOM_I2CM_CTRLA_MODE(5) | config->start_hold_time | config->transfer_speed |
+					  (config->scl_low_timeout ? SERCOM_I2CM_CTRLA_LOWTOUTEN : 0) | config->inactive_timeout;
+	i2cm->CTRLB.reg = SERCOM_I2CM_CTRLB_SMEN;
+	i2cm->BAUD.reg = SERCOM_I2CM_BAUD_BAUD(baud);
+	return STATUS_OK;
+}
+
+void i2c_master_enable (const struct i2c_master_module *const module)
+{
+	simBus_t *bus = sim_bus(module->hw);
+
+	module->hw->I2CM.CTRLA.reg |= SERCOM_I2CM_CTRLA_ENABLE;
+	sim_stop(bus);
+}
+
+/* Disabling module in the middle of a transfer leaves device as it is, until stop */
+void i2c_master_disable (const struct i2c_master_module *const module)
+{
+	simBus_t *bus = sim_bus(module->hw);
+
+	module->hw->I2CM.CTRLA.reg &= ~SERCOM_I2CM_CTRLA_ENABLE;
+	/* ASF clears all interrupt enables */
+	sim_sercom_regs(bus);
+	bus->inten = 0;
+	if(bus->op != SIM_OP_NONE)
+	{
+		bus->stats.busyNs += simTime - bus->start;
+		bus->op = SIM_OP_NONE;
+	}
+	bus->stalled = 0;
+	if(bus->owner)
+	{
+		/* Recovery of the driver releases the slave and sends stop */
+		bus->stats.recoveries++;
+		sim_stop(bus);
+	}
+	sim_busstate(bus, 0);
+}
+
+void i2c_master_register_callback (struct i2c_master_module *const module, i2c_master_callback_t callback,
+								   enum i2c_master_callback callback_type)
+{
+	module->callbacks[callback_type] = callback;
+	module->registered_callback |= (1 << callback_type);
+}
+
+void i2c_master_enable_callback (struct i2c_master_module *const module, enum i2c_master_callback callback_type)
+{
+	module->enabled_callback |= (1 << callback_type);
+}
+
+void i2c_master_disable_callback (struct i2c_master_module *const module, enum i2c_master_callback callback_type)
+{
+	module->enabled_callback &= ~(1 << callback_type);
+}
+
+enum status_code i2c_master_write_packet_job (struct i2c_master_module *const module,
+											  struct i2c_master_packet *const packet)
+{
+	return sim_job(module, packet, 0, 1, 1);
+}
+
+enum status_code i2c_master_write_packet_job_no_stop (struct i2c_master_module *const module,
+													  struct i2c_master_packet *const packet)
+{
+	return sim_job(module, packet, 0, 0, 1);
+}
+
+enum status_code i2c_master_read_packet_job (struct i2c_master_module *const module,
+											 struct i2c_master_packet *const packet)
+{
+	return sim_job(module, packet, 1, 1, 1);
+}
+
+enum status_code i2c_master_write_bytes (struct i2c_master_module *const module,
+										 struct i2c_master_packet *const packet)
+{
+	return sim_job(module, packet, 0, 0, 0);
+}
+
+void i2c_master_cancel_job (struct i2c_master_module *const module)
+{
+	simBus_t *bus = sim_bus(module->hw);
+
+	if(bus->op == SIM_OP_JOB)
+	{
+		bus->stats.busyNs += simTime - bus->start;
+		bus->op = SIM_OP_NONE;
+		bus->stalled = 0;
+	}
+	module->buffer_remaining = 0;
+	module->status = STATUS_ABORTED;
+}
+
+void i2c_master_send_stop (struct i2c_master_module *const module)
+{
+	sim_stop(sim_bus(module->hw));
+}
+
+/* Transfer with automatic length, DMA channel with SERCOM trigger must be enabled */
+void i2c_master_dma_set_transfer (struct i2c_master_module *const module, uint16_t addr, uint8_t length,
+								  enum i2c_transfer_direction direction)
+{
+	simBus_t *bus = sim_bus(module->hw);
+	const uint8_t read = (direction == I2C_TRANSFER_READ);
+	const uint8_t trig = (read ? SERCOM0_DMAC_ID_RX : SERCOM0_DMAC_ID_TX) + 2 * _sercom_get_sercom_inst_index(module->hw);
+	DmacDescriptor *desc;
+	uint16_t len, cnt;
+	uint8_t n;
+
+	/* Driver clears flags and enables interrupts of the transfer before it starts */
+	sim_sercom_regs(bus);
+	sim_dmac_save();
+	for(n = 0; n < SIM_DMA_CH_NBR; n++)
+	{
+		if((simDmaCh[n].ctrla & DMAC_CHCTRLA_ENABLE) && !simDmaCh[n].started &&
+		   (((simDmaCh[n].ctrlb & DMAC_CHCTRLB_TRIGSRC_Msk) >> DMAC_CHCTRLB_TRIGSRC_Pos) == trig))
+		{
+			break;
+		}
+	}
+	if((n == SIM_DMA_CH_NBR) || (bus->op != SIM_OP_NONE))
+	{
+		fprintf(stderr, "sim: DMA transfer without enabled channel or on busy bus\n");
+		exit(2);
+	}
+	simDmaCh[n].started = 1;
+	bus->dmaCh = n;
+
+	if(read)
+	{
+		desc = sim_dma_desc(n);
+		bus->op = SIM_OP_DMA_RX;
+		sim_transfer(bus, (int16_t)addr, 1, sim_dma_ptr(desc->DSTADDR.reg - desc->BTCNT.reg), length, 1);
+		if(bus->result != STATUS_OK)
+		{
+			/* SERCOM stops after NACK, DMA never finishes */
+			bus->stalled = 1;
+		}
+		return;
+	}
+
+	/* Descriptor chain is collected into one write */
+	len = 0;
+	for(desc = sim_dma_desc(n); desc; desc = desc->DESCADDR.reg ? (DmacDescriptor *)sim_dma_ptr(desc->DESCADDR.reg) : NULL)
+	{
+		cnt = desc->BTCNT.reg;
+		if((len + cnt) > SIM_DMA_MAX)
+		{
+			fprintf(stderr, "sim: DMA transfer longer than %d bytes\n", SIM_DMA_MAX);
+			exit(2);
+		}
+		memcpy(&bus->dmaBuf[len], sim_dma_ptr(desc->SRCADDR.reg - cnt), cnt);
+		len += cnt;
+	}
+	if(len != length)
+	{
+		fprintf(stderr, "sim: automatic length %u differs from DMA length %u\n", length, len);
+		exit(2);
+	}
+	bus->op = SIM_OP_DMA_TX;
+	sim_transfer(bus, (int16_t)addr, 0, bus->dmaBuf, len, 1);
+}
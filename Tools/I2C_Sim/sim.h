@@ -0,0 +1,142 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim.h
+* @brief	Host simulator of SERCOM I2C master, DMAC and devices on the bus.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* I2C driver is built for the host against shim headers, which replace ASF and the
+* device header. ASF job functions start a transaction on a simulated bus, which
+* is carried out on device models and finishes after the time it would take on the
+* wire. Completion is delivered as on the target, by calling ASF callbacks or
+* DMAC_Handler. SERCOM interrupt flags and enables are kept by the simulator, writes
+* of the driver to INTFLAG, INTENSET and INTENCLR act as on SERCOM.
+*
+* Simulated time advances only while some bus has work. Hardware runs when the
+* outermost critical section is left, so every job submitted by the driver is
+* finished, when submit returns. Jobs submitted inside one critical section are
+* queued together and show priority and waiting in queue.
+*
+* Bus time of a byte is 9 SCL periods, computed from BAUD and SPEED registers, the
+* same way as SERCOM does. Every byte moved by interrupts and every start of a
+* transfer from software adds SIM_ISR_NS, DMA bytes do not.
+*
+* Devices are connected with simDeviceAdd. A device model implements start, write,
+* read and stop of simDevice_t. Faults are injected with simFaultAdd: device does
+* not acknowledge address or data, stretches the clock forever, or master loses
+* arbitration.
+*
+* Buffers used by DMA must be static, because DMAC registers hold 32 bit addresses.
+* Simulator is linked without PIE and stops with a message, if address is outside
+* of program data.
+*/
+
+#ifndef SIM_H_
+#define SIM_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "samd21g18a.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Frequency of GCLK0 and CPU in Hz */
+#define SIM_GCLK_HZ			48000000UL
+/** @brief Rise time of SDA and SCL on simulated bus in ns */
+#define SIM_RISE_NS			215
+/** @brief Default CPU time in ns of interrupt handling one byte or start */
+#define SIM_ISR_NS			3000
+/** @brief Maximum number of faults waiting on one bus */
+#define SIM_FAULT_NBR		4
+/** @brief Maximum number of bytes in one DMA transfer */
+#define SIM_DMA_MAX			1024
+/** @brief Simulated time in ns, after which a stalled bus without tick is reported */
+#define SIM_STALL_MAX_NS	1000000000ULL
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+typedef struct simDevice_s simDevice_t;
+
+/** @brief Device on simulated bus, model embeds it as first member */
+struct simDevice_s
+{
+	uint8_t address;								/**< 7 bit slave address */
+	uint8_t (*start)(simDevice_t *dev, uint8_t read);	/**< Address matched, returns 1 for ACK */
+	uint8_t (*write)(simDevice_t *dev, uint8_t data);	/**< Byte from master, returns 1 for ACK */
+	uint8_t (*read)(simDevice_t *dev);				/**< Byte to master */
+	void (*stop)(simDevice_t *dev);					/**< Stop or repeated start */
+	simDevice_t *next;								/**< Next device on the bus */
+};
+
+/** @brief Kind of injected fault */
+typedef enum
+{
+	SIM_FAULT_ADDR_NACK,		/**< Device does not acknowledge its address */
+	SIM_FAULT_DATA_NACK,		/**< Device does not acknowledge data byte */
+	SIM_FAULT_STALL,			/**< Device holds SCL low until bus is recovered */
+	SIM_FAULT_ARB_LOST			/**< Master loses arbitration */
+}simFaultType_t;
+
+/** @brief Injected fault */
+typedef struct
+{
+	simFaultType_t type;		/**< Kind of fault */
+	uint8_t address;			/**< Slave address of affected transfers */
+	uint16_t skip;				/**< Number of transfers passing before the first affected one */
+	uint16_t count;				/**< Number of affected transfers */
+	uint16_t byte;				/**< Index of data byte, for data faults */
+}simFault_t;
+
+/** @brief Counters of one bus */
+typedef struct
+{
+	uint32_t starts;			/**< Start and repeated start conditions */
+	uint32_t stops;				/**< Stop conditions */
+	uint32_t addrBytes;			/**< Address bytes */
+	uint32_t dataBytes;			/**< Data bytes, both directions */
+	uint32_t dmaBytes;			/**< Data bytes moved by DMA */
+	uint32_t nacks;				/**< Bytes not acknowledged */
+	uint32_t faults;			/**< Injected faults, that happened */
+	uint32_t recoveries;		/**< Times module was disabled while bus was held */
+	uint64_t busyNs;			/**< Time with transfer in progress */
+}simBusStats_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void simInit (void);
+void simSetTick (void (*tick)(void));
+void simSetIsrTime (uint32_t ns);
+void simRun (void);
+uint64_t simNow (void);
+uint32_t simClock (void);
+void simDeviceAdd (Sercom *hw, simDevice_t *dev);
+void simFaultAdd (Sercom *hw, const simFault_t *fault);
+void simFaultClear (Sercom *hw);
+void simBusStatsGet (Sercom *hw, simBusStats_t *stats);
+uint32_t simBusBytes (const simBusStats_t *stats);
+uint32_t simBusClock (Sercom *hw);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,94 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim_regfile.c
+* @brief	Model of a register file sensor for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <string.h>
+#include "sim_regfile.h"
+
+
+static uint8_t sim_regfile_start (simDevice_t *dev, uint8_t read)
+{
+	simRegfile_t *rf = (simRegfile_t *)dev;
+	
+	rf->addrPhase = !read;
+	return 1;
+}
+
+static uint8_t sim_regfile_write (simDevice_t *dev, uint8_t data)
+{
+	simRegfile_t *rf = (simRegfile_t *)dev;
+	
+	if(rf->addrPhase)
+	{
+		rf->addrPhase = 0;
+		rf->ptr = data;
+		return data < rf->size;
+	}
+	if(rf->ptr >= rf->size)
+	{
+		return 0;
+	}
+	if(!(rf->flags[rf->ptr] & SIM_REGFILE_RO))
+	{
+		rf->regs[rf->ptr] = data;
+	}
+	rf->writes++;
+	rf->ptr++;
+	return 1;
+}
+
+static uint8_t sim_regfile_read (simDevice_t *dev)
+{
+	simRegfile_t *rf = (simRegfile_t *)dev;
+	uint8_t value;
+	
+	if(rf->ptr >= rf->size)
+	{
+		return 0xFF;
+	}
+	value = rf->regs[rf->ptr];
+	if(rf->flags[rf->ptr] & SIM_REGFILE_COUNTER)
+	{
+		rf->regs[rf->ptr]++;
+	}
+	rf->reads++;
+	rf->ptr++;
+	return value;
+}
+
+/**
+* @brief     Initializes register file model, all registers are 0 and writable
+* @param     rf Register file model
+* @param     address 7 bit slave address
+* @param     size Number of implemented registers, at most SIM_REGFILE_NBR
+*
+*/
+void simRegfileInit (simRegfile_t *rf, uint8_t address, uint16_t size)
+{
+	memset(rf, 0, sizeof(*rf));
+	rf->dev.address = address;
+	rf->dev.start = sim_regfile_start;
+	rf->dev.write = sim_regfile_write;
+	rf->dev.read = sim_regfile_read;
+	rf->size = (size > SIM_REGFILE_NBR) ? SIM_REGFILE_NBR : size;
+}
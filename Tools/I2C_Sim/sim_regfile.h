@@ -0,0 +1,74 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim_regfile.h
+* @brief	Model of a register file sensor for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Model behaves like most I2C sensors with 8 bit register address. First byte of
+* a write sets register pointer, following bytes are written to registers. Reads
+* return registers from the pointer on. Pointer increments after every byte.
+* Registers above size are not acknowledged and read as 0xFF. Read only registers
+* ignore writes, counter registers increment every time they are read, so cached
+* reads can be told from reads on the bus.
+*/
+
+#ifndef SIM_REGFILE_H_
+#define SIM_REGFILE_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "sim.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Number of register addresses */
+#define SIM_REGFILE_NBR			256
+/** @brief Register ignores writes */
+#define SIM_REGFILE_RO			0x01
+/** @brief Register increments after it is read */
+#define SIM_REGFILE_COUNTER		0x02
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief Register file model */
+typedef struct
+{
+	simDevice_t dev;						/**< Device on the bus, must be first */
+	uint8_t regs[SIM_REGFILE_NBR];			/**< Register values */
+	uint8_t flags[SIM_REGFILE_NBR];			/**< SIM_REGFILE_ flags of registers */
+	uint16_t size;							/**< Number of implemented registers */
+	uint8_t ptr;							/**< Register pointer */
+	uint8_t addrPhase;						/**< Next written byte is register pointer */
+	uint32_t reads;							/**< Registers read */
+	uint32_t writes;						/**< Registers written */
+}simRegfile_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void simRegfileInit (simRegfile_t *rf, uint8_t address, uint16_t size);
+
+#endif /* SIM_REGFILE_H_ */
@@ -0,0 +1,250 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim_ssd1306.c
+* @brief	Model of SSD1306 OLED controller for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <string.h>
+#include "sim_ssd1306.h"
+
+
+/**
+* @brief     Returns length of command with its arguments
+* @param     cmd First byte of command
+* @return    Number of bytes
+*
+*/
+static uint8_t sim_ssd1306_cmd_len (uint8_t cmd)
+{
+	switch(cmd)
+	{
+		case 0x20:	/* Memory addressing mode */
+		case 0x81:	/* Contrast */
+		case 0x8D:	/* Charge pump */
+		case 0xA8:	/* Multiplex ratio */
+		case 0xD3:	/* Display offset */
+		case 0xD5:	/* Clock divide */
+		case 0xD9:	/* Pre-charge period */
+		case 0xDA:	/* COM pins */
+		case 0xDB:	/* VCOMH level */
+			return 2;
+		case 0x21:	/* Column address */
+		case 0x22:	/* Page address */
+		case 0xA3:	/* Vertical scroll area */
+			return 3;
+		case 0x29:	/* Vertical and horizontal scroll */
+		case 0x2A:
+			return 6;
+		case 0x26:	/* Horizontal scroll */
+		case 0x27:
+			return 7;
+		default:
+			return 1;
+	}
+}
+
+/**
+* @brief     Executes received command
+* @param     disp Display model
+*
+*/
+static void sim_ssd1306_cmd (simSsd1306_t *disp)
+{
+	const uint8_t *cmd = disp->cmd;
+	
+	disp->cmds++;
+	if(disp->memMode == 2)
+	{
+		/* Pointer commands of page addressing mode */
+		if(cmd[0] <= 0x0F)
+		{
+			disp->col = (disp->col & 0xF0) | cmd[0];
+			return;
+		}
+		if(cmd[0] <= 0x1F)
+		{
+			disp->col = (disp->col & 0x0F) | ((cmd[0] & 0x07) << 4);
+			return;
+		}
+		if((cmd[0] >= 0xB0) && (cmd[0] <= 0xB7))
+		{
+			disp->page = cmd[0] & 0x07;
+			return;
+		}
+	}
+	
+	switch(cmd[0])
+	{
+		case 0x20:
+			disp->memMode = cmd[1] & 0x03;
+			break;
+		case 0x21:
+			disp->colStart = cmd[1] & 0x7F;
+			disp->colEnd = cmd[2] & 0x7F;
+			disp->col = disp->colStart;
+			break;
+		case 0x22:
+			disp->pageStart = cmd[1] & 0x07;
+			disp->pageEnd = cmd[2] & 0x07;
+			disp->page = disp->pageStart;
+			break;
+		case 0x81:
+			disp->contrast = cmd[1];
+			break;
+		case 0x8D:
+			disp->chargePump = (cmd[1] & 0x04) != 0;
+			break;
+		case 0xAE:
+			disp->on = 0;
+			break;
+		case 0xAF:
+			disp->on = 1;
+			break;
+		default:
+			if((cmd[0] <= 0x1F) || ((cmd[0] >= 0xB0) && (cmd[0] <= 0xB7)) ||
+			   ((cmd[0] >= 0x40) && (cmd[0] <= 0x7F)) || ((cmd[0] >= 0xA0) && (cmd[0] <= 0xA8)) ||
+			   ((cmd[0] & 0xF7) == 0xC0) || (cmd[0] >= 0xD3) || (cmd[0] == 0x2E) || (cmd[0] == 0x2F) ||
+			   (cmd[0] == 0x26) || (cmd[0] == 0x27) || (cmd[0] == 0x29) || (cmd[0] == 0x2A))
+			{
+				/* Settings without effect on RAM */
+				break;
+			}
+			disp->errors++;
+			break;
+	}
+}
+
+/**
+* @brief     Writes byte to RAM and moves pointer
+* @param     disp Display model
+* @param     data Pixel column of 8 rows
+*
+*/
+static void sim_ssd1306_data (simSsd1306_t *disp, uint8_t data)
+{
+	disp->ram[disp->page][disp->col] = data;
+	disp->dataBytes++;
+	
+	switch(disp->memMode)
+	{
+		case 0:
+			if(disp->col++ >= disp->colEnd)
+			{
+				disp->col = disp->colStart;
+				disp->page = (disp->page >= disp->pageEnd) ? disp->pageStart : (disp->page + 1);
+			}
+			break;
+		case 1:
+			if(disp->page++ >= disp->pageEnd)
+			{
+				disp->page = disp->pageStart;
+				disp->col = (disp->col >= disp->colEnd) ? disp->colStart : (disp->col + 1);
+			}
+			break;
+		default:
+			disp->col = (disp->col + 1) % SIM_SSD1306_WIDTH;
+			break;
+	}
+}
+
+static uint8_t sim_ssd1306_start (simDevice_t *dev, uint8_t read)
+{
+	simSsd1306_t *disp = (simSsd1306_t *)dev;
+	
+	disp->ctrl = 1;
+	disp->cmdLen = 0;
+	return !read;
+}
+
+static uint8_t sim_ssd1306_write (simDevice_t *dev, uint8_t data)
+{
+	simSsd1306_t *disp = (simSsd1306_t *)dev;
+	
+	if(disp->ctrl)
+	{
+		if(data & 0x3F)
+		{
+			disp->errors++;
+		}
+		disp->single = (data & 0x80) != 0;
+		disp->data = (data & 0x40) != 0;
+		disp->ctrl = 0;
+		return 1;
+	}
+	
+	/* After Co set, only one byte follows, then another control byte */
+	disp->ctrl = disp->single;
+	if(disp->data)
+	{
+		sim_ssd1306_data(disp, data);
+		return 1;
+	}
+	
+	if(!disp->cmdLen)
+	{
+		disp->cmdNeed = sim_ssd1306_cmd_len(data);
+	}
+	disp->cmd[disp->cmdLen++] = data;
+	if(disp->cmdLen == disp->cmdNeed)
+	{
+		sim_ssd1306_cmd(disp);
+		disp->cmdLen = 0;
+	}
+	return 1;
+}
+
+static uint8_t sim_ssd1306_read (simDevice_t *dev)
+{
+	(void)dev;
+	return 0xFF;
+}
+
+static void sim_ssd1306_stop (simDevice_t *dev)
+{
+	simSsd1306_t *disp = (simSsd1306_t *)dev;
+	
+	if(disp->cmdLen)
+	{
+		/* Command must not be split between transfers */
+		disp->errors++;
+		disp->cmdLen = 0;
+	}
+}
+
+/**
+* @brief     Initializes display model in its reset state
+* @param     disp Display model
+* @param     address 7 bit slave address
+*
+*/
+void simSsd1306Init (simSsd1306_t *disp, uint8_t address)
+{
+	memset(disp, 0, sizeof(*disp));
+	disp->dev.address = address;
+	disp->dev.start = sim_ssd1306_start;
+	disp->dev.write = sim_ssd1306_write;
+	disp->dev.read = sim_ssd1306_read;
+	disp->dev.stop = sim_ssd1306_stop;
+	disp->contrast = 0x7F;
+	disp->memMode = 2;
+	disp->colEnd = SIM_SSD1306_WIDTH - 1;
+	disp->pageEnd = SIM_SSD1306_PAGES - 1;
+}
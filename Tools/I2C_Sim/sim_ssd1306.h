@@ -0,0 +1,83 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+/**
+* @file		sim_ssd1306.h
+* @brief	Model of SSD1306 OLED controller for I2C simulator.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Model parses control bytes (Co and D/C# bits), commands with their arguments and
+* display data. Horizontal, vertical and page addressing modes move the RAM pointer
+* inside the column and page window, as the controller does. Reads are not
+* acknowledged, SSD1306 can not be read over I2C.
+*/
+
+#ifndef SIM_SSD1306_H_
+#define SIM_SSD1306_H_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+#include "sim.h"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define SIM_SSD1306_WIDTH	128
+#define SIM_SSD1306_PAGES	8
+/** @brief Longest command with arguments */
+#define SIM_SSD1306_CMD_MAX	8
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+
+/** @brief SSD1306 model */
+typedef struct
+{
+	simDevice_t dev;							/**< Device on the bus, must be first */
+	uint8_t ram[SIM_SSD1306_PAGES][SIM_SSD1306_WIDTH];	/**< Display RAM */
+	uint8_t on;									/**< Display is on */
+	uint8_t chargePump;							/**< Charge pump is enabled */
+	uint8_t contrast;							/**< Contrast */
+	uint8_t memMode;							/**< 0 horizontal, 1 vertical, 2 page addressing */
+	uint8_t colStart;							/**< First column of window */
+	uint8_t colEnd;								/**< Last column of window */
+	uint8_t pageStart;							/**< First page of window */
+	uint8_t pageEnd;							/**< Last page of window */
+	uint8_t col;								/**< Column of RAM pointer */
+	uint8_t page;								/**< Page of RAM pointer */
+	uint8_t ctrl;								/**< Next byte is control byte */
+	uint8_t single;								/**< Only one byte follows control byte (Co set) */
+	uint8_t data;								/**< Bytes after control byte are data (D/C# set) */
+	uint8_t cmd[SIM_SSD1306_CMD_MAX];			/**< Command being received */
+	uint8_t cmdLen;								/**< Received bytes of command */
+	uint8_t cmdNeed;							/**< Length of command with arguments */
+	uint32_t cmds;								/**< Executed commands */
+	uint32_t dataBytes;							/**< Bytes written to RAM */
+	uint32_t errors;							/**< Unknown commands and protocol errors */
+}simSsd1306_t;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void simSsd1306Init (simSsd1306_t *disp, uint8_t address);
+
+#endif /* SIM_SSD1306_H_ */
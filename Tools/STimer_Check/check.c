@@ -0,0 +1,222 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		check.c
+* @brief	Host checks of STimer internals.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* STimer.c is included, so its static functions are called directly on its wheel.
+* Peripherals are kept in host memory and do not run, checks move time of wheel
+* and counters by hand. Program returns 1 if any check fails, so it can be used as a regression
+* test.
+*/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdio.h>
+#include "STimer.c"
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** @brief Last slot of the top level of wheel */
+#define CHECK_TOP_LAST		(STIMER_WHEEL_LEVELS * STIMER_WHEEL_SLOTS - 1)
+/** @brief Shift of the top level of wheel */
+#define CHECK_TOP_SHIFT		((STIMER_WHEEL_LEVELS - 1) * STIMER_WHEEL_BITS)
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+Gclk checkGclk;
+Pm checkPm;
+Rtc checkRtc;
+Tc checkTc[3];
+SCB_Type checkScb;
+static uint8_t checkFailed;
+/** @brief RTC ticks added by the next sleep */
+static uint32_t checkSleepTicks;
+
+
+/**
+* @brief     Interrupts do not run on the host
+*
+*/
+void NVIC_EnableIRQ (IRQn_Type irq) { (void)irq; }
+void NVIC_SetPendingIRQ (IRQn_Type irq) { (void)irq; }
+void NVIC_ClearPendingIRQ (IRQn_Type irq) { (void)irq; }
+void NVIC_SetPriority (IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+void system_interrupt_enter_critical_section (void) {}
+void system_interrupt_leave_critical_section (void) {}
+
+/**
+* @brief     Sleep, RTC counts on while TC3 and TC4 are stopped
+*
+*/
+void __WFI (void)
+{
+	RTC->MODE0.COUNT.reg += checkSleepTicks;
+	checkSleepTicks = 0;
+}
+
+/**
+* @brief     Reports a failed check
+* @param     name Name of check
+* @param     ok Result of check
+*
+*/
+static void check_expect (const char *name, uint8_t ok)
+{
+	printf("%-4s  %s\n", ok ? "ok" : "FAIL", name);
+	if(!ok)
+	{
+		checkFailed = 1;
+	}
+}
+
+/**
+* @brief     Tells, if timer is linked in a slot of wheel
+* @param     wheel Wheel
+* @param     slot Slot
+* @param     tmr Timer
+* @return    1 if timer is in the slot
+*
+*/
+static uint8_t check_linked (stimer_wheel_t *wheel, uint16_t slot, stimer_t *tmr)
+{
+	stimer_t *n;
+
+	for(n = wheel->slot[slot]; n; n = n->next)
+	{
+		if(n == tmr)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+* @brief     Timers out of reach, placed in the last slot of the top level
+*
+* Right after boot the farthest slot is the last slot of the top level. Its index is
+* the largest one, so it must not be taken as a timer, which is not in wheel.
+*
+*/
+static void check_top_last_slot (void)
+{
+	stimer_wheel_t *wheel = &stimerTc;
+	stimer_t *a = &stimerPool[0];
+	stimer_t *b = &stimerPool[1];
+	uint16_t steps;
+
+	memset(wheel, 0, sizeof(*wheel));
+	a->slot = STIMER_NONE;
+	b->slot = STIMER_NONE;
+	a->expires = 1UL << 25;
+	b->expires = 1UL << 25;
+	stimer_place(a);
+	stimer_place(b);
+	check_expect("out of reach timer in last slot of top level",
+				 (a->slot == CHECK_TOP_LAST) && check_linked(wheel, CHECK_TOP_LAST, a));
+	check_expect("timer in last slot is in wheel", a->slot != STIMER_NONE);
+
+	/* Stop */
+	stimer_unplace(a);
+	check_expect("stopped timer is unlinked", (a->slot == STIMER_NONE) && !check_linked(wheel, CHECK_TOP_LAST, a));
+	check_expect("other timer stays linked", check_linked(wheel, CHECK_TOP_LAST, b) && !b->prev);
+	check_expect("count of top level after stop", wheel->levelCnt[STIMER_WHEEL_LEVELS - 1] == 1);
+
+	/* Wheel reaches the slot, remaining timer is cascaded to the new farthest slot */
+	wheel->ms = (uint32_t)(STIMER_WHEEL_SLOTS - 1) << CHECK_TOP_SHIFT;
+	wheel->now = wheel->ms;
+	stimer_cascade(wheel, CHECK_TOP_LAST);
+	check_expect("cascaded slot is empty", !wheel->slot[CHECK_TOP_LAST]);
+	check_expect("cascaded timer in farthest slot",
+				 (b->slot == CHECK_TOP_LAST - 1) && check_linked(wheel, CHECK_TOP_LAST - 1, b));
+	check_expect("count of top level after cascade", wheel->levelCnt[STIMER_WHEEL_LEVELS - 1] == 1);
+
+	/* Wheel moves on to slots of the remaining timer, until it goes down a level */
+	for(steps = 0; (steps < STIMER_WHEEL_SLOTS) && (b->slot >= (STIMER_WHEEL_LEVELS - 1) * STIMER_WHEEL_SLOTS); steps++)
+	{
+		do
+		{
+			wheel->ms += 1UL << CHECK_TOP_SHIFT;
+		}
+		while(((wheel->ms >> CHECK_TOP_SHIFT) & (STIMER_WHEEL_SLOTS - 1)) != (b->slot & (STIMER_WHEEL_SLOTS - 1)));
+		stimer_cascade(wheel, b->slot);
+	}
+	check_expect("cascaded timer reaches lower level", b->slot < (STIMER_WHEEL_LEVELS - 1) * STIMER_WHEEL_SLOTS);
+	check_expect("stopped timer stays unlinked", a->slot == STIMER_NONE);
+	stimer_unplace(b);
+	check_expect("wheel is empty", !wheel->levelCnt[0] && !wheel->levelCnt[1] && !wheel->levelCnt[2] &&
+				 !wheel->levelCnt[3]);
+}
+
+/**
+* @brief     Sleep in STANDBY moves ms and us clocks by the slept time
+*
+* Microsecond clock is close to its wrap, so slept time also carries into its upper
+* word.
+*
+*/
+static void check_sleep_clocks (void)
+{
+	stimerUsWatch_t watch;
+	uint64_t ms, us;
+
+	memset(&stimerTc, 0, sizeof(stimerTc));
+	stimerUsCallback = 0;
+	stimerUsHi = 0;
+	stimerUsLast = 0xFFF00000UL;
+	TC4->COUNT32.COUNT.reg = 0xFFF00000UL + 1000;
+	RTC->MODE0.COUNT.reg = 0;
+
+	ms = stimerUptimeMs();
+	us = stimerUptimeUs();
+	stimerUsWatchReset(&watch);
+	stimerUsWatchStart(&watch);
+
+	/* 10 s in STANDBY */
+	checkSleepTicks = 10 * 1024;
+	stimerSleep();
+	check_expect("sleep is over", !(SCB->SCR & SCB_SCR_SLEEPDEEP_Msk) && !checkSleepTicks);
+	check_expect("ms uptime moved by sleep", (stimerUptimeMs() - ms) == 10000);
+	check_expect("us uptime moved by sleep", (stimerUptimeUs() - us) == 10000000ULL);
+	check_expect("us clock moved by sleep", (uint32_t)(stimerNowUs() - (uint32_t)us) == 10000000UL);
+	check_expect("us stopwatch moved by sleep", stimerUsWatchGet(&watch) == 10000000UL);
+	check_expect("us uptime carried into upper word", (stimerUptimeUs() >> 32) == 1);
+
+	/* TC3 and TC4 count on from where they stopped */
+	TC3->COUNT16.COUNT.reg += STIMER_TICKS_PER_MS;
+	TC4->COUNT32.COUNT.reg += 1000;
+	stimer_advance(1);
+	check_expect("ms uptime after sleep counts on", (stimerUptimeMs() - ms) == 10001);
+	check_expect("us uptime after sleep counts on", (stimerUptimeUs() - us) == 10001000ULL);
+}
+
+int main (void)
+{
+	check_top_last_slot();
+	check_sleep_clocks();
+
+	printf("\n%s\n", checkFailed ? "FAILED" : "PASSED");
+	return checkFailed;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		samd21.h
+* @brief	Host replacement of device header for STimer check.
+* @date		19.10.2026
+* @version	0.1
+*
+* @details
+* Register layouts and bit definitions are taken from the real component headers
+* of ASF. Peripherals used by STimer are placed in host memory, they do not run.
+* __WFI is given by the check, so it can move RTC by the time of a sleep.
+*/
+
+#ifndef _SAMD21_
+#define _SAMD21_
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include <stdint.h>
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+#define __I		volatile const
+#define __O		volatile
+#define __IO	volatile
+
+#define SCB_ICSR_PENDSVSET_Msk		(1UL << 28)
+#define SCB_SCR_SLEEPDEEP_Msk		(1UL << 2)
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+typedef volatile const uint32_t RoReg;
+typedef volatile const uint16_t RoReg16;
+typedef volatile const uint8_t  RoReg8;
+typedef volatile       uint32_t WoReg;
+typedef volatile       uint16_t WoReg16;
+typedef volatile       uint8_t  WoReg8;
+typedef volatile       uint32_t RwReg;
+typedef volatile       uint16_t RwReg16;
+typedef volatile       uint8_t  RwReg8;
+
+/** @brief Interrupt numbers, same as on SAMD21G18A */
+typedef enum IRQn
+{
+	PendSV_IRQn			= -2,
+	RTC_IRQn			=  3,
+	TC3_IRQn			= 18,
+	TC4_IRQn			= 19,
+	TC5_IRQn			= 20
+}IRQn_Type;
+
+/** @brief System control block registers used by STimer */
+typedef struct
+{
+	volatile uint32_t ICSR;
+	volatile uint32_t SCR;
+}SCB_Type;
+
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "component/gclk.h"
+#include "component/pm.h"
+#include "component/rtc.h"
+#include "component/tc.h"
+
+
+/****************************************************************************************
+* Global variables
+****************************************************************************************/
+extern Gclk checkGclk;
+extern Pm checkPm;
+extern Rtc checkRtc;
+extern Tc checkTc[3];
+extern SCB_Type checkScb;
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void NVIC_EnableIRQ (IRQn_Type irq);
+void NVIC_SetPendingIRQ (IRQn_Type irq);
+void NVIC_ClearPendingIRQ (IRQn_Type irq);
+void NVIC_SetPriority (IRQn_Type irq, uint32_t priority);
+void __WFI (void);
+
+static inline void __DSB (void) {}
+static inline void __enable_irq (void) {}
+
+
+/****************************************************************************************
+* Peripherals
+****************************************************************************************/
+#define GCLK		(&checkGclk)
+#define PM			(&checkPm)
+#define RTC			(&checkRtc)
+#define TC3			(&checkTc[0])
+#define TC4			(&checkTc[1])
+#define TC5			(&checkTc[2])
+#define SCB			(&checkScb)
+
+#endif /* _SAMD21_ */
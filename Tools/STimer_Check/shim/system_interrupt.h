@@ -0,0 +1,32 @@
+/****************************************************************************************
+*  _____ _                    _        													*
+* / ____(_)                  | |														*
+*| (___  ___      _____  _ __| | _____													*
+* \___ \| \ \ /\ / / _ \| '__| |/ / __|													*
+* ____) | |\ V  V / (_) | |  |   <\__ \													*
+*|_____/|_| \_/\_/ \___/|_|  |_|\_\___/													*
+*																						*
+*	ProjectName Firmware																*
+*	Copyright (c) 2019, Siworks, All rights reserved.									*
+*																						*
+****************************************************************************************/
+
+
+
+/**
+* @file		system_interrupt.h
+* @brief	Host replacement of ASF interrupt driver for STimer check.
+* @date		19.10.2026
+* @version	0.1
+*/
+
+#ifndef SYSTEM_INTERRUPT_H_INCLUDED
+#define SYSTEM_INTERRUPT_H_INCLUDED
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+void system_interrupt_enter_critical_section (void);
+void system_interrupt_leave_critical_section (void);
+
+#endif /* SYSTEM_INTERRUPT_H_INCLUDED */